@@ -1,6 +1,7 @@
 #include "DiscogsInfoSources.h"
 
 #include <tuple>
+#include <QDataStream>
 #include <QTime>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -46,7 +47,7 @@ QStringList DiscogsArtistInfo::matchedTypes()
 
 int DiscogsArtistInfo::significance(const QString &, const QString &strTrackArtist, const QString &, int) const
 {
-    int i_significance = std::max(s_iMaxTolerableMatchingDifference - matchArtist(strTrackArtist),0);
+    int i_significance = std::max(s_iMaxTolerableMatchingDifference - matchArtist( strTrackArtist, s_iMaxTolerableMatchingDifference ),0);
     i_significance += m_iDataQuality*(!m_lstGenres.empty());
     return i_significance;
 }
@@ -54,7 +55,7 @@ int DiscogsArtistInfo::significance(const QString &, const QString &strTrackArti
 bool DiscogsArtistInfo::perfectMatch(const QString &strAlbumTitle, const QString &strTrackArtist, const QString &strTrackTitle, int iMaxDistance) const
 {
     return strAlbumTitle.isEmpty() && strTrackTitle.isEmpty() && 
-            ( strTrackArtist.isEmpty() || matchArtist(strTrackArtist) <= iMaxDistance );
+            ( strTrackArtist.isEmpty() || matchArtist( strTrackArtist, iMaxDistance ) <= iMaxDistance );
 }
 
 
@@ -75,9 +76,9 @@ QStringList DiscogsAlbumInfo::matchedTypes()
 
 int DiscogsAlbumInfo::significance(const QString &strAlbumTitle, const QString &strTrackArtist, const QString &strTrackTitle, int iYear ) const
 {
-    int i_significance = std::max(s_iMaxTolerableMatchingDifference - matchAlbum( strAlbumTitle ),0);
-    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchArtist(strTrackArtist),0);
-    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchTrackTitle(strTrackTitle),0);
+    int i_significance = std::max(s_iMaxTolerableMatchingDifference - matchAlbum( strAlbumTitle, s_iMaxTolerableMatchingDifference ),0);
+    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchArtist( strTrackArtist, s_iMaxTolerableMatchingDifference ),0);
+    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchTrackTitle( strTrackTitle, s_iMaxTolerableMatchingDifference ),0);
     i_significance += m_iDataQuality*(!m_lstGenres.empty()+!m_strCover.isEmpty()+!m_strYear.isEmpty());
     i_significance += 2*std::max(0,(s_iMaxTolerableYearDifference-std::abs(m_strYear.toInt()-iYear)));
     return i_significance;
@@ -90,9 +91,9 @@ void DiscogsAlbumInfo::setCover(QString strCover)
 
 bool DiscogsAlbumInfo::perfectMatch(const QString &strAlbumTitle, const QString &strTrackArtist, const QString &strTrackTitle, int iMaxDistance) const
 {
-    return ( strAlbumTitle.isEmpty() || matchAlbum(strAlbumTitle) <= iMaxDistance ) 
-            && ( strTrackArtist.isEmpty() || matchArtist(strTrackArtist) <= iMaxDistance )
-            && ( strTrackTitle.isEmpty() || matchTrackTitle(strTrackTitle) <= iMaxDistance );
+    return ( strAlbumTitle.isEmpty() || matchAlbum( strAlbumTitle, iMaxDistance ) <= iMaxDistance ) 
+            && ( strTrackArtist.isEmpty() || matchArtist( strTrackArtist, iMaxDistance ) <= iMaxDistance )
+            && ( strTrackTitle.isEmpty() || matchTrackTitle( strTrackTitle, iMaxDistance ) <= iMaxDistance );
 }
 
 const QString& DiscogsAlbumInfo::getTitle(size_t uiIndex) const
@@ -250,3 +251,66 @@ void DiscogsAlbumInfo::setValues(const QJsonObject &rclDoc)
         std::get<LengthIndex>(m_vecDiscTrackLength.back()) = stringToDuration(cl_track["duration"].toString().trimmed());
     }
 }
+
+void DiscogsInfoSource::writeValues( QDataStream& rclStream ) const
+{
+    rclStream << m_strURL << m_lstGenres << static_cast<qint32>(m_iDataQuality) << static_cast<qint32>(m_iId);
+}
+
+void DiscogsInfoSource::readValues( QDataStream& rclStream )
+{
+    qint32 i_data_quality = 0, i_id = 0;
+    rclStream >> m_strURL >> m_lstGenres >> i_data_quality >> i_id;
+    m_iDataQuality = i_data_quality;
+    m_iId = i_id;
+}
+
+void DiscogsArtistInfo::save( QDataStream& rclStream ) const
+{
+    writeType( rclStream, Type::DiscogsArtistInfo );
+    writeValues( rclStream );
+}
+
+void DiscogsArtistInfo::writeValues( QDataStream& rclStream ) const
+{
+    DiscogsInfoSource::writeValues( rclStream );
+    rclStream << m_strArtist;
+}
+
+void DiscogsArtistInfo::readValues( QDataStream& rclStream )
+{
+    DiscogsInfoSource::readValues( rclStream );
+    rclStream >> m_strArtist;
+}
+
+void DiscogsAlbumInfo::save( QDataStream& rclStream ) const
+{
+    writeType( rclStream, Type::DiscogsAlbumInfo );
+    writeValues( rclStream );
+}
+
+void DiscogsAlbumInfo::writeValues( QDataStream& rclStream ) const
+{
+    DiscogsInfoSource::writeValues( rclStream );
+    rclStream << m_strCover << m_strYear << m_strAlbumArtist << m_lstAlbums << m_lstTitles << m_lstArtists;
+    rclStream << static_cast<quint32>( m_vecDiscTrackLength.size() );
+    for ( const auto& rcl_disc_track_length : m_vecDiscTrackLength )
+        rclStream << static_cast<quint32>( std::get<DiscIndex>(rcl_disc_track_length) )
+                  << static_cast<quint32>( std::get<TrackIndex>(rcl_disc_track_length) )
+                  << static_cast<quint32>( std::get<LengthIndex>(rcl_disc_track_length) );
+}
+
+void DiscogsAlbumInfo::readValues( QDataStream& rclStream )
+{
+    DiscogsInfoSource::readValues( rclStream );
+    rclStream >> m_strCover >> m_strYear >> m_strAlbumArtist >> m_lstAlbums >> m_lstTitles >> m_lstArtists;
+    quint32 ui_num_tracks = 0;
+    rclStream >> ui_num_tracks;
+    m_vecDiscTrackLength.clear();
+    for ( quint32 ui_track = 0; ui_track < ui_num_tracks && rclStream.status() == QDataStream::Ok; ++ui_track )
+    {
+        quint32 ui_disc = 0, ui_track_number = 0, ui_length = 0;
+        rclStream >> ui_disc >> ui_track_number >> ui_length;
+        m_vecDiscTrackLength.emplace_back( ui_disc, ui_track_number, ui_length );
+    }
+}
@@ -22,8 +22,11 @@ public:
     static std::unique_ptr<DiscogsInfoSource> createForType( const QString& strType, const QJsonDocument& rclDoc );
     
     virtual bool perfectMatch( const QString& strAlbumTitle, const QString& strTrackArtist, const QString& strTrackTitle, int iMaxDistance = 2 ) const = 0;
+    
+    void readValues( QDataStream& rclStream ) override;
 protected:
     virtual void setValues( const QJsonObject& rclDoc );
+    virtual void writeValues( QDataStream& rclStream ) const;
     
     QString     m_strURL;
     QStringList m_lstGenres;
@@ -45,8 +48,12 @@ public:
     int significance(const QString &strAlbumTitle, const QString &strTrackArtist, const QString &strTrackTitle, int iYear) const override;
     
     bool perfectMatch( const QString& strAlbumTitle, const QString& strTrackArtist, const QString& strTrackTitle, int iMaxDistance ) const override;
+    
+    void save( QDataStream& rclStream ) const override;
+    void readValues( QDataStream& rclStream ) override;
 protected:
     void setValues( const QJsonObject& rclDoc ) override;
+    void writeValues( QDataStream& rclStream ) const override;
     QString m_strArtist;
 };
 
@@ -74,8 +81,12 @@ public:
     void setCover( QString strCover );
     
     bool perfectMatch( const QString& strAlbumTitle, const QString& strTrackArtist, const QString& strTrackTitle, int iMaxDistance ) const override;
+    
+    void save( QDataStream& rclStream ) const override;
+    void readValues( QDataStream& rclStream ) override;
 protected:
     void setValues( const QJsonObject& rclDoc ) override;
+    void writeValues( QDataStream& rclStream ) const override;
     
     static QString m_strEmpty;
     QString m_strCover, m_strYear, m_strAlbumArtist;
@@ -4,55 +4,71 @@
 #include <QJsonDocument>
 #include <QRegularExpression>
 #include <QIcon>
+#include <QStandardPaths>
 #include "DiscogsInfoSources.h"
-#include <Tools/CoverDownloader.h>
+
+// tags search requests with the value of m_iSearchGeneration at the time they were sent
+static const QNetworkRequest::Attribute s_eSearchGenerationAttribute = QNetworkRequest::User;
 
 DiscogsParser::DiscogsParser(QNetworkAccessManager *pclNetworkAccess, QObject *pclParent)
 : OnlineSourceParser(pclNetworkAccess,pclParent)
 , m_lruSearchResults(10000)
 , m_lruContent(1000)
 , m_lruCoverURLs(10000)
+, m_pclStoredResults( PersistentResultStore::forDirectory( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + "/parsed_results" ) )
 , m_pclIcon( std::make_unique<QIcon>() )
 {
     downloadFavicon(pclNetworkAccess);
 }
 
-DiscogsParser::~DiscogsParser() = default;
+DiscogsParser::~DiscogsParser()
+{
+    stopParserThreads();
+}
+
+void DiscogsParser::setMaxSearchQueriesInFlight( int iMaxQueries )
+{
+    m_iMaxSearchQueriesInFlight = std::max( iMaxQueries, 1 );
+}
 
 void DiscogsParser::getNextSearchResultFromCacheOrSendQuery()
 {
     bool b_no_queries_required = true;
-    while ( !m_lstOpenSearchQueries.empty() )
+    SearchQuery cl_query;
+    // keep several search queries underway at once, instead of waiting for each reply before sending the next
+    while ( m_iSearchQueriesInFlight < m_iMaxSearchQueriesInFlight && takeNextSearchQuery( cl_query ) )
     {
         QString str_query, str_type;
-        std::tie(str_query,str_type) = std::move(m_lstOpenSearchQueries.front());
-        m_lstOpenSearchQueries.pop_front();
+        std::tie(str_query,str_type) = std::move(cl_query);
     
         str_query = QUrl::toPercentEncoding( str_query );
                 
         // look in LRU for search query
-        int* pi_id = m_lruSearchResults[SearchQuery(str_query,str_type)];
-        if ( pi_id != nullptr )
+        std::optional<int> pi_id = m_lruSearchResults.object(SearchQuery(str_query,str_type));
+        if ( !pi_id && ( pi_id = m_pclStoredResults->object<qint32>( QString("discogs/search/%1/%2").arg(str_type,str_query) ) ) )
+            m_lruSearchResults.insert( SearchQuery(str_query,str_type), *pi_id );
+        if ( pi_id )
         {
             if ( *pi_id != 0 ) // check if cached search turned up any valid results
                 // use cached search result
-                b_no_queries_required &= getContentFromCacheAndQueryMissing( *pi_id, str_type+"s" );
+                b_no_queries_required &= getContentFromCacheAndQueryMissing( *pi_id, str_type+"s", m_clQuery );
         }
         else
         {
+            ++m_iSearchQueriesInFlight;
             sendSearchRequest(str_query, str_type);
-            return;
+            b_no_queries_required = false;
         }
     }
-    if ( b_no_queries_required )
+    if ( b_no_queries_required && m_iSearchQueriesInFlight == 0 )
         emit parsingFinished( getPages() );
 }
 
-bool DiscogsParser::getContentFromCacheAndQueryMissing(int iID, const QString &strType)
+bool DiscogsParser::getContentFromCacheAndQueryMissing(int iID, const QString &strType, const Query& rclQuery)
 {
-    SourcePtr* pcl_source = m_lruContent[ContentId(iID,strType)];
-    if ( pcl_source != nullptr )
-        return !(*pcl_source) || addParsedContent(*pcl_source,strType);
+    std::optional<SourcePtr> pcl_source = getCachedContent(iID,strType);
+    if ( pcl_source )
+        return !(*pcl_source) || addParsedContent(*pcl_source,strType,rclQuery);
     
     sendContentRequest( iID, strType );
     return false;
@@ -60,8 +76,10 @@ bool DiscogsParser::getContentFromCacheAndQueryMissing(int iID, const QString &s
 
 bool DiscogsParser::getCoverURLFromCacheAndQueryMissing(int iID, const QString &strType)
 {
-    QString* str_cover_url = m_lruCoverURLs[iID];
-    if ( str_cover_url != nullptr )
+    std::optional<QString> str_cover_url = m_lruCoverURLs.object(iID);
+    if ( !str_cover_url && ( str_cover_url = m_pclStoredResults->object<QString>( QString("discogs/cover/%1").arg(iID) ) ) )
+        m_lruCoverURLs.insert( iID, *str_cover_url );
+    if ( str_cover_url )
     {
         addCoverURLToSource( iID, *str_cover_url );
         return true;
@@ -76,6 +94,7 @@ void DiscogsParser::sendSearchRequest( const QString& strQuery, const QString& s
     
     QNetworkRequest cl_request(QUrl(QString("https://www.discogs.com/search/?q=%1&type=%2").arg( strQuery, strType )));
     cl_request.setRawHeader( "User-Agent", "TagSupporter/1.0 (https://hoov.de; coke@hoov.de) BasedOnQt/5" );
+    cl_request.setAttribute( s_eSearchGenerationAttribute, m_iSearchGeneration );
     emit sendQuery( cl_request, SLOT(searchReplyReceived()) );
 }
 
@@ -98,10 +117,12 @@ void DiscogsParser::sendRequests( const QString& trackArtist, const QString& tra
 {
     clearResults();
     
-    m_strAlbumTitle  = albumTitle;
-    m_strTrackTitle  = trackTitle;
-    m_strTrackArtist = trackArtist;
-    m_iYear          = iYear;
+    m_clQuery.strAlbumTitle  = albumTitle;
+    m_clQuery.strTrackTitle  = trackTitle;
+    m_clQuery.strTrackArtist = trackArtist;
+    m_clQuery.iYear          = iYear;
+    
+    QMutexLocker cl_lock( &m_clOpenSearchQueriesMutex );
     
     // create a list of seach queries for releases
     QStringList lst_release_queries;
@@ -123,6 +144,8 @@ void DiscogsParser::sendRequests( const QString& trackArtist, const QString& tra
             m_lstOpenSearchQueries.emplace_front( trackArtist+" "+str_query, "release" );
     }
             
+    cl_lock.unlock();
+    
     // start by sending out the first search request in the list
     getNextSearchResultFromCacheOrSendQuery();
 }
@@ -130,23 +153,24 @@ void DiscogsParser::sendRequests( const QString& trackArtist, const QString& tra
 void DiscogsParser::clearResults()
 {
     m_mapParsedInfos.clear();
-    m_strAlbumTitle.clear();
-    m_strTrackTitle.clear();
-    m_strTrackArtist.clear();
-    m_lstOpenSearchQueries.clear();
-    m_iYear = -1;
+    m_clQuery = Query();
+    clearOpenSearchQueries();
     
     //cancel any pending requests
     emit cancelAllPendingNetworkRequests();
+    // the scheduler drops queued requests without a reply, and search requests may still be on their way to it
+    ++m_iSearchGeneration;
+    m_iSearchQueriesInFlight = 0;
 }
 
 QStringList DiscogsParser::getPages() const
 {
     // get pages, sorted by significance
+    auto map_parsed_infos = m_mapParsedInfos.snapshot();
     std::vector<std::pair<int,QString>> lst_pages_with_significance;
-    lst_pages_with_significance.reserve( m_mapParsedInfos.size() );
-    for ( const auto & rcl_item : m_mapParsedInfos )
-        lst_pages_with_significance.emplace_back( rcl_item.second->significance(m_strAlbumTitle,m_strTrackArtist,m_strTrackTitle,m_iYear), rcl_item.second->title() );
+    lst_pages_with_significance.reserve( map_parsed_infos->size() );
+    for ( const auto & rcl_item : *map_parsed_infos )
+        lst_pages_with_significance.emplace_back( rcl_item.second->significance(m_clQuery.strAlbumTitle,m_clQuery.strTrackArtist,m_clQuery.strTrackTitle,m_clQuery.iYear), rcl_item.second->title() );
     std::sort( lst_pages_with_significance.begin(), lst_pages_with_significance.end() );
     QStringList lst_pages;
     for ( auto it_item = lst_pages_with_significance.rbegin(); it_item != lst_pages_with_significance.rend(); ++it_item )
@@ -156,7 +180,7 @@ QStringList DiscogsParser::getPages() const
 
 std::shared_ptr<OnlineInfoSource> DiscogsParser::getResult(const QString &strPage) const
 {
-    for ( const auto & rcl_item : m_mapParsedInfos )
+    for ( const auto & rcl_item : *m_mapParsedInfos.snapshot() )
         if ( rcl_item.second->title() == strPage )
             return rcl_item.second;
     return nullptr;
@@ -203,7 +227,7 @@ void DiscogsParser::parseFromURL(const QUrl &rclUrl)
     QString str_type;
     int i_id;
     if ( getIdAndTypeFromURL(rclUrl, str_type, i_id) )
-        getContentFromCacheAndQueryMissing( i_id, str_type+"s" );
+        getContentFromCacheAndQueryMissing( i_id, str_type+"s", m_clQuery );
     else
         emit error( QString("Network reply URL %1 could not be resolved to a known type of source").arg(rclUrl.toString()) );   
 }
@@ -227,12 +251,13 @@ void DiscogsParser::replyReceived(QNetworkReply* pclReply,FunT funAction, const
             QUrl cl_new_url = pclReply->url().resolved( cl_redirect.toUrl() );
             QNetworkRequest cl_request(cl_new_url);
             cl_request.setRawHeader( "User-Agent", "TagSupporter/1.0 (https://hoov.de; coke@hoov.de) BasedOnQt/5" );
+            cl_request.setAttribute( s_eSearchGenerationAttribute, pclReply->request().attribute( s_eSearchGenerationAttribute ) );
             emit sendQuery(cl_request, strRedirectReplySlot );
         }
         else
         {
             QUrl cl_url = pclReply->url();
-            startParserThread( pclReply->readAll(), [funAction,cl_url](QByteArray strReply){ funAction( strReply, cl_url ); } );
+            startParserThread( pclReply->readAll(), [funAction,cl_url,cl_query = m_clQuery](QByteArray strReply){ funAction( strReply, cl_url, cl_query ); } );
         }
         break;
     }
@@ -248,24 +273,47 @@ void DiscogsParser::replyReceived(QNetworkReply* pclReply,FunT funAction, const
 
 void DiscogsParser::searchReplyReceived()
 {
-   replyReceived( dynamic_cast<QNetworkReply*>( sender() ), [this](const QByteArray& rclContent, const QUrl& rclRequestUrl){ parseSearchResult(rclContent,rclRequestUrl); },
+   QNetworkReply* pcl_reply = dynamic_cast<QNetworkReply*>( sender() );
+   // a redirected query is still underway
+   bool b_redirected = pcl_reply && pcl_reply->error() == QNetworkReply::NoError && pcl_reply->attribute(QNetworkRequest::RedirectionTargetAttribute).isValid();
+   bool b_current = pcl_reply && pcl_reply->request().attribute( s_eSearchGenerationAttribute ).toInt() == m_iSearchGeneration;
+   if ( pcl_reply && !b_current )
+   {
+       // dropped by clearResults or a perfect match, so it is not parsed at all
+       pcl_reply->deleteLater();
+       return;
+   }
+   replyReceived( pcl_reply, [this](const QByteArray& rclContent, const QUrl& rclRequestUrl, const Query& rclQuery){ parseSearchResult(rclContent,rclRequestUrl,rclQuery); },
         SLOT(searchReplyReceived()));
+   if ( b_current && !b_redirected && m_iSearchQueriesInFlight > 0 )
+       --m_iSearchQueriesInFlight;
    getNextSearchResultFromCacheOrSendQuery();
 }
 
+void DiscogsParser::requestCoalesced( const QNetworkRequest& rclRequest, const QString& strReceivingSlot )
+{
+    // the search query is answered by the reply to the identical one, which counts as in flight already
+    if ( strReceivingSlot == SLOT(searchReplyReceived()) && rclRequest.attribute( s_eSearchGenerationAttribute ).toInt() == m_iSearchGeneration
+         && m_iSearchQueriesInFlight > 0 )
+    {
+        --m_iSearchQueriesInFlight;
+        getNextSearchResultFromCacheOrSendQuery();
+    }
+}
+
 void DiscogsParser::contentReplyReceived()
 {
-    replyReceived( dynamic_cast<QNetworkReply*>( sender() ), [this](const QByteArray& rclContent, const QUrl& rclRequestUrl){ parseContent(rclContent,rclRequestUrl); },
+    replyReceived( dynamic_cast<QNetworkReply*>( sender() ), [this](const QByteArray& rclContent, const QUrl& rclRequestUrl, const Query& rclQuery){ parseContent(rclContent,rclRequestUrl,rclQuery); },
         SLOT(contentReplyReceived()));
 }
 
 void DiscogsParser::imageReplyReceived()
 {
-    replyReceived( dynamic_cast<QNetworkReply*>( sender() ), [this](const QByteArray& rclContent, const QUrl& rclRequestUrl){ parseImages(rclContent,rclRequestUrl); },
+    replyReceived( dynamic_cast<QNetworkReply*>( sender() ), [this](const QByteArray& rclContent, const QUrl& rclRequestUrl, const Query&){ parseImages(rclContent,rclRequestUrl); },
         SLOT(imageReplyReceived()));
 }
 
-void DiscogsParser::parseContent( const QByteArray& rclContent, const QUrl& rclRequestUrl )
+void DiscogsParser::parseContent( const QByteArray& rclContent, const QUrl& rclRequestUrl, const Query& rclQuery )
 {
     QJsonDocument cl_doc = QJsonDocument::fromJson(rclContent);
     if ( cl_doc.isObject() )
@@ -279,10 +327,10 @@ void DiscogsParser::parseContent( const QByteArray& rclContent, const QUrl& rclR
             pcl_source = DiscogsInfoSource::createForType( str_type, cl_doc );
             
             // add parsed source to cache
-            m_lruContent.insert(ContentId(i_id,str_type), new SourcePtr(pcl_source) );
+            cacheContent( i_id, str_type, pcl_source );
             
             // add source to parsed infos map
-            if ( !pcl_source || addParsedContent( pcl_source, str_type ) )
+            if ( !pcl_source || addParsedContent( pcl_source, str_type, rclQuery ) )
                 emit parsingFinished( QStringList()<<pcl_source->title() );
         }
         else
@@ -292,13 +340,17 @@ void DiscogsParser::parseContent( const QByteArray& rclContent, const QUrl& rclR
         emit error("received an invalid JSON reply");
 }
 
-bool DiscogsParser::addParsedContent( SourcePtr pclSource, const QString& strType )
+bool DiscogsParser::addParsedContent( SourcePtr pclSource, const QString& strType, const Query& rclQuery )
 {
-    m_mapParsedInfos[pclSource->id()] = pclSource;
+    m_mapParsedInfos.modify( [&pclSource]( std::map<int,SourcePtr>& rmapInfos ) { rmapInfos[pclSource->id()] = pclSource; } );
     
     // check just HOW well the found source matches our original query...
-    if ( pclSource->perfectMatch( m_strAlbumTitle, m_strTrackArtist, m_strTrackTitle ) ) // cancel any open search queries... it doesn't get any better than this...
-        m_lstOpenSearchQueries.clear();
+    if ( pclSource->perfectMatch( rclQuery.strAlbumTitle, rclQuery.strTrackArtist, rclQuery.strTrackTitle ) ) // cancel any open search queries... it doesn't get any better than this...
+    {
+        clearOpenSearchQueries();
+        // the ones in flight are counted by the GUI thread
+        QMetaObject::invokeMethod( this, [this,cl_query = rclQuery]{ dropSearchesInFlight( cl_query ); }, Qt::QueuedConnection );
+    }
     
     auto pcl_album = std::dynamic_pointer_cast<DiscogsAlbumInfo>(pclSource);
     if ( pcl_album && pcl_album->getCover().isEmpty() )
@@ -328,7 +380,8 @@ void DiscogsParser::parseImages( const QByteArray& rclContent, const QUrl& rclRe
         if ( str_match.endsWith(".jpg", Qt::CaseInsensitive) )
         {
             // store found URL in cache
-            m_lruCoverURLs.insert( i_id, new QString(str_match) );
+            m_lruCoverURLs.insert( i_id, str_match );
+            m_pclStoredResults->insertObject( QString("discogs/cover/%1").arg(i_id), str_match );
             // and set the cover
             pcl_source = addCoverURLToSource( i_id, std::move(str_match) );
             break;
@@ -342,27 +395,58 @@ void DiscogsParser::parseImages( const QByteArray& rclContent, const QUrl& rclRe
 
 void DiscogsParser::downloadFavicon(QNetworkAccessManager *pclNetworkAccess)
 {
-    CoverDownloader* pcl_downloader = new CoverDownloader( pclNetworkAccess, this );
-    connect( pcl_downloader, &CoverDownloader::imageReady, [this,pcl_downloader]{
-        m_pclIcon = std::make_unique<QIcon>( pcl_downloader->getImage() );
-        pcl_downloader->deleteLater();
+    downloadIcon( pclNetworkAccess, QUrl("https://www.discogs.com/favicon.ico"), [this]( const QPixmap& rclIcon ) {
+        m_pclIcon = std::make_unique<QIcon>( rclIcon );
     } );
-    pcl_downloader->downloadImage( QUrl("https://www.discogs.com/favicon.ico") );
 }
 
 DiscogsParser::SourcePtr DiscogsParser::addCoverURLToSource( int iID, QString strCoverURL )
 {
-    auto it_info = m_mapParsedInfos.find( iID );
-    if ( it_info == m_mapParsedInfos.end() ) // got an image result for a nonexisting item(?!)
-        return nullptr;
-    auto pcl_album = std::dynamic_pointer_cast<DiscogsAlbumInfo>(it_info->second);
-    if ( pcl_album )
-        pcl_album->setCover(std::move(strCoverURL));
-    return pcl_album;
+    SourcePtr pcl_result;
+    m_mapParsedInfos.modify( [&]( std::map<int,SourcePtr>& rmapInfos ) {
+        auto it_info = rmapInfos.find( iID );
+        if ( it_info == rmapInfos.end() ) // got an image result for a nonexisting item(?!)
+            return;
+        auto pcl_album = std::dynamic_pointer_cast<DiscogsAlbumInfo>(it_info->second);
+        if ( pcl_album )
+        {
+            // published sources might be in use by other threads, so they are replaced by a modified copy
+            auto pcl_copy = std::make_shared<DiscogsAlbumInfo>( *pcl_album );
+            pcl_copy->setCover(std::move(strCoverURL));
+            it_info->second = pcl_result = std::move(pcl_copy);
+        }
+    } );
+    return pcl_result;
 }
 
+bool DiscogsParser::takeNextSearchQuery( SearchQuery& rclQuery )
+{
+    QMutexLocker cl_lock( &m_clOpenSearchQueriesMutex );
+    if ( m_lstOpenSearchQueries.empty() )
+        return false;
+    rclQuery = std::move(m_lstOpenSearchQueries.front());
+    m_lstOpenSearchQueries.pop_front();
+    return true;
+}
+
+void DiscogsParser::clearOpenSearchQueries()
+{
+    QMutexLocker cl_lock( &m_clOpenSearchQueriesMutex );
+    m_lstOpenSearchQueries.clear();
+}
+
+void DiscogsParser::dropSearchesInFlight( const Query& rclQuery )
+{
+    // a perfect match for an earlier request does not end the current one
+    if ( !( rclQuery == m_clQuery ) )
+        return;
+    // their replies are ignored
+    ++m_iSearchGeneration;
+    m_iSearchQueriesInFlight = 0;
+}
 
-void DiscogsParser::parseSearchResult(const QByteArray& rclContent, const QUrl& rclRequestUrl)
+
+void DiscogsParser::parseSearchResult(const QByteArray& rclContent, const QUrl& rclRequestUrl, const Query& rclQuery)
 {
     // get the type argument from request URL
     QRegularExpressionMatch cl_match = QRegularExpression( "&type=([^&]+)" ).match( rclRequestUrl.query(QUrl::FullyEncoded) );
@@ -397,12 +481,52 @@ void DiscogsParser::parseSearchResult(const QByteArray& rclContent, const QUrl&
         if ( getIdAndTypeFromURL(cl_full_url, str_type, i_id) && str_type.compare( str_type, Qt::CaseInsensitive ) == 0 )
         {
             // store search result in cache
-            m_lruSearchResults.insert( SearchQuery(str_query,str_type), new int(i_id) );
-            getContentFromCacheAndQueryMissing( i_id, str_type+"s" );
+            m_lruSearchResults.insert( SearchQuery(str_query,str_type), i_id );
+            m_pclStoredResults->insertObject( QString("discogs/search/%1/%2").arg(str_type,str_query), static_cast<qint32>(i_id) );
+            getContentFromCacheAndQueryMissing( i_id, str_type+"s", rclQuery );
             return;
         }
     }
     // store in cache that there was no result
-    m_lruSearchResults.insert( SearchQuery(str_query,str_type), new int(0) );
+    m_lruSearchResults.insert( SearchQuery(str_query,str_type), 0 );
+    m_pclStoredResults->insertObject( QString("discogs/search/%1/%2").arg(str_type,str_query), qint32(0) );
     emit info( QString("no usable results found in search reply to \"%1\"").arg( rclRequestUrl.query() ) );
 }
+
+std::optional<DiscogsParser::SourcePtr> DiscogsParser::getCachedContent( int iID, const QString& strType )
+{
+    std::optional<SourcePtr> pcl_source = m_lruContent.object(ContentId(iID,strType));
+    if ( pcl_source )
+        return pcl_source;
+    // maybe the source was parsed in an earlier session
+    std::optional<QByteArray> arr_stored = m_pclStoredResults->value( QString("discogs/content/%1/%2").arg(strType).arg(iID) );
+    if ( !arr_stored )
+        return std::nullopt;
+    QDataStream cl_stream( *arr_stored );
+    bool b_valid = false;
+    cl_stream >> b_valid;
+    if ( b_valid )
+    {
+        std::unique_ptr<OnlineInfoSource> pcl_info = OnlineInfoSource::load( cl_stream );
+        auto pcl_discogs_info = dynamic_cast<DiscogsInfoSource*>( pcl_info.get() );
+        if ( !pcl_discogs_info ) // stored by an incompatible version
+            return std::nullopt;
+        pcl_info.release();
+        pcl_source = SourcePtr( pcl_discogs_info );
+    }
+    else
+        pcl_source = SourcePtr(); // the reply could not be parsed into a source
+    m_lruContent.insert( ContentId(iID,strType), *pcl_source );
+    return pcl_source;
+}
+
+void DiscogsParser::cacheContent( int iID, const QString& strType, SourcePtr pclSource )
+{
+    QByteArray arr_stored;
+    QDataStream cl_stream( &arr_stored, QIODevice::WriteOnly );
+    cl_stream << static_cast<bool>(pclSource);
+    if ( pclSource )
+        pclSource->save( cl_stream );
+    m_pclStoredResults->insert( QString("discogs/content/%1/%2").arg(strType).arg(iID), arr_stored );
+    m_lruContent.insert( ContentId(iID,strType), std::move(pclSource) );
+}
@@ -2,7 +2,7 @@
 #define DISCOGSPARSER_H
 
 #include "OnlineSourceParser.h"
-#include <QCache>
+#include "ParserResultStore.h"
 
 class QNetworkReply;
 class QNetworkAccessManager;
@@ -21,9 +21,15 @@ public:
     std::shared_ptr<OnlineInfoSource> getResult( const QString& strPage ) const override;
     
     const QIcon& getIcon() const override;
+    
+    // number of search queries sent without waiting for the replies to the previous ones
+    void setMaxSearchQueriesInFlight( int iMaxQueries );
 public slots:
     void parseFromURL( const QUrl& rclUrl );
     
+protected:
+    void requestCoalesced( const QNetworkRequest& rclRequest, const QString& strReceivingSlot ) override;
+    
 protected slots:
     void searchReplyReceived();
     void contentReplyReceived();
@@ -33,8 +39,8 @@ protected:
     template<typename FunT>
     void replyReceived( QNetworkReply* pclReply,FunT funAction, const char * strRedirectReplySlot);
     
-    void parseSearchResult( const QByteArray& rclContent, const QUrl& rclRequestUrl );
-    void parseContent( const QByteArray& rclContent, const QUrl& rclRequestURL );
+    void parseSearchResult( const QByteArray& rclContent, const QUrl& rclRequestUrl, const Query& rclQuery );
+    void parseContent( const QByteArray& rclContent, const QUrl& rclRequestURL, const Query& rclQuery );
     void parseImages( const QByteArray& rclContent, const QUrl& rclRequestURL );
     
     void resolveItems( QStringList lstItems );
@@ -44,25 +50,37 @@ protected:
     using SearchQuery = std::pair<QString,QString>;
     using ContentId   = std::pair<int,QString>;
     using SourcePtr   = std::shared_ptr<class DiscogsInfoSource>;
-    std::map<int,SourcePtr> m_mapParsedInfos;
+    // results and caches are shared between the parser threads and the GUI
+    SnapshotMap<int,SourcePtr> m_mapParsedInfos;
     
-    // remember the last requested for later use during parsing
-    QString m_strTrackTitle, m_strAlbumTitle, m_strTrackArtist;
-    int     m_iYear = -1;
+    // remember the last requested for later use during parsing, only used by the GUI thread
+    Query   m_clQuery;
     
     
-    std::list<SearchQuery>      m_lstOpenSearchQueries;
-    QCache<SearchQuery,int>     m_lruSearchResults;
-    QCache<ContentId,SourcePtr> m_lruContent;
-    QCache<int,QString>         m_lruCoverURLs;
+    QMutex                           m_clOpenSearchQueriesMutex;
+    std::list<SearchQuery>           m_lstOpenSearchQueries;
+    int                              m_iSearchQueriesInFlight = 0; // only used by the GUI thread
+    int                              m_iSearchGeneration = 0;      // search replies of earlier requests are not counted as in flight any more
+    int                              m_iMaxSearchQueriesInFlight = 3;
+    SharedCache<SearchQuery,int>     m_lruSearchResults;
+    SharedCache<ContentId,SourcePtr> m_lruContent;
+    SharedCache<int,QString>         m_lruCoverURLs;
+    std::shared_ptr<PersistentResultStore> m_pclStoredResults; // contents, search results and cover URLs of the caches above, kept between sessions
     
     std::unique_ptr<QIcon> m_pclIcon;
     
     void getNextSearchResultFromCacheOrSendQuery();
+    bool takeNextSearchQuery( SearchQuery& rclQuery ); // returns false, if no queries are left
+    void clearOpenSearchQueries();
+    void dropSearchesInFlight( const Query& rclQuery ); // after a perfect match for rclQuery
+    
+    // parsed sources are looked up in the LRU first and in the results stored by earlier sessions second
+    std::optional<SourcePtr> getCachedContent( int iID, const QString& strType );
+    void cacheContent( int iID, const QString& strType, SourcePtr pclSource );
     
     // return true, if no network query was necessary
-    bool addParsedContent( SourcePtr pclSource, const QString& strType );
-    bool getContentFromCacheAndQueryMissing(int iID, const QString &strType);
+    bool addParsedContent( SourcePtr pclSource, const QString& strType, const Query& rclQuery );
+    bool getContentFromCacheAndQueryMissing(int iID, const QString &strType, const Query& rclQuery);
     bool getCoverURLFromCacheAndQueryMissing(int iID, const QString &strType);
     SourcePtr addCoverURLToSource( int iID, QString strCoverURL );
     
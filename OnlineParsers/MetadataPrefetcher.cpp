@@ -0,0 +1,142 @@
+#include "MetadataPrefetcher.h"
+#include "OnlineSourceParser.h"
+#include <Tools/FolderTagIndex.h>
+#include <Tools/TagLibString.h>
+#include <QtConcurrent>
+#include <taglib/fileref.h>
+#include <taglib/tag.h>
+
+MetadataPrefetcher::MetadataPrefetcher( QObject *pclParent )
+: QObject( pclParent )
+{
+    connect( &m_clTagReader, &QFutureWatcher<TrackQuery>::finished, this, &MetadataPrefetcher::tagsRead );
+}
+
+MetadataPrefetcher::~MetadataPrefetcher()
+{
+    stop();
+    m_clTagReader.waitForFinished();
+}
+
+void MetadataPrefetcher::addParser( std::shared_ptr<OnlineSourceParser> pclParser )
+{
+    if ( !pclParser )
+        return;
+    // the selected file's requests are sent first
+    pclParser->setRequestPriority( RequestScheduler::Prefetch );
+    connect( pclParser.get(), &OnlineSourceParser::idle, this, &MetadataPrefetcher::checkParsersIdle );
+    m_vecParsers.emplace_back( std::move(pclParser) );
+}
+
+void MetadataPrefetcher::setTagIndex( const FolderTagIndex* pclTagIndex )
+{
+    m_pclTagIndex = pclTagIndex;
+}
+
+void MetadataPrefetcher::prefetch( QStringList lstFullFilePaths )
+{
+    // do not throw away the work done for the current file, if it is still of interest
+    if ( !m_strCurrentFile.isEmpty() && lstFullFilePaths.removeAll( m_strCurrentFile ) > 0 )
+    {
+        m_lstFiles = std::move(lstFullFilePaths);
+        return;
+    }
+    stop();
+    m_lstFiles = std::move(lstFullFilePaths);
+    startNext();
+}
+
+void MetadataPrefetcher::stop()
+{
+    m_lstFiles.clear();
+    m_strCurrentFile.clear();
+    m_bLookingUp = false;
+    // also cancels the pending requests
+    for ( auto& rcl_parser : m_vecParsers )
+        rcl_parser->clearResults();
+}
+
+MetadataPrefetcher::TrackQuery MetadataPrefetcher::readTags( const QString& strFullFilePath )
+{
+    TrackQuery cl_query;
+    cl_query.strFullFilePath = strFullFilePath;
+    TagLib::FileRef cl_file( strFullFilePath.toLocal8Bit().data(), false );
+    if ( !cl_file.isNull() && cl_file.tag() )
+    {
+        cl_query.strArtist = T2Q( cl_file.tag()->artist() );
+        cl_query.strTitle  = T2Q( cl_file.tag()->title() );
+        cl_query.strAlbum  = T2Q( cl_file.tag()->album() );
+        cl_query.iYear     = static_cast<int>( cl_file.tag()->year() );
+    }
+    return cl_query;
+}
+
+void MetadataPrefetcher::startNext()
+{
+    // a stale read still running calls again once it finished
+    if ( !m_strCurrentFile.isEmpty() || m_clTagReader.isRunning() || m_lstFiles.isEmpty() )
+        return;
+    m_strCurrentFile = m_lstFiles.takeFirst();
+    const FolderTagIndex::Entry* pcl_entry = m_pclTagIndex ? m_pclTagIndex->find( m_strCurrentFile ) : nullptr;
+    if ( !pcl_entry )
+    {
+        m_clTagReader.setFuture( QtConcurrent::run( &MetadataPrefetcher::readTags, m_strCurrentFile ) );
+        return;
+    }
+    TrackQuery cl_query;
+    cl_query.strFullFilePath = m_strCurrentFile;
+    cl_query.strArtist       = pcl_entry->strArtist;
+    cl_query.strTitle        = pcl_entry->strTitle;
+    cl_query.strAlbum        = pcl_entry->strAlbum;
+    cl_query.iYear           = pcl_entry->iYear;
+    lookUp( cl_query );
+}
+
+void MetadataPrefetcher::tagsRead()
+{
+    TrackQuery cl_query = m_clTagReader.result();
+    if ( cl_query.strFullFilePath != m_strCurrentFile )
+    {
+        startNext();
+        return;
+    }
+    lookUp( cl_query );
+}
+
+void MetadataPrefetcher::lookUp( const TrackQuery& rclQuery )
+{
+    if ( rclQuery.strArtist.isEmpty() && rclQuery.strTitle.isEmpty() )
+    {
+        // nothing to look up
+        m_strCurrentFile.clear();
+        startNext();
+        return;
+    }
+    for ( auto& rcl_parser : m_vecParsers )
+    {
+        try
+        {
+            rcl_parser->sendRequests( rclQuery.strArtist, rclQuery.strTitle, rclQuery.strAlbum, rclQuery.iYear );
+        }
+        catch ( const std::exception& )
+        {
+            // errors show up again, once the file gets selected
+        }
+    }
+    m_bLookingUp = true;
+    // parsers finding everything in their caches never get busy, so they do not tell when they are idle
+    QMetaObject::invokeMethod( this, &MetadataPrefetcher::checkParsersIdle, Qt::QueuedConnection );
+}
+
+void MetadataPrefetcher::checkParsersIdle()
+{
+    // parsers stopped for an earlier file may report idle while the tags of the current one are read
+    if ( !m_bLookingUp )
+        return;
+    for ( const auto& rcl_parser : m_vecParsers )
+        if ( rcl_parser->isBusy() )
+            return;
+    m_bLookingUp = false;
+    m_strCurrentFile.clear();
+    startNext();
+}
@@ -0,0 +1,55 @@
+#ifndef METADATAPREFETCHER_H
+#define METADATAPREFETCHER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+class OnlineSourceParser;
+class FolderTagIndex;
+
+// looks up the files, that are probably selected next, with parsers of their own at prefetch priority.
+// The parsers fill the reply cache and the stored results, so the parsers used for the selected file
+// find everything there. One file is looked up at a time, the next once all parsers reported to be idle
+class MetadataPrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetadataPrefetcher( QObject *pclParent = nullptr );
+    ~MetadataPrefetcher() override;
+
+    void addParser( std::shared_ptr<OnlineSourceParser> pclParser );
+    // tags found in the index are not read from the file again
+    void setTagIndex( const FolderTagIndex* pclTagIndex );
+
+public slots:
+    // replaces the files still to be looked up. The file currently looked up is kept, if it is still requested
+    void prefetch( QStringList lstFullFilePaths );
+    void stop();
+
+protected slots:
+    void tagsRead();
+    void checkParsersIdle();
+
+protected:
+    struct TrackQuery
+    {
+        QString strFullFilePath;
+        QString strArtist, strTitle, strAlbum;
+        int     iYear = 0;
+    };
+    static TrackQuery readTags( const QString& strFullFilePath );
+    void startNext();
+    void lookUp( const TrackQuery& rclQuery );
+
+    std::vector<std::shared_ptr<OnlineSourceParser>> m_vecParsers;
+    const FolderTagIndex*        m_pclTagIndex = nullptr;
+    QStringList                  m_lstFiles;        // still to be looked up
+    QString                      m_strCurrentFile;  // read or looked up right now
+    QFutureWatcher<TrackQuery>   m_clTagReader;
+    bool                         m_bLookingUp = false; // the parsers are working on the current file
+};
+
+#endif // METADATAPREFETCHER_H
@@ -1,29 +1,58 @@
 #include "OnlineInfoSources.h"
+#include "WikipediaInfoSources.h"
+#include "DiscogsInfoSources.h"
+#include <QDataStream>
 #include <QStringList>
 #include <Tools/StringDistance.h>
 
-int OnlineArtistInfoSource::matchArtist(const QString &strArtist) const
+void OnlineInfoSource::writeType( QDataStream& rclStream, Type eType )
 {
-    return StringDistance(getArtist(), StringDistance::CaseInsensitive).Levenshtein( strArtist );
+    rclStream << static_cast<quint8>(eType);
+}
+
+std::unique_ptr<OnlineInfoSource> OnlineInfoSource::load( QDataStream& rclStream )
+{
+    quint8 ui_type = 0;
+    rclStream >> ui_type;
+    std::unique_ptr<OnlineInfoSource> pcl_source;
+    switch ( static_cast<Type>(ui_type) )
+    {
+    case Type::WikipediaArtistInfoBox:             pcl_source = std::make_unique<WikipediaArtistInfoBox>(); break;
+    case Type::WikipediaAlbumInfoBox:              pcl_source = std::make_unique<WikipediaAlbumInfoBox>(); break;
+    case Type::SingleOrAlbumInDiscographyAsSource: pcl_source = std::make_unique<SingleOrAlbumInDiscographyAsSource>(); break;
+    case Type::DiscogsArtistInfo:                  pcl_source = std::make_unique<DiscogsArtistInfo>(); break;
+    case Type::DiscogsAlbumInfo:                   pcl_source = std::make_unique<DiscogsAlbumInfo>(); break;
+    default:
+        return nullptr;
+    }
+    pcl_source->readValues( rclStream );
+    if ( rclStream.status() != QDataStream::Ok )
+        return nullptr;
+    return pcl_source;
+}
+
+int OnlineArtistInfoSource::matchArtist(const QString &strArtist, int iMaxDistance) const
+{
+    return StringDistance(getArtist(), StringDistance::CaseInsensitive).LevenshteinBounded( strArtist, iMaxDistance );
 }
 
 
 
-int OnlineAlbumInfoSource::matchArtist(const QString &strArtist) const
+int OnlineAlbumInfoSource::matchArtist(const QString &strArtist, int iMaxDistance) const
 {
     StringDistance cl_query(strArtist, StringDistance::CaseInsensitive);
-    int i_min_distance = cl_query.Levenshtein( getAlbumArtist() );
-    for ( size_t ui_track = 0; ui_track < getNumTracks(); ++ui_track )
-        i_min_distance = std::min( cl_query.Levenshtein( getArtist(ui_track) ), i_min_distance );
+    int i_min_distance = cl_query.LevenshteinBounded( getAlbumArtist(), iMaxDistance );
+    for ( size_t ui_track = 0; ui_track < getNumTracks() && i_min_distance > 0; ++ui_track )
+        i_min_distance = std::min( cl_query.LevenshteinBounded( getArtist(ui_track), std::min( iMaxDistance, i_min_distance ) ), i_min_distance );
     return i_min_distance;
 }
 
-int OnlineAlbumInfoSource::matchAlbum(const QString &strAlbum) const
+int OnlineAlbumInfoSource::matchAlbum(const QString &strAlbum, int iMaxDistance) const
 {
     StringDistance cl_query(strAlbum, StringDistance::CaseInsensitive);
     int i_min_distance = std::numeric_limits<int>::max();
     for ( const QString& str_album : getAlbums() )
-        i_min_distance = std::min( cl_query.Levenshtein( str_album ), i_min_distance );
+        i_min_distance = std::min( cl_query.LevenshteinBounded( str_album, std::min( iMaxDistance, i_min_distance ) ), i_min_distance );
     return i_min_distance;
 }
 
@@ -32,7 +61,7 @@ static QStringList splitTitleAtBrackets( const QString& strTitle )
     return strTitle.split( QRegExp("[\\(\\)\\[\\]]"), QString::SkipEmptyParts );
 }
 
-static int matchTrackTitleConsideringBrackets( const StringDistance& rclQuery, const QString &strTitle)
+static int matchTrackTitleConsideringBrackets( const StringDistance& rclQuery, const QString &strTitle, int iMaxDistance )
 {
     QStringList lst_sub_titles = splitTitleAtBrackets(strTitle);
     if ( lst_sub_titles.size() > 1 )
@@ -40,7 +69,7 @@ static int matchTrackTitleConsideringBrackets( const StringDistance& rclQuery, c
     int i_min_distance = std::numeric_limits<int>::max();
     for ( const QString & str_sub_title : lst_sub_titles )
     {
-        int i_distance = rclQuery.Levenshtein(str_sub_title.trimmed());
+        int i_distance = rclQuery.LevenshteinBounded( str_sub_title.trimmed(), std::min( iMaxDistance, i_min_distance ) );
         if ( i_distance == 0 )
             return 0;
         i_min_distance = std::min( i_distance, i_min_distance );
@@ -48,12 +77,12 @@ static int matchTrackTitleConsideringBrackets( const StringDistance& rclQuery, c
     return i_min_distance;
 }
 
-int OnlineAlbumInfoSource::matchTrackTitlesConsideringBrackets( const QString &strTitle1, const QString &strTitle2 )
+int OnlineAlbumInfoSource::matchTrackTitlesConsideringBrackets( const QString &strTitle1, const QString &strTitle2, int iMaxDistance )
 {
     int i_min_distance = std::numeric_limits<int>::max();
     for ( const QString & str_sub_title : splitTitleAtBrackets( strTitle1 ) )
     {
-        int i_distance = matchTrackTitleConsideringBrackets( StringDistance(str_sub_title, StringDistance::CaseInsensitive), strTitle2 );
+        int i_distance = matchTrackTitleConsideringBrackets( StringDistance(str_sub_title, StringDistance::CaseInsensitive), strTitle2, std::min( iMaxDistance, i_min_distance ) );
         if ( i_distance == 0 )
             return 0;
         i_min_distance = std::min( i_distance, i_min_distance );
@@ -61,7 +90,7 @@ int OnlineAlbumInfoSource::matchTrackTitlesConsideringBrackets( const QString &s
     return i_min_distance;
 }
 
-int OnlineAlbumInfoSource::matchTrackTitle(const QString &strTitle) const
+int OnlineAlbumInfoSource::matchTrackTitle(const QString &strTitle, int iMaxDistance) const
 {
     int i_min_distance = std::numeric_limits<int>::max();
     for ( const QString & str_sub_title : splitTitleAtBrackets( strTitle ) )
@@ -69,7 +98,7 @@ int OnlineAlbumInfoSource::matchTrackTitle(const QString &strTitle) const
         StringDistance cl_query(str_sub_title, StringDistance::CaseInsensitive);
         for ( size_t ui_track = 0; ui_track < getNumTracks(); ++ui_track )
         {
-            int i_distance = matchTrackTitleConsideringBrackets( cl_query, getTitle(ui_track) );
+            int i_distance = matchTrackTitleConsideringBrackets( cl_query, getTitle(ui_track), std::min( iMaxDistance, i_min_distance ) );
             if ( i_distance == 0 )
                 return 0;
             i_min_distance = std::min( i_distance, i_min_distance );
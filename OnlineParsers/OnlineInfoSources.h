@@ -2,9 +2,12 @@
 #define ONLINEINFOSOURCES_H
 
 #include <cstddef>
+#include <limits>
+#include <memory>
 
 class QString;
 class QStringList;
+class QDataStream;
 
 class OnlineInfoSource {
 public:
@@ -12,6 +15,16 @@ public:
     virtual const QString& getURL() const = 0;
     // obtain the significance of this source for a given combination of album, (track) artist, title and year (if available)
     virtual int significance( const QString &strAlbumTitle, const QString &strTrackArtist, const QString &strTrackTitle, int iYear ) const = 0;
+    
+    // compact binary form of the parsed values, so sources can be stored instead of parsing them again.
+    // save writes a type tag in front of the values, load uses it to create a source of the same type
+    virtual void save( QDataStream& rclStream ) const = 0;
+    virtual void readValues( QDataStream& rclStream ) = 0;
+    static std::unique_ptr<OnlineInfoSource> load( QDataStream& rclStream ); // returns nullptr for unknown types
+    
+protected:
+    enum class Type : unsigned char { WikipediaArtistInfoBox = 1, WikipediaAlbumInfoBox, SingleOrAlbumInDiscographyAsSource, DiscogsArtistInfo, DiscogsAlbumInfo };
+    static void writeType( QDataStream& rclStream, Type eType );
 };
 
 class OnlineArtistInfoSource : public virtual OnlineInfoSource {
@@ -19,12 +32,13 @@ public:
     virtual const QString&     getArtist() const = 0;
     virtual const QStringList& getGenres() const = 0;
     
-    virtual int matchArtist( const QString& strArtist ) const;
+    // match functions return the edit distance. Distances larger than iMaxDistance are reported as iMaxDistance+1
+    virtual int matchArtist( const QString& strArtist, int iMaxDistance = std::numeric_limits<int>::max() ) const;
 };
 
 class OnlineAlbumInfoSource : public virtual OnlineInfoSource {
 public:
-    static int matchTrackTitlesConsideringBrackets(const QString& strTitle1, const QString &strTitle2);
+    static int matchTrackTitlesConsideringBrackets(const QString& strTitle1, const QString &strTitle2, int iMaxDistance = std::numeric_limits<int>::max() );
     
     virtual const QStringList& getGenres() const = 0;
     virtual const QString&     getAlbumArtist() const = 0;
@@ -38,9 +52,9 @@ public:
     virtual const QString&     getArtist(size_t uiIndex) const = 0;
     virtual const QString&     getTitle(size_t uiIndex)  const = 0;
     
-    virtual int matchArtist( const QString& strArtist ) const;
-    virtual int matchAlbum( const QString& strAlbum ) const;
-    virtual int matchTrackTitle( const QString& strTitle ) const;
+    virtual int matchArtist( const QString& strArtist, int iMaxDistance = std::numeric_limits<int>::max() ) const;
+    virtual int matchAlbum( const QString& strAlbum, int iMaxDistance = std::numeric_limits<int>::max() ) const;
+    virtual int matchTrackTitle( const QString& strTitle, int iMaxDistance = std::numeric_limits<int>::max() ) const;
 };
 
 #endif // ONLINEINFOSOURCES_H
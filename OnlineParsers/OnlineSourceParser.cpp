@@ -1,45 +1,166 @@
 #include "OnlineSourceParser.h"
+#include "ParserReplyCache.h"
+#include <QNetworkAccessManager>
 #include <QNetworkReply>
-#include <QThread>
+#include <QMutex>
+#include <QPixmap>
+#include <QStandardPaths>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <atomic>
+
+// one pool for all parsers, limited to the number of cores
+static QThreadPool& parserThreadPool()
+{
+    static QThreadPool s_clPool;
+    return s_clPool;
+}
+
+// keeps track of the work a parser has submitted to the pool
+struct OnlineSourceParser::ParserTasks
+{
+    std::atomic<quint64> uiGeneration{0}; // incremented whenever pending work gets cancelled
+    QMutex               clMutex;
+    QWaitCondition       clAllDone;
+    int                  iNumPending{0};
+    std::atomic<int>     iQueriesPosted{0}; // sent by the work, but not handed to the scheduler yet
+};
 
 OnlineSourceParser::OnlineSourceParser(QNetworkAccessManager *pclNetworkAccess, QObject *pclParent)
 : QObject( pclParent )
 , m_pclNetworkAccess( pclNetworkAccess )
+, m_pclTasks( std::make_shared<ParserTasks>() )
 {
+    // all parsers using the same network access share their reply cache
+    if ( m_pclNetworkAccess && !m_pclNetworkAccess->cache() )
+        m_pclNetworkAccess->setCache( new ParserReplyCache( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + "/online_replies", 200*1024*1024, 30*24*3600, m_pclNetworkAccess ) );
+    // as well as the pacing of their requests
+    if ( m_pclNetworkAccess )
+    {
+        m_pclScheduler = RequestScheduler::forNetworkAccess( m_pclNetworkAccess );
+        // queued, so the receiving slot has handled the reply already
+        connect( m_pclScheduler, &RequestScheduler::requestFinished, this, [this]( QObject* pclReceiver ) {
+            if ( pclReceiver == this )
+                checkIdle();
+        }, Qt::QueuedConnection );
+    }
+    // counted first, so the count never drops below zero while the query is handed over
+    ParserTasks* pcl_tasks = m_pclTasks.get();
+    connect( this, &OnlineSourceParser::sendQuery, this, [pcl_tasks]{ ++pcl_tasks->iQueriesPosted; }, Qt::DirectConnection );
     connect( this, SIGNAL(sendQuery(QNetworkRequest,QString)), this, SLOT(onSendQuery(QNetworkRequest,QString)), Qt::QueuedConnection );
+    connect( this, &OnlineSourceParser::cancelAllPendingNetworkRequests, this, [this]{
+        ++m_pclTasks->uiGeneration;
+        if ( m_pclScheduler )
+            m_pclScheduler->cancel( this );
+    } );
+}
+
+OnlineSourceParser::~OnlineSourceParser()
+{
+    if ( m_pclScheduler )
+        m_pclScheduler->cancel( this );
+    stopParserThreads();
+}
+
+void OnlineSourceParser::stopParserThreads()
+{
+    ++m_pclTasks->uiGeneration;
+    QMutexLocker cl_lock( &m_pclTasks->clMutex );
+    while ( m_pclTasks->iNumPending > 0 )
+        m_pclTasks->clAllDone.wait( &m_pclTasks->clMutex );
+}
+
+bool OnlineSourceParser::isBusy() const
+{
+    {
+        QMutexLocker cl_lock( &m_pclTasks->clMutex );
+        if ( m_pclTasks->iNumPending > 0 )
+            return true;
+    }
+    if ( m_pclTasks->iQueriesPosted > 0 )
+        return true;
+    return m_pclScheduler && m_pclScheduler->hasPendingRequests( this );
 }
 
-OnlineSourceParser::~OnlineSourceParser() = default;
+void OnlineSourceParser::checkIdle()
+{
+    if ( !isBusy() )
+        emit idle();
+}
 
 void OnlineSourceParser::onSendQuery(QNetworkRequest clRequest, QString strReceivingSlot )
 {
-    QNetworkReply *pcl_reply = m_pclNetworkAccess->get( clRequest );
-    connect(this, SIGNAL(cancelAllPendingNetworkRequests()), pcl_reply, SLOT(abort()) );
-    if ( !connect(pcl_reply, SIGNAL(finished()), this, qPrintable(strReceivingSlot) ) )
+    // cached replies are used until they expire, the servers would not allow caching them at all
+    clRequest.setAttribute( QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache );
+    --m_pclTasks->iQueriesPosted;
+    switch ( m_pclScheduler ? m_pclScheduler->enqueue( clRequest, m_eRequestPriority, this, strReceivingSlot ) : RequestScheduler::Rejected )
+    {
+    case RequestScheduler::Queued:
+        return;
+    case RequestScheduler::Coalesced:
+        requestCoalesced( clRequest, strReceivingSlot );
+        break;
+    case RequestScheduler::Rejected:
         emit error( QString( "No suitable SLOT to handle redirect could be connected" ) );
+        break;
+    }
+    checkIdle();
+}
+
+void OnlineSourceParser::downloadIcon( QNetworkAccessManager* pclNetworkAccess, const QUrl& rclUrl, std::function<void(const QPixmap&)> funReady )
+{
+    if ( !pclNetworkAccess )
+        return;
+    QNetworkRequest cl_request( rclUrl );
+    cl_request.setRawHeader( "User-Agent", "TagSupporter/1.0 (https://hoov.de; coke@hoov.de) BasedOnQt/5" );
+    QNetworkReply* pcl_reply = pclNetworkAccess->get( cl_request );
+    connect( pcl_reply, &QNetworkReply::finished, this, [pcl_reply,funReady]{
+        QPixmap cl_icon;
+        if ( pcl_reply->error() == QNetworkReply::NoError && cl_icon.loadFromData( pcl_reply->readAll() ) )
+            funReady( cl_icon );
+        pcl_reply->deleteLater();
+    } );
 }
 
-class ParserWorkerThread : public QThread
+class OnlineSourceParser::ParserTask : public QRunnable
 {
 public:
-    ParserWorkerThread( QByteArray&& strReply, std::function<void(QByteArray)>&& funWork, QObject* pclParent )
-    : QThread(pclParent)
+    ParserTask( OnlineSourceParser* pclParser, std::shared_ptr<ParserTasks> pclTasks, QByteArray&& strReply, std::function<void(QByteArray)>&& funWork )
+    : m_pclParser(pclParser)
+    , m_pclTasks(std::move(pclTasks))
+    , m_uiGeneration(m_pclTasks->uiGeneration)
     , m_funWork(std::move(funWork))
     , m_strReply(std::move(strReply))
     {}
     
     void run() override {
-        m_funWork(std::move(m_strReply));
+        // stale replies are not parsed at all
+        if ( m_pclTasks->uiGeneration == m_uiGeneration )
+            m_funWork(std::move(m_strReply));
+        QMutexLocker cl_lock( &m_pclTasks->clMutex );
+        if ( --m_pclTasks->iNumPending == 0 )
+        {
+            m_pclTasks->clAllDone.wakeAll();
+            // queued behind the queries sent by the work. The parser waits for its work on destruction, so it is still there
+            OnlineSourceParser* pcl_parser = m_pclParser;
+            QMetaObject::invokeMethod( pcl_parser, [pcl_parser]{ pcl_parser->checkIdle(); }, Qt::QueuedConnection );
+        }
     }
     
 protected:
+    OnlineSourceParser* m_pclParser;
+    std::shared_ptr<ParserTasks> m_pclTasks;
+    quint64 m_uiGeneration;
     std::function<void(QByteArray)> m_funWork;
     QByteArray m_strReply;
 };
 
 void OnlineSourceParser::startParserThread( QByteArray&& strReply, std::function<void(QByteArray)>&& funWork )
 {
-    ParserWorkerThread *pcl_thread = new ParserWorkerThread( std::move(strReply), std::move(funWork), this );
-    connect(pcl_thread, &ParserWorkerThread::finished, pcl_thread, &QObject::deleteLater);
-    pcl_thread->start();
+    {
+        QMutexLocker cl_lock( &m_pclTasks->clMutex );
+        ++m_pclTasks->iNumPending;
+    }
+    parserThreadPool().start( new ParserTask( this, m_pclTasks, std::move(strReply), std::move(funWork) ) );
 }
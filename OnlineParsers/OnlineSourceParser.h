@@ -5,9 +5,12 @@
 #include <memory>
 #include <functional>
 #include <QNetworkRequest>
+#include <QPointer>
+#include "RequestScheduler.h"
 
 class OnlineInfoSource;
 class QNetworkAccessManager;
+class QPixmap;
 
 class OnlineSourceParser : public QObject
 {
@@ -21,10 +24,16 @@ public:
     virtual const QIcon& getIcon() const = 0;
     virtual QStringList getPages() const = 0;
     virtual std::shared_ptr<OnlineInfoSource> getResult( const QString& strPage ) const = 0;
+    
+    // requests of parsers with a more important priority are sent first
+    void setRequestPriority( RequestScheduler::Priority ePriority ) { m_eRequestPriority = ePriority; }
+    // true, while requests are queued or underway or replies are still being parsed
+    bool isBusy() const;
 signals:
     void error(QString);
     void info(QString);
     void parsingFinished(QStringList); // emits string list with recently added results
+    void idle(); // emitted, whenever the parser stopped being busy
     void cancelAllPendingNetworkRequests();
     void sendQuery( QNetworkRequest clRequest, QString strReceivingSlot );
     
@@ -32,10 +41,40 @@ protected slots:
     virtual void onSendQuery( QNetworkRequest clRequest, QString strReceivingSlot );
     
 protected:
+    // what the results are requested for. Parser threads work on a copy taken when the reply was handed to them
+    struct Query
+    {
+        QString strTrackArtist;
+        QString strTrackTitle;
+        QString strAlbumTitle;
+        int     iYear = -1;
+        
+        bool operator==( const Query& rclOther ) const {
+            return strTrackArtist == rclOther.strTrackArtist && strTrackTitle == rclOther.strTrackTitle && strAlbumTitle == rclOther.strAlbumTitle && iYear == rclOther.iYear;
+        }
+    };
+    
+    // called, if a request was dropped as an identical request of this parser is queued or underway already.
+    // Its receiving slot is called only once for both of them
+    virtual void requestCoalesced( const QNetworkRequest&, const QString& ) {}
+    // downloads the icon of the source and calls funReady with it. It is decoded from the reply as it is, so it keeps
+    // its transparency. Failing to get an icon is not worth an error
+    void downloadIcon( QNetworkAccessManager* pclNetworkAccess, const QUrl& rclUrl, std::function<void(const QPixmap&)> funReady );
+    // runs funWork on the thread pool shared by all parsers. Work that did not start before cancelAllPendingNetworkRequests is dropped
     void startParserThread( QByteArray&& strReply, std::function<void(QByteArray)>&& funWork );
+    // drops pending work and waits for running work. The work refers to the parser, so subclasses have to call it on destruction
+    void stopParserThreads();
     
 private:
+    struct ParserTasks;
+    class ParserTask;
+    
+    void checkIdle(); // emits idle, unless the parser is busy
+    
     QNetworkAccessManager* m_pclNetworkAccess = nullptr;
+    QPointer<RequestScheduler> m_pclScheduler;
+    RequestScheduler::Priority m_eRequestPriority = RequestScheduler::Interactive;
+    std::shared_ptr<ParserTasks> m_pclTasks;
 };
 
 #endif // ONLINESOURCEPARSER_H
@@ -0,0 +1,206 @@
+#include "ParserReplyCache.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+static const quint32 s_uiMagic   = 0x54535243; // "TSRC"
+static const quint32 s_uiVersion = 1;
+
+// requests only differing in the encoding of the URL or its fragment share one entry
+static QByteArray normalizedUrl( const QUrl& rclUrl )
+{
+    return rclUrl.adjusted( QUrl::RemoveFragment | QUrl::NormalizePathSegments ).toEncoded( QUrl::FullyEncoded );
+}
+
+ParserReplyCache::ParserReplyCache( const QString& strDirectory, qint64 iMaxCacheSize, qint64 iTimeToLiveSecs, QObject *pclParent )
+: QAbstractNetworkCache( pclParent )
+, m_strDirectory( strDirectory )
+, m_iMaxCacheSize( iMaxCacheSize )
+, m_iTimeToLiveSecs( iTimeToLiveSecs )
+{
+    QDir().mkpath( m_strDirectory );
+    for ( const QFileInfo& rcl_file : QDir( m_strDirectory ).entryInfoList( QDir::Files ) )
+        m_iCacheSize += rcl_file.size();
+    expire();
+}
+
+ParserReplyCache::~ParserReplyCache()
+{
+    for ( auto& rcl_prepared : m_mapPreparedReplies )
+        delete rcl_prepared.first;
+}
+
+QString ParserReplyCache::fileName( const QUrl& rclUrl ) const
+{
+    return m_strDirectory + "/" + QCryptographicHash::hash( normalizedUrl(rclUrl), QCryptographicHash::Sha1 ).toHex() + ".reply";
+}
+
+bool ParserReplyCache::read( const QUrl& rclUrl, QNetworkCacheMetaData& rclMetaData, QByteArray* pclData ) const
+{
+    QFile cl_file( fileName(rclUrl) );
+    if ( !cl_file.open( QIODevice::ReadOnly ) )
+        return false;
+    QDataStream cl_stream( &cl_file );
+    quint32 ui_magic, ui_version;
+    QByteArray arr_url;
+    cl_stream >> ui_magic >> ui_version;
+    if ( ui_magic != s_uiMagic || ui_version != s_uiVersion )
+        return false;
+    cl_stream >> arr_url >> rclMetaData;
+    // different URLs with the same hash are not worth handling
+    if ( cl_stream.status() != QDataStream::Ok || arr_url != normalizedUrl(rclUrl) )
+        return false;
+    if ( pclData )
+    {
+        QByteArray arr_compressed;
+        cl_stream >> arr_compressed;
+        if ( cl_stream.status() != QDataStream::Ok )
+            return false;
+        *pclData = qUncompress( arr_compressed );
+        if ( pclData->isEmpty() && !arr_compressed.isEmpty() ) // corrupt data
+            return false;
+    }
+    return true;
+}
+
+bool ParserReplyCache::write( const QNetworkCacheMetaData& rclMetaData, const QByteArray& rclCompressedData )
+{
+    QString str_file = fileName( rclMetaData.url() );
+    qint64 i_old_size = QFileInfo( str_file ).size();
+
+    QSaveFile cl_file( str_file );
+    if ( !cl_file.open( QIODevice::WriteOnly ) )
+        return false;
+    QDataStream cl_stream( &cl_file );
+    cl_stream << s_uiMagic << s_uiVersion << normalizedUrl( rclMetaData.url() ) << rclMetaData << rclCompressedData;
+    if ( cl_stream.status() != QDataStream::Ok || !cl_file.commit() )
+        return false;
+
+    m_iCacheSize += QFileInfo( str_file ).size() - i_old_size;
+    return true;
+}
+
+QNetworkCacheMetaData ParserReplyCache::metaData( const QUrl& rclUrl )
+{
+    QNetworkCacheMetaData cl_meta_data;
+    if ( !read( rclUrl, cl_meta_data, nullptr ) )
+        return QNetworkCacheMetaData();
+    if ( cl_meta_data.expirationDate().isValid() && cl_meta_data.expirationDate() < QDateTime::currentDateTimeUtc() )
+    {
+        remove( rclUrl );
+        return QNetworkCacheMetaData();
+    }
+    return cl_meta_data;
+}
+
+void ParserReplyCache::updateMetaData( const QNetworkCacheMetaData& rclMetaData )
+{
+    QNetworkCacheMetaData cl_old_meta_data;
+    QByteArray arr_data;
+    if ( !read( rclMetaData.url(), cl_old_meta_data, &arr_data ) )
+        return;
+    // keep our own time to live, the server would shorten it again
+    QNetworkCacheMetaData cl_meta_data = rclMetaData;
+    cl_meta_data.setExpirationDate( cl_old_meta_data.expirationDate() );
+    cl_meta_data.setSaveToDisk( true );
+    write( cl_meta_data, qCompress( arr_data ) );
+}
+
+QIODevice* ParserReplyCache::data( const QUrl& rclUrl )
+{
+    QNetworkCacheMetaData cl_meta_data;
+    QByteArray arr_data;
+    if ( !read( rclUrl, cl_meta_data, &arr_data ) )
+        return nullptr;
+    // the modification time is the time of the last use, so that expire drops the least recently used entries
+    QFile cl_file( fileName(rclUrl) );
+    if ( cl_file.open( QIODevice::ReadOnly ) )
+        cl_file.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+    QBuffer* pcl_buffer = new QBuffer();
+    pcl_buffer->setData( arr_data );
+    pcl_buffer->open( QIODevice::ReadOnly );
+    return pcl_buffer;
+}
+
+bool ParserReplyCache::remove( const QUrl& rclUrl )
+{
+    // aborted downloads are removed, while their data is still being prepared
+    for ( auto it_prepared = m_mapPreparedReplies.begin(); it_prepared != m_mapPreparedReplies.end(); )
+    {
+        if ( normalizedUrl( it_prepared->second.url() ) == normalizedUrl( rclUrl ) )
+        {
+            delete it_prepared->first;
+            it_prepared = m_mapPreparedReplies.erase( it_prepared );
+        }
+        else
+            ++it_prepared;
+    }
+
+    QString str_file = fileName( rclUrl );
+    qint64 i_size = QFileInfo( str_file ).size();
+    if ( !QFile::remove( str_file ) )
+        return false;
+    m_iCacheSize -= i_size;
+    return true;
+}
+
+qint64 ParserReplyCache::cacheSize() const
+{
+    return m_iCacheSize;
+}
+
+QIODevice* ParserReplyCache::prepare( const QNetworkCacheMetaData& rclMetaData )
+{
+    if ( !rclMetaData.isValid() || !rclMetaData.url().isValid() )
+        return nullptr;
+    // errors like throttled requests must not be answered from the cache later on
+    int i_status = rclMetaData.attributes().value( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+    if ( i_status >= 400 )
+        return nullptr;
+    QNetworkCacheMetaData cl_meta_data = rclMetaData;
+    cl_meta_data.setSaveToDisk( true );
+    cl_meta_data.setExpirationDate( QDateTime::currentDateTimeUtc().addSecs( m_iTimeToLiveSecs ) );
+
+    QBuffer* pcl_buffer = new QBuffer();
+    pcl_buffer->open( QIODevice::ReadWrite );
+    m_mapPreparedReplies[pcl_buffer] = std::move(cl_meta_data);
+    return pcl_buffer;
+}
+
+void ParserReplyCache::insert( QIODevice* pclDevice )
+{
+    auto it_prepared = m_mapPreparedReplies.find( pclDevice );
+    if ( it_prepared == m_mapPreparedReplies.end() )
+        return;
+    QBuffer* pcl_buffer = static_cast<QBuffer*>( pclDevice );
+    if ( write( it_prepared->second, qCompress( pcl_buffer->data() ) ) )
+        expire();
+    m_mapPreparedReplies.erase( it_prepared );
+    delete pclDevice;
+}
+
+void ParserReplyCache::clear()
+{
+    for ( const QFileInfo& rcl_file : QDir( m_strDirectory ).entryInfoList( QDir::Files ) )
+        QFile::remove( rcl_file.absoluteFilePath() );
+    m_iCacheSize = 0;
+}
+
+void ParserReplyCache::expire()
+{
+    if ( m_iCacheSize <= m_iMaxCacheSize )
+        return;
+    // make some room, so not every insert has to scan the directory again
+    qint64 i_target_size = m_iMaxCacheSize * 9 / 10;
+    for ( const QFileInfo& rcl_file : QDir( m_strDirectory ).entryInfoList( QDir::Files, QDir::Time | QDir::Reversed ) )
+    {
+        if ( m_iCacheSize <= i_target_size )
+            break;
+        if ( QFile::remove( rcl_file.absoluteFilePath() ) )
+            m_iCacheSize -= rcl_file.size();
+    }
+}
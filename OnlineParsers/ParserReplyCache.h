@@ -0,0 +1,46 @@
+#ifndef PARSERREPLYCACHE_H
+#define PARSERREPLYCACHE_H
+
+#include <QAbstractNetworkCache>
+#include <QNetworkCacheMetaData>
+#include <map>
+
+class QBuffer;
+
+// size bounded disk cache for the replies of the online parsers. Replies are stored zlib compressed,
+// one file per normalized request URL, and expire after a fixed time to live regardless of the
+// caching headers sent by the servers (those mostly forbid caching at all)
+class ParserReplyCache : public QAbstractNetworkCache
+{
+    Q_OBJECT
+public:
+    explicit ParserReplyCache( const QString& strDirectory, qint64 iMaxCacheSize = 200*1024*1024, qint64 iTimeToLiveSecs = 30*24*3600, QObject *pclParent = nullptr );
+    ~ParserReplyCache() override;
+
+    QNetworkCacheMetaData metaData( const QUrl& rclUrl ) override;
+    void updateMetaData( const QNetworkCacheMetaData& rclMetaData ) override;
+    QIODevice* data( const QUrl& rclUrl ) override;
+    bool remove( const QUrl& rclUrl ) override;
+    qint64 cacheSize() const override;
+
+    QIODevice* prepare( const QNetworkCacheMetaData& rclMetaData ) override;
+    void insert( QIODevice* pclDevice ) override;
+
+public slots:
+    void clear() override;
+
+protected:
+    QString fileName( const QUrl& rclUrl ) const;
+    // returns false, if there is no valid entry. Data is only read and uncompressed, if requested
+    bool read( const QUrl& rclUrl, QNetworkCacheMetaData& rclMetaData, QByteArray* pclData ) const;
+    bool write( const QNetworkCacheMetaData& rclMetaData, const QByteArray& rclCompressedData );
+    void expire(); // removes the least recently used entries until the cache fits its maximum size again
+
+    QString m_strDirectory;
+    qint64  m_iMaxCacheSize;
+    qint64  m_iTimeToLiveSecs;
+    qint64  m_iCacheSize = 0;
+    std::map<QIODevice*,QNetworkCacheMetaData> m_mapPreparedReplies; // replies that are currently being downloaded
+};
+
+#endif // PARSERREPLYCACHE_H
@@ -0,0 +1,119 @@
+#include "ParserResultStore.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+static const quint32 s_uiMagic   = 0x54535052; // "TSPR"
+static const quint32 s_uiVersion = 2; // increase whenever the serialization of the info sources changes
+
+std::shared_ptr<PersistentResultStore> PersistentResultStore::forDirectory( const QString& strDirectory )
+{
+    static QMutex s_clMutex;
+    static std::map<QString,std::shared_ptr<PersistentResultStore>> s_mapStores;
+    QMutexLocker cl_lock( &s_clMutex );
+    std::shared_ptr<PersistentResultStore>& rpcl_store = s_mapStores[strDirectory];
+    if ( !rpcl_store )
+        rpcl_store.reset( new PersistentResultStore( strDirectory, 100*1024*1024, 30*24*3600 ) );
+    return rpcl_store;
+}
+
+PersistentResultStore::PersistentResultStore( const QString& strDirectory, qint64 iMaxSize, qint64 iTimeToLiveSecs )
+: m_strDirectory( strDirectory )
+, m_iMaxSize( iMaxSize )
+, m_iTimeToLiveSecs( iTimeToLiveSecs )
+{
+    QDir().mkpath( m_strDirectory );
+    // drop expired results, so the store does not grow forever
+    startExpire();
+}
+
+QString PersistentResultStore::fileName( const QString& strKey ) const
+{
+    return m_strDirectory + "/" + QCryptographicHash::hash( strKey.toUtf8(), QCryptographicHash::Sha1 ).toHex() + ".parsed";
+}
+
+std::optional<QByteArray> PersistentResultStore::value( const QString& strKey ) const
+{
+    QFile cl_file( fileName(strKey) );
+    if ( !cl_file.open( QIODevice::ReadOnly ) )
+        return std::nullopt;
+    QDataStream cl_stream( &cl_file );
+    quint32 ui_magic, ui_version;
+    qint64 i_written;
+    QString str_key;
+    QByteArray arr_compressed;
+    cl_stream >> ui_magic >> ui_version;
+    if ( ui_magic != s_uiMagic || ui_version != s_uiVersion )
+        return std::nullopt;
+    cl_stream >> i_written >> str_key >> arr_compressed;
+    // different keys with the same hash are not worth handling
+    if ( cl_stream.status() != QDataStream::Ok || str_key != strKey )
+        return std::nullopt;
+    if ( i_written < QDateTime::currentSecsSinceEpoch() - m_iTimeToLiveSecs )
+        return std::nullopt;
+    QByteArray arr_value = qUncompress( arr_compressed );
+    if ( arr_value.isEmpty() && !arr_compressed.isEmpty() ) // corrupt data
+        return std::nullopt;
+    // the modification time is the time of the last use, so that expire drops the least recently used results
+    cl_file.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+    return arr_value;
+}
+
+void PersistentResultStore::insert( const QString& strKey, const QByteArray& arrValue )
+{
+    QString str_file = fileName( strKey );
+    qint64 i_old_size = QFileInfo( str_file ).size();
+    // writes to a temporary file first, so concurrent readers never see a partial file
+    QSaveFile cl_file( str_file );
+    if ( !cl_file.open( QIODevice::WriteOnly ) )
+        return;
+    QDataStream cl_stream( &cl_file );
+    cl_stream << s_uiMagic << s_uiVersion << QDateTime::currentSecsSinceEpoch() << strKey << qCompress( arrValue );
+    if ( cl_stream.status() != QDataStream::Ok || !cl_file.commit() )
+        return;
+
+    if ( ( m_iSize += QFileInfo( str_file ).size() - i_old_size ) > m_iMaxSize )
+        startExpire();
+}
+
+void PersistentResultStore::startExpire()
+{
+    if ( !m_bExpiring.exchange( true ) )
+        QtConcurrent::run( [this]{ expire(); } );
+}
+
+void PersistentResultStore::expire()
+{
+    // files not used within the time to live are expired anyway
+    QDateTime cl_oldest = QDateTime::currentDateTime().addSecs( -m_iTimeToLiveSecs );
+    QFileInfoList lst_files;
+    qint64 i_size = 0;
+    for ( const QFileInfo& rcl_file : QDir( m_strDirectory ).entryInfoList( QDir::Files, QDir::Time ) )
+    {
+        if ( rcl_file.lastModified() < cl_oldest )
+            QFile::remove( rcl_file.absoluteFilePath() );
+        else
+        {
+            lst_files.append( rcl_file );
+            i_size += rcl_file.size();
+        }
+    }
+    // make some room, so not every insert has to scan the directory again
+    if ( i_size > m_iMaxSize )
+    {
+        qint64 i_target_size = m_iMaxSize * 9 / 10;
+        while ( i_size > i_target_size && !lst_files.isEmpty() )
+        {
+            QFileInfo cl_file = lst_files.takeLast();
+            if ( QFile::remove( cl_file.absoluteFilePath() ) )
+                i_size -= cl_file.size();
+        }
+    }
+    m_iSize = i_size;
+    m_bExpiring = false;
+}
@@ -0,0 +1,113 @@
+#ifndef PARSERRESULTSTORE_H
+#define PARSERRESULTSTORE_H
+
+#include <QCache>
+#include <QDataStream>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <optional>
+
+// LRU cache that may be used by several parser threads at once. Values are handed out as copies,
+// as entries may be dropped from the cache at any time
+template<typename Key, typename T>
+class SharedCache
+{
+public:
+    explicit SharedCache( int iMaxCost ) : m_clCache(iMaxCost) {}
+
+    std::optional<T> object( const Key& rclKey ) const {
+        QMutexLocker cl_lock( &m_clMutex );
+        const T* pcl_value = m_clCache.object( rclKey );
+        return pcl_value ? std::optional<T>( *pcl_value ) : std::nullopt;
+    }
+    void insert( const Key& rclKey, T clValue ) {
+        QMutexLocker cl_lock( &m_clMutex );
+        m_clCache.insert( rclKey, new T( std::move(clValue) ) );
+    }
+    void clear() {
+        QMutexLocker cl_lock( &m_clMutex );
+        m_clCache.clear();
+    }
+
+private:
+    mutable QMutex m_clMutex;
+    mutable QCache<Key,T> m_clCache; // lookups update the LRU order
+};
+
+// map that is published as immutable snapshots. Readers get a consistent state without locking,
+// writers (serialized among each other) modify a copy and swap it in
+template<typename Key, typename T>
+class SnapshotMap
+{
+public:
+    using Map = std::map<Key,T>;
+
+    std::shared_ptr<const Map> snapshot() const { return std::atomic_load( &m_pclMap ); }
+
+    template<typename FunT>
+    void modify( FunT funModify ) {
+        QMutexLocker cl_lock( &m_clWriteMutex );
+        auto pcl_map = std::make_shared<Map>( *std::atomic_load( &m_pclMap ) );
+        funModify( *pcl_map );
+        std::atomic_store( &m_pclMap, std::shared_ptr<const Map>( std::move(pcl_map) ) );
+    }
+    void clear() {
+        QMutexLocker cl_lock( &m_clWriteMutex );
+        std::atomic_store( &m_pclMap, std::make_shared<const Map>() );
+    }
+
+private:
+    QMutex m_clWriteMutex;
+    std::shared_ptr<const Map> m_pclMap{ std::make_shared<const Map>() };
+};
+
+// parsed results kept on disk between sessions. Values are stored zlib compressed in one file per key
+// and are dropped after a fixed time to live, or least recently used first when the store exceeds its
+// maximum size. May be used by several parser threads at once
+class PersistentResultStore
+{
+public:
+    // the store shared by all parsers using strDirectory. It is created on first use and scans the directory
+    // for expired results in the background
+    static std::shared_ptr<PersistentResultStore> forDirectory( const QString& strDirectory );
+
+    std::optional<QByteArray> value( const QString& strKey ) const;
+    void insert( const QString& strKey, const QByteArray& arrValue );
+
+    // values of any type that can be written to a QDataStream
+    template<typename T>
+    std::optional<T> object( const QString& strKey ) const {
+        std::optional<QByteArray> arr_value = value( strKey );
+        if ( !arr_value )
+            return std::nullopt;
+        T cl_value;
+        QDataStream cl_stream( *arr_value );
+        cl_stream >> cl_value;
+        return cl_stream.status() == QDataStream::Ok ? std::optional<T>( std::move(cl_value) ) : std::nullopt;
+    }
+    template<typename T>
+    void insertObject( const QString& strKey, const T& rclValue ) {
+        QByteArray arr_value;
+        QDataStream cl_stream( &arr_value, QIODevice::WriteOnly );
+        cl_stream << rclValue;
+        insert( strKey, arr_value );
+    }
+
+private:
+    PersistentResultStore( const QString& strDirectory, qint64 iMaxSize, qint64 iTimeToLiveSecs );
+
+    QString fileName( const QString& strKey ) const;
+    void startExpire(); // runs expire on the global thread pool, unless it is already running
+    void expire();      // removes expired results and the least recently used ones until the store fits its maximum size again
+
+    QString             m_strDirectory;
+    qint64              m_iMaxSize;
+    qint64              m_iTimeToLiveSecs;
+    std::atomic<qint64> m_iSize{0}; // as of the last expire plus the inserts since
+    std::atomic<bool>   m_bExpiring{false};
+};
+
+#endif // PARSERRESULTSTORE_H
@@ -0,0 +1,254 @@
+#include "RequestScheduler.h"
+#include <QAbstractNetworkCache>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+static const int    s_iMaxAttempts              = 5;
+static const qint64 s_iMaxBackoffMs             = 60*1000;
+static const double s_fDefaultRequestsPerSecond = 10;
+static const int    s_iDefaultBurst             = 10;
+
+RequestScheduler* RequestScheduler::forNetworkAccess( QNetworkAccessManager* pclNetworkAccess )
+{
+    RequestScheduler* pcl_scheduler = pclNetworkAccess->findChild<RequestScheduler*>( QString(), Qt::FindDirectChildrenOnly );
+    if ( !pcl_scheduler )
+        pcl_scheduler = new RequestScheduler( pclNetworkAccess );
+    return pcl_scheduler;
+}
+
+RequestScheduler::RequestScheduler( QNetworkAccessManager* pclNetworkAccess )
+: QObject( pclNetworkAccess )
+, m_pclNetworkAccess( pclNetworkAccess )
+{
+    m_clClock.start();
+    m_clWakeUp.setSingleShot( true );
+    connect( &m_clWakeUp, &QTimer::timeout, this, &RequestScheduler::dispatch );
+    // discogs allows 25 requests per minute without authentication
+    setHostLimit( "discogs.com", 25./60., 5 );
+    setHostLimit( "wikipedia.org", 5, 10 );
+}
+
+void RequestScheduler::setHostLimit( const QString& strHostSuffix, double fRequestsPerSecond, int iBurst )
+{
+    m_mapHostLimits[strHostSuffix.toLower()] = { fRequestsPerSecond, iBurst };
+    m_mapBuckets.clear(); // recreated with the new limits
+}
+
+RequestScheduler::Bucket& RequestScheduler::bucket( const QString& strHost )
+{
+    // hosts share the bucket of the longest matching suffix, otherwise each host has its own
+    QString str_key = strHost.toLower();
+    std::pair<double,int> cl_limit( s_fDefaultRequestsPerSecond, s_iDefaultBurst );
+    int i_match_length = -1;
+    for ( const auto& rcl_limit : m_mapHostLimits )
+    {
+        if ( rcl_limit.first.size() > i_match_length && str_key.endsWith( rcl_limit.first ) )
+        {
+            i_match_length = rcl_limit.first.size();
+            cl_limit = rcl_limit.second;
+        }
+    }
+    if ( i_match_length >= 0 )
+        str_key = str_key.right( i_match_length );
+
+    qint64 i_now = m_clClock.elapsed();
+    auto it_bucket = m_mapBuckets.find( str_key );
+    if ( it_bucket == m_mapBuckets.end() )
+        it_bucket = m_mapBuckets.emplace( str_key, Bucket{ cl_limit.first, static_cast<double>(cl_limit.second), static_cast<double>(cl_limit.second), i_now } ).first;
+
+    Bucket& rcl_bucket = it_bucket->second;
+    if ( i_now > rcl_bucket.iLastRefillMs )
+    {
+        rcl_bucket.fTokens = std::min( rcl_bucket.fBurst, rcl_bucket.fTokens + ( i_now - rcl_bucket.iLastRefillMs ) * rcl_bucket.fRequestsPerSecond / 1000. );
+        rcl_bucket.iLastRefillMs = i_now;
+    }
+    return rcl_bucket;
+}
+
+RequestScheduler::EnqueueResult RequestScheduler::enqueue( const QNetworkRequest& rclRequest, Priority ePriority, QObject* pclReceiver, const QString& strReceivingSlot )
+{
+    QByteArray str_slot = strReceivingSlot.toLatin1();
+    // SLOT() prefixes the signature with a code
+    if ( !pclReceiver || str_slot.size() < 2 || pclReceiver->metaObject()->indexOfSlot( QMetaObject::normalizedSignature( str_slot.constData()+1 ) ) < 0 )
+        return Rejected;
+
+    // the receiver already gets the reply to an identical request, no need to send it twice
+    auto fun_is_same = [&]( const Request& rclOther ) {
+        return rclOther.pclReceiver == pclReceiver && rclOther.strReceivingSlot == str_slot && rclOther.clRequest.url() == rclRequest.url();
+    };
+    for ( auto& rcl_queue : m_mapQueues )
+        for ( const Request& rcl_queued : rcl_queue.second )
+            if ( fun_is_same( rcl_queued ) )
+                return Coalesced;
+    auto it_underway = m_mapUnderwayUrls.equal_range( rclRequest.url() );
+    for ( auto it_reply = it_underway.first; it_reply != it_underway.second; ++it_reply )
+        if ( fun_is_same( m_mapUnderway.at( it_reply->second ) ) )
+            return Coalesced;
+
+    Request cl_request;
+    cl_request.clRequest        = rclRequest;
+    cl_request.ePriority        = ePriority;
+    cl_request.pclReceiver      = pclReceiver;
+    cl_request.strReceivingSlot = std::move(str_slot);
+    // looking into the cache reads the entry from disk, so it is not done on every dispatch
+    cl_request.bCached          = isCached( rclRequest.url() );
+    m_mapQueues[ePriority].emplace_back( std::move(cl_request) );
+    dispatch();
+    return Queued;
+}
+
+void RequestScheduler::cancel( QObject* pclReceiver )
+{
+    for ( auto& rcl_queue : m_mapQueues )
+        rcl_queue.second.remove_if( [pclReceiver]( const Request& rclRequest ) { return rclRequest.pclReceiver == pclReceiver; } );
+
+    // aborting finishes the reply, which removes it from the map
+    std::vector<QNetworkReply*> vec_replies;
+    for ( const auto& rcl_underway : m_mapUnderway )
+        if ( rcl_underway.second.pclReceiver == pclReceiver )
+            vec_replies.push_back( rcl_underway.first );
+    for ( QNetworkReply* pcl_reply : vec_replies )
+        pcl_reply->abort();
+}
+
+bool RequestScheduler::hasPendingRequests( const QObject* pclReceiver ) const
+{
+    for ( const auto& rcl_queue : m_mapQueues )
+        for ( const Request& rcl_queued : rcl_queue.second )
+            if ( rcl_queued.pclReceiver == pclReceiver )
+                return true;
+    for ( const auto& rcl_underway : m_mapUnderway )
+        if ( rcl_underway.second.pclReceiver == pclReceiver )
+            return true;
+    return false;
+}
+
+bool RequestScheduler::isUnderway( const QUrl& rclUrl ) const
+{
+    return m_mapUnderwayUrls.count( rclUrl ) > 0;
+}
+
+bool RequestScheduler::isCached( const QUrl& rclUrl ) const
+{
+    QAbstractNetworkCache* pcl_cache = m_pclNetworkAccess->cache();
+    return pcl_cache && pcl_cache->metaData( rclUrl ).isValid();
+}
+
+void RequestScheduler::dispatch()
+{
+    qint64 i_now = m_clClock.elapsed();
+    qint64 i_wake_up = -1;
+    auto fun_wake_up_at = [&i_wake_up]( qint64 iTime ) { i_wake_up = ( i_wake_up < 0 ) ? iTime : std::min( i_wake_up, iTime ); };
+
+    for ( auto& rcl_queue : m_mapQueues )
+    {
+        for ( auto it_request = rcl_queue.second.begin(); it_request != rcl_queue.second.end(); )
+        {
+            if ( !it_request->pclReceiver )
+            {
+                it_request = rcl_queue.second.erase( it_request );
+                continue;
+            }
+            if ( it_request->iNotBeforeMs > i_now )
+            {
+                fun_wake_up_at( it_request->iNotBeforeMs );
+                ++it_request;
+                continue;
+            }
+            QUrl cl_url = it_request->clRequest.url();
+            if ( isUnderway( cl_url ) ) // sent once the other request finished
+            {
+                ++it_request;
+                continue;
+            }
+            // replies from the cache do not count against the limit of the host
+            if ( !it_request->bCached )
+            {
+                Bucket& rcl_bucket = bucket( cl_url.host() );
+                if ( rcl_bucket.fTokens < 1. )
+                {
+                    fun_wake_up_at( i_now + static_cast<qint64>( std::ceil( ( 1. - rcl_bucket.fTokens ) * 1000. / rcl_bucket.fRequestsPerSecond ) ) );
+                    ++it_request;
+                    continue;
+                }
+                rcl_bucket.fTokens -= 1.;
+            }
+            Request cl_request = std::move(*it_request);
+            it_request = rcl_queue.second.erase( it_request );
+            send( std::move(cl_request) );
+        }
+    }
+    if ( i_wake_up >= 0 )
+        m_clWakeUp.start( static_cast<int>( std::max<qint64>( i_wake_up - i_now, 0 ) ) );
+}
+
+void RequestScheduler::send( Request clRequest )
+{
+    QNetworkReply* pcl_reply = m_pclNetworkAccess->get( clRequest.clRequest );
+    // connected first, so it may keep the receiver from seeing a throttled reply
+    connect( pcl_reply, &QNetworkReply::finished, this, [this,pcl_reply]{ replyFinished( pcl_reply ); } );
+    connect( pcl_reply, SIGNAL(finished()), clRequest.pclReceiver, clRequest.strReceivingSlot.constData() );
+    m_mapUnderwayUrls.emplace( clRequest.clRequest.url(), pcl_reply );
+    m_mapUnderway.emplace( pcl_reply, std::move(clRequest) );
+}
+
+void RequestScheduler::replyFinished( QNetworkReply* pclReply )
+{
+    auto it_underway = m_mapUnderway.find( pclReply );
+    if ( it_underway == m_mapUnderway.end() )
+        return;
+    Request cl_request = std::move(it_underway->second);
+    m_mapUnderway.erase( it_underway );
+    auto it_urls = m_mapUnderwayUrls.equal_range( cl_request.clRequest.url() );
+    for ( auto it_url = it_urls.first; it_url != it_urls.second; ++it_url )
+    {
+        if ( it_url->second == pclReply )
+        {
+            m_mapUnderwayUrls.erase( it_url );
+            break;
+        }
+    }
+    // requests waiting for this one are likely to be answered by the cache now
+    std::optional<bool> b_cached;
+    for ( auto& rcl_queue : m_mapQueues )
+    {
+        for ( Request& rcl_queued : rcl_queue.second )
+        {
+            if ( rcl_queued.clRequest.url() != cl_request.clRequest.url() )
+                continue;
+            if ( !b_cached )
+                b_cached = isCached( cl_request.clRequest.url() );
+            rcl_queued.bCached = *b_cached;
+        }
+    }
+
+    int i_status = pclReply->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+    if ( ( i_status == 429 || i_status == 503 ) && cl_request.iAttempt+1 < s_iMaxAttempts && cl_request.pclReceiver )
+    {
+        // the receiver only gets to see the retried reply
+        disconnect( pclReply, nullptr, cl_request.pclReceiver, nullptr );
+        pclReply->deleteLater();
+
+        bool b_ok = false;
+        qint64 i_backoff = pclReply->rawHeader( "Retry-After" ).trimmed().toLongLong( &b_ok ) * 1000;
+        if ( !b_ok || i_backoff <= 0 )
+            i_backoff = 1000LL << cl_request.iAttempt;
+        i_backoff = std::min( i_backoff, s_iMaxBackoffMs );
+
+        // the host is busy, so nothing else is sent to it before the backoff is over either
+        Bucket& rcl_bucket = bucket( cl_request.clRequest.url().host() );
+        rcl_bucket.fTokens = std::min( rcl_bucket.fTokens, 0. ) - i_backoff * rcl_bucket.fRequestsPerSecond / 1000.;
+
+        ++cl_request.iAttempt;
+        cl_request.iNotBeforeMs = m_clClock.elapsed() + i_backoff;
+        m_mapQueues[cl_request.ePriority].emplace_front( std::move(cl_request) );
+    }
+    else if ( cl_request.pclReceiver )
+        emit requestFinished( cl_request.pclReceiver );
+    // called while the reply is still emitting finished
+    QTimer::singleShot( 0, this, &RequestScheduler::dispatch );
+}
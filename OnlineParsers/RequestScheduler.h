@@ -0,0 +1,87 @@
+#ifndef REQUESTSCHEDULER_H
+#define REQUESTSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QTimer>
+#include <list>
+#include <map>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+// sends the requests of all parsers using the same network access. Requests are paced by a token bucket
+// per host, more important requests are sent first, and throttled requests (HTTP 429/503) are retried
+// with backoff instead of being reported as errors. Requests for a URL that is already underway wait
+// for it to finish, so they are answered by the reply cache. If the receiver of such a request is the
+// same as well, it is coalesced with the other one, as the receiver already gets the reply it asked for
+class RequestScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority { Interactive = 0, Normal = 1, Prefetch = 2 };
+    // Coalesced requests are dropped, the receiving slot is only called once for the identical request queued or underway
+    enum EnqueueResult { Queued, Coalesced, Rejected };
+
+    // the scheduler shared by everyone using pclNetworkAccess. It is created on first use and owned by pclNetworkAccess
+    static RequestScheduler* forNetworkAccess( QNetworkAccessManager* pclNetworkAccess );
+
+    // requests to hosts ending with strHostSuffix share one bucket of iBurst requests, refilled at fRequestsPerSecond
+    void setHostLimit( const QString& strHostSuffix, double fRequestsPerSecond, int iBurst );
+
+    // strReceivingSlot (as given by SLOT()) is connected to the finished signal of the reply. Rejects the request, if pclReceiver has no such slot
+    EnqueueResult enqueue( const QNetworkRequest& rclRequest, Priority ePriority, QObject* pclReceiver, const QString& strReceivingSlot );
+    // drops the queued requests of pclReceiver and aborts the ones underway. Dropped requests are never
+    // replied to, so their slot is not called. Aborted ones call it with QNetworkReply::OperationCanceledError.
+    // Receivers counting their outstanding requests have to reset the count themselves
+    void cancel( QObject* pclReceiver );
+    // true, if requests of pclReceiver are queued or underway
+    bool hasPendingRequests( const QObject* pclReceiver ) const;
+
+signals:
+    // the reply to a request of pclReceiver finished and is not retried. Emitted before the receiving slot is called
+    void requestFinished( QObject* pclReceiver );
+
+protected slots:
+    void dispatch();
+
+protected:
+    explicit RequestScheduler( QNetworkAccessManager* pclNetworkAccess );
+
+    struct Request
+    {
+        QNetworkRequest   clRequest;
+        Priority          ePriority;
+        QPointer<QObject> pclReceiver;
+        QByteArray        strReceivingSlot;
+        int               iAttempt = 0;
+        qint64            iNotBeforeMs = 0; // backoff after being throttled
+        bool              bCached = false;  // as of enqueuing or the last reply for the same URL
+    };
+    struct Bucket
+    {
+        double fRequestsPerSecond;
+        double fBurst;
+        double fTokens;
+        qint64 iLastRefillMs;
+    };
+
+    Bucket& bucket( const QString& strHost );
+    bool isUnderway( const QUrl& rclUrl ) const;
+    bool isCached( const QUrl& rclUrl ) const;
+    void send( Request clRequest );
+    void replyFinished( QNetworkReply* pclReply );
+
+    QNetworkAccessManager*                  m_pclNetworkAccess;
+    QElapsedTimer                           m_clClock;
+    QTimer                                  m_clWakeUp;
+    std::map<Priority,std::list<Request>>   m_mapQueues; // most important first
+    std::map<QNetworkReply*,Request>        m_mapUnderway;
+    std::multimap<QUrl,QNetworkReply*>      m_mapUnderwayUrls; // the replies underway for each URL
+    std::map<QString,std::pair<double,int>> m_mapHostLimits;
+    std::map<QString,Bucket>                m_mapBuckets;
+};
+
+#endif // REQUESTSCHEDULER_H
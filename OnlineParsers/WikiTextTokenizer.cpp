@@ -0,0 +1,160 @@
+#include "WikiTextTokenizer.h"
+#include <algorithm>
+
+WikiTextTokenizer::WikiTextTokenizer( const QString& strContent )
+: m_strContent( strContent )
+{
+    const QChar* pc_content = m_strContent.constData();
+    const int i_size = m_strContent.size();
+    m_vecTokens.reserve( i_size / 32 );
+
+    // plain text is collected until the next token
+    int i_text_begin = 0;
+    auto fun_add_markup = [&]( TokenType eType, int iBegin, int iEnd, int iLevel = 0 ) {
+        if ( iBegin > i_text_begin )
+            addToken( Text, i_text_begin, iBegin );
+        addToken( eType, iBegin, iEnd, iLevel );
+    };
+    auto fun_is_pair = [&]( int iPos, char cChar ) {
+        return pc_content[iPos] == QLatin1Char(cChar) && iPos+1 < i_size && pc_content[iPos+1] == QLatin1Char(cChar);
+    };
+
+    int i_pos = 0;
+    while ( i_pos < i_size )
+    {
+        bool b_line_start = ( i_pos == 0 || pc_content[i_pos-1] == QLatin1Char('\n') );
+        if ( b_line_start && pc_content[i_pos] == QLatin1Char('=') )
+        {
+            // heading: as many equal signs at the end of the line as at its start. Comments may follow them,
+            // which may even continue on the next lines
+            int i_line_end = m_strContent.indexOf( QLatin1Char('\n'), i_pos );
+            if ( i_line_end < 0 )
+                i_line_end = i_size;
+            int i_opening = 0;
+            while ( i_pos+i_opening < i_line_end && pc_content[i_pos+i_opening] == QLatin1Char('=') )
+                ++i_opening;
+            int i_closing_end = i_pos+i_opening;
+            for ( int i_scan = i_closing_end; i_scan < i_line_end; )
+            {
+                if ( m_strContent.midRef( i_scan, 4 ) == QLatin1String("<!--") )
+                {
+                    int i_comment_end = m_strContent.indexOf( QLatin1String("-->"), i_scan+4 );
+                    i_scan = ( i_comment_end < 0 ) ? i_size : i_comment_end+3;
+                    if ( i_scan > i_line_end && ( i_line_end = m_strContent.indexOf( QLatin1Char('\n'), i_scan ) ) < 0 )
+                        i_line_end = i_size;
+                    continue;
+                }
+                if ( !pc_content[i_scan].isSpace() )
+                    i_closing_end = i_scan+1;
+                ++i_scan;
+            }
+            int i_closing = 0;
+            while ( i_closing_end-i_closing > i_pos+i_opening && pc_content[i_closing_end-i_closing-1] == QLatin1Char('=') )
+                ++i_closing;
+            int i_level = std::min( i_opening, i_closing );
+            if ( i_level > 0 && i_pos+i_level < i_closing_end-i_level )
+            {
+                if ( i_pos > i_text_begin )
+                    addToken( Text, i_text_begin, i_pos );
+                addToken( Heading, i_pos+i_level, i_closing_end-i_level, i_level );
+                // trailing comments are tokenized as usual
+                i_pos = i_text_begin = i_closing_end;
+                continue;
+            }
+        }
+        else if ( b_line_start && pc_content[i_pos] == QLatin1Char('|') )
+        {
+            int i_dash = i_pos+1;
+            while ( i_dash < i_size && ( pc_content[i_dash] == QLatin1Char(' ') || pc_content[i_dash] == QLatin1Char('\t') ) )
+                ++i_dash;
+            if ( i_dash < i_size && pc_content[i_dash] == QLatin1Char('-') )
+            {
+                fun_add_markup( TableRow, i_pos, i_dash+1 );
+                i_pos = i_text_begin = i_dash+1;
+                continue;
+            }
+        }
+
+        TokenType e_type;
+        int i_length = 2;
+        switch ( pc_content[i_pos].unicode() )
+        {
+        case '<':
+            if ( m_strContent.midRef( i_pos, 4 ) == QLatin1String("<!--") )
+            {
+                int i_end = m_strContent.indexOf( QLatin1String("-->"), i_pos+4 );
+                i_length = ( i_end < 0 ) ? i_size-i_pos : i_end+3-i_pos;
+                e_type = Comment;
+                break;
+            }
+            ++i_pos;
+            continue;
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        {
+            char c_char = static_cast<char>( pc_content[i_pos].unicode() );
+            if ( !fun_is_pair( i_pos, c_char ) )
+            {
+                ++i_pos;
+                continue;
+            }
+            e_type = ( c_char == '{' ) ? TemplateStart : ( c_char == '}' ) ? TemplateEnd : ( c_char == '[' ) ? LinkStart : LinkEnd;
+            break;
+        }
+        case '|':
+            e_type = Separator;
+            i_length = 1;
+            break;
+        default:
+            ++i_pos;
+            continue;
+        }
+        fun_add_markup( e_type, i_pos, i_pos+i_length );
+        i_pos = i_text_begin = i_pos+i_length;
+    }
+    if ( i_size > i_text_begin )
+        addToken( Text, i_text_begin, i_size );
+}
+
+void WikiTextTokenizer::addToken( TokenType eType, int iBegin, int iEnd, int iLevel )
+{
+    m_vecTokens.push_back( Token{ eType, iBegin, iEnd, iLevel } );
+}
+
+QString WikiTextTokenizer::textWithoutComments( int iBegin, int iEnd, int iFirstToken ) const
+{
+    QString str_text;
+    int i_pos = iBegin;
+    for ( size_t i_token = std::max( iFirstToken, 0 ); i_token < m_vecTokens.size() && m_vecTokens[i_token].iBegin < iEnd; ++i_token )
+    {
+        const Token& rcl_token = m_vecTokens[i_token];
+        if ( rcl_token.eType != Comment || rcl_token.iEnd <= i_pos )
+            continue;
+        if ( rcl_token.iBegin > i_pos )
+            str_text += m_strContent.midRef( i_pos, rcl_token.iBegin-i_pos );
+        i_pos = rcl_token.iEnd;
+    }
+    if ( iEnd > i_pos )
+        str_text += m_strContent.midRef( i_pos, iEnd-i_pos );
+    return str_text;
+}
+
+std::vector<WikiTextTokenizer::Section> WikiTextTokenizer::sections( int iLevel ) const
+{
+    std::vector<Section> vec_sections;
+    Section cl_section{ QStringRef(), 0, 0 };
+    for ( size_t i_token = 0; i_token < m_vecTokens.size(); ++i_token )
+    {
+        if ( m_vecTokens[i_token].eType == Heading && m_vecTokens[i_token].iLevel == iLevel )
+        {
+            cl_section.iEndToken = static_cast<int>( i_token );
+            vec_sections.push_back( cl_section );
+            cl_section = Section{ text( m_vecTokens[i_token] ), static_cast<int>( i_token )+1, 0 };
+        }
+    }
+    cl_section.iEndToken = static_cast<int>( m_vecTokens.size() );
+    vec_sections.push_back( cl_section );
+    return vec_sections;
+}
@@ -0,0 +1,44 @@
+#ifndef WIKITEXTTOKENIZER_H
+#define WIKITEXTTOKENIZER_H
+
+#include <QString>
+#include <QStringRef>
+#include <vector>
+
+// splits wikitext into comments, headings, template and link brackets, separators and table rows in a single
+// pass. Tokens refer to the content by position, nothing is copied, so the content has to outlive the tokenizer
+class WikiTextTokenizer
+{
+public:
+    enum TokenType { Text, Comment, Heading, TemplateStart, TemplateEnd, LinkStart, LinkEnd, Separator, TableRow };
+    struct Token
+    {
+        TokenType eType;
+        int       iBegin, iEnd; // the text of a heading is without its equal signs
+        int       iLevel;       // number of equal signs of a heading
+    };
+    // the tokens between two headings of the same level
+    struct Section
+    {
+        QStringRef strHeading; // empty for the text before the first heading
+        int        iFirstToken, iEndToken;
+    };
+
+    explicit WikiTextTokenizer( const QString& strContent );
+
+    const QString&            content() const { return m_strContent; }
+    const std::vector<Token>& tokens() const { return m_vecTokens; }
+    QStringRef                text( const Token& rclToken ) const { return QStringRef( &m_strContent, rclToken.iBegin, rclToken.iEnd-rclToken.iBegin ); }
+    // content between the positions with comments left out. Comments are looked for from token iFirstToken on
+    QString                   textWithoutComments( int iBegin, int iEnd, int iFirstToken ) const;
+
+    std::vector<Section> sections( int iLevel = 2 ) const;
+
+protected:
+    void addToken( TokenType eType, int iBegin, int iEnd, int iLevel = 0 );
+
+    const QString&     m_strContent;
+    std::vector<Token> m_vecTokens;
+};
+
+#endif // WIKITEXTTOKENIZER_H
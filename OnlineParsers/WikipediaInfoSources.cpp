@@ -1,5 +1,8 @@
 #include "WikipediaInfoSources.h"
+#include <QDataStream>
 #include <QRegularExpressionMatchIterator>
+#include <algorithm>
+#include <limits>
 
 std::unique_ptr<WikipediaInfoBox> WikipediaInfoBox::createForType(const QString &strType)
 {
@@ -170,24 +173,39 @@ QStringList WikipediaAlbumInfoBox::matchedTypes()
 }
 
 
-std::unique_ptr<SingleOrAlbumInDiscographyAsSource> SingleOrAlbumInDiscographyAsSource::find(const QString& strAlbum, const QString &strDiscographyPageContent)
+std::unique_ptr<SingleOrAlbumInDiscographyAsSource> SingleOrAlbumInDiscographyAsSource::find( const QString& strAlbum, const WikiTextTokenizer& rclPage, const WikiTextTokenizer::Section& rclSection )
 {
-    // full-text search for album in discography (case insensitive)
-    int i_album_start = strDiscographyPageContent.indexOf( strAlbum, 0, Qt::CaseInsensitive );
-    if ( i_album_start < 0 )
+    // full-text search for album in discography (case insensitive). Entries like ''[[Album]]'' are split
+    // by markup, so the text of the section is searched with the markup and the names of templates left out
+    const auto& vec_tokens = rclPage.tokens();
+    QString str_text;
+    std::vector<std::pair<int,int>> vec_segments; // position in str_text and index of each text token
+    for ( int i_token = rclSection.iFirstToken; i_token < rclSection.iEndToken; ++i_token )
+    {
+        if ( vec_tokens[i_token].eType != WikiTextTokenizer::Text )
+            continue;
+        if ( i_token > rclSection.iFirstToken && vec_tokens[i_token-1].eType == WikiTextTokenizer::TemplateStart )
+            continue;
+        vec_segments.emplace_back( str_text.size(), i_token );
+        str_text += rclPage.text( vec_tokens[i_token] );
+    }
+    int i_found = str_text.indexOf( strAlbum, 0, Qt::CaseInsensitive );
+    if ( i_found < 0 )
         return nullptr;
     
     auto pcl_source = std::make_unique<SingleOrAlbumInDiscographyAsSource>();
     pcl_source->m_lstAlbums << strAlbum;
     
-    // search backwards from position of album name to beginning of row
-    int i_row_start = i_album_start;
-    for ( ; i_row_start > 1; --i_row_start )
+    // the text token the album starts in
+    auto it_segment = std::prev( std::upper_bound( vec_segments.begin(), vec_segments.end(), std::make_pair( i_found, std::numeric_limits<int>::max() ) ) );
+    int i_token = it_segment->second;
+    int i_album_begin = vec_tokens[i_token].iBegin + i_found - it_segment->first;
+    // search backwards from the album to the beginning of its table row, which starts with the release date
+    for ( int i_row = i_token; i_row >= rclSection.iFirstToken; --i_row )
     {
-        QStringRef str_row( &strDiscographyPageContent, i_row_start-1, i_album_start-i_row_start );
-        if ( QRegularExpression( "^[|]\\s*-" ).match( str_row ).hasMatch() ) // found start of row!
+        if ( vec_tokens[i_row].eType == WikiTextTokenizer::TableRow )
         {
-            pcl_source->m_strYear = parseYearFromDate(str_row.toString());
+            pcl_source->m_strYear = parseYearFromDate( rclPage.textWithoutComments( vec_tokens[i_row].iEnd, i_album_begin, i_row ) );
             break;
         }
     }
@@ -205,7 +223,7 @@ void SingleOrAlbumInDiscographyAsSource::fill(const QString &strURL, const QStri
 
 int WikipediaArtistInfoBox::significance(const QString &, const QString &strTrackArtist, const QString &, int) const
 {
-    int i_significance = std::max(s_iMaxTolerableMatchingDifference - matchArtist(strTrackArtist),0);
+    int i_significance = std::max(s_iMaxTolerableMatchingDifference - matchArtist( strTrackArtist, s_iMaxTolerableMatchingDifference ),0);
     i_significance += 3*(m_lstGenres.isEmpty());
     return i_significance;
 }
@@ -213,8 +231,8 @@ int WikipediaArtistInfoBox::significance(const QString &, const QString &strTrac
 int WikipediaAlbumInfoBox::significance(const QString &strAlbumTitle, const QString &strTrackArtist, const QString &strTrackTitle, int iYear) const
 {
     int i_significance =  WikipediaArtistInfoBox::significance(strAlbumTitle,strTrackArtist,strTrackTitle,iYear);
-    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchAlbum( strAlbumTitle ),0);
-    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchTrackTitle(strTrackTitle),0);
+    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchAlbum( strAlbumTitle, s_iMaxTolerableMatchingDifference ),0);
+    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchTrackTitle( strTrackTitle, s_iMaxTolerableMatchingDifference ),0);
     i_significance += 3*(!(m_strCover.isEmpty()&&m_strCoverTitle.isEmpty())+!m_strYear.isEmpty());    
     i_significance += 2*std::max(0,(s_iMaxTolerableYearDifference-std::abs(m_strYear.toInt()-iYear)));
     
@@ -223,10 +241,67 @@ int WikipediaAlbumInfoBox::significance(const QString &strAlbumTitle, const QStr
 
 int SingleOrAlbumInDiscographyAsSource::significance(const QString &strAlbumTitle, const QString &strTrackArtist, const QString &strTrackTitle, int iYear) const
 {
-    int i_significance = std::max(s_iMaxTolerableMatchingDifference - matchArtist(strTrackArtist),0);
-    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchAlbum( strAlbumTitle ),0);
-    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchTrackTitle(strTrackTitle),0);
+    int i_significance = std::max(s_iMaxTolerableMatchingDifference - matchArtist( strTrackArtist, s_iMaxTolerableMatchingDifference ),0);
+    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchAlbum( strAlbumTitle, s_iMaxTolerableMatchingDifference ),0);
+    i_significance += std::max(s_iMaxTolerableMatchingDifference - matchTrackTitle( strTrackTitle, s_iMaxTolerableMatchingDifference ),0);
     i_significance += 3*(!m_strYear.isEmpty());
     i_significance += 2*std::max(0,(s_iMaxTolerableYearDifference-std::abs(m_strYear.toInt()-iYear)));
     return i_significance;
 }
+
+void WikipediaInfoBox::writeValues( QDataStream& rclStream ) const
+{
+    rclStream << m_strURL;
+}
+
+void WikipediaInfoBox::readValues( QDataStream& rclStream )
+{
+    rclStream >> m_strURL;
+}
+
+void WikipediaArtistInfoBox::save( QDataStream& rclStream ) const
+{
+    writeType( rclStream, Type::WikipediaArtistInfoBox );
+    writeValues( rclStream );
+}
+
+void WikipediaArtistInfoBox::writeValues( QDataStream& rclStream ) const
+{
+    WikipediaInfoBox::writeValues( rclStream );
+    rclStream << m_strArtist << m_lstGenres;
+}
+
+void WikipediaArtistInfoBox::readValues( QDataStream& rclStream )
+{
+    WikipediaInfoBox::readValues( rclStream );
+    rclStream >> m_strArtist >> m_lstGenres;
+}
+
+void WikipediaAlbumInfoBox::save( QDataStream& rclStream ) const
+{
+    writeType( rclStream, Type::WikipediaAlbumInfoBox );
+    writeValues( rclStream );
+}
+
+void WikipediaAlbumInfoBox::writeValues( QDataStream& rclStream ) const
+{
+    WikipediaArtistInfoBox::writeValues( rclStream );
+    rclStream << m_strCover << m_strYear << m_strCoverTitle << m_lstAlbums;
+}
+
+void WikipediaAlbumInfoBox::readValues( QDataStream& rclStream )
+{
+    WikipediaArtistInfoBox::readValues( rclStream );
+    rclStream >> m_strCover >> m_strYear >> m_strCoverTitle >> m_lstAlbums;
+}
+
+void SingleOrAlbumInDiscographyAsSource::save( QDataStream& rclStream ) const
+{
+    writeType( rclStream, Type::SingleOrAlbumInDiscographyAsSource );
+    rclStream << m_lstAlbums << m_strYear << m_strURL << m_strArtist;
+}
+
+void SingleOrAlbumInDiscographyAsSource::readValues( QDataStream& rclStream )
+{
+    rclStream >> m_lstAlbums >> m_strYear >> m_strURL >> m_strArtist;
+}
@@ -4,6 +4,7 @@
 #include <memory>
 #include <QStringList>
 #include "OnlineInfoSources.h"
+#include "WikiTextTokenizer.h"
 
 // see https://en.wikipedia.org/wiki/Wikipedia:List_of_infoboxes#Music
 
@@ -14,6 +15,7 @@ public:
     ~WikipediaInfoBox() override = default;
     void fill( const QString& strURL, const QStringList& lstAttributes );
     const QString& getURL() const override { return m_strURL; }
+    void readValues( QDataStream& rclStream ) override;
     
     static std::unique_ptr<WikipediaInfoBox> createForType( const QString& strType);
     static QStringList parseLinkLists( const QString& strLinkLists );
@@ -24,6 +26,7 @@ protected:
     static const int s_iMaxTolerableMatchingDifference = 3; //< maximum difference of artist/album/title match to be considered in significance value
     static const int s_iMaxTolerableYearDifference = 2; //< maximum difference of release year to be considered in significance value
     virtual void setValue( const QString& strKey, const QString& strValue ) = 0;
+    virtual void writeValues( QDataStream& rclStream ) const;
     QString m_strURL;
 };
 
@@ -39,8 +42,11 @@ public:
     
     int significance(const QString &strAlbumTitle, const QString &strTrackArtist, const QString &strTrackTitle, int iYear) const override;
     
+    void save( QDataStream& rclStream ) const override;
+    void readValues( QDataStream& rclStream ) override;
 protected:
     void setValue( const QString& strKey, const QString& strValue ) override;
+    void writeValues( QDataStream& rclStream ) const override;
     QString     m_strArtist;
     QStringList m_lstGenres;
 };
@@ -68,8 +74,12 @@ public:
     static QStringList matchedTypes();
     
     int significance(const QString &strAlbumTitle, const QString &strTrackArtist, const QString &strTrackTitle, int iYear) const override;
+    
+    void save( QDataStream& rclStream ) const override;
+    void readValues( QDataStream& rclStream ) override;
 protected:
     void setValue( const QString& strKey, const QString& strValue ) override;
+    void writeValues( QDataStream& rclStream ) const override;
     
     static QString m_strEmpty;
     QString m_strCover, m_strYear, m_strCoverTitle;
@@ -81,7 +91,7 @@ class SingleOrAlbumInDiscographyAsSource : public virtual OnlineAlbumInfoSource
 public:
     ~SingleOrAlbumInDiscographyAsSource() override = default;
     
-    static std::unique_ptr<SingleOrAlbumInDiscographyAsSource> find( const QString& strAlbum, const QString& strDiscographyPageContent );
+    static std::unique_ptr<SingleOrAlbumInDiscographyAsSource> find( const QString& strAlbum, const WikiTextTokenizer& rclPage, const WikiTextTokenizer::Section& rclSection );
     void fill( const QString& strURL, const QString& strArtist );
     
     const QString&     getArtist(size_t) const override { return m_strArtist; }
@@ -98,6 +108,9 @@ public:
     size_t getTrackLength(size_t) const override { return 0; }
     
     int significance(const QString &strAlbumTitle, const QString &strTrackArtist, const QString &strTrackTitle, int iYear) const override;
+    
+    void save( QDataStream& rclStream ) const override;
+    void readValues( QDataStream& rclStream ) override;
 protected:
     static const int s_iMaxTolerableMatchingDifference = 3; //< maximum difference of artist/album/title match to be considered in significance value
     static const int s_iMaxTolerableYearDifference = 2; //< maximum difference of release year to be considered in significance value
@@ -1,16 +1,16 @@
 #include "WikipediaParser.h"
 #include <QNetworkRequest>
 #include <QNetworkReply>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QThread>
 #include <QApplication>
 #include <QIcon>
 #include <QRegularExpressionMatchIterator>
 #include <QPainter>
+#include <QStandardPaths>
+#include <QDataStream>
 #include "WikipediaInfoSources.h"
-#include <Tools/CoverDownloader.h>
+#include "WikiTextTokenizer.h"
+#include <Tools/JsonStreamReader.h>
 
 WikipediaParser::WikipediaParser(QNetworkAccessManager *pclNetworkAccess, QObject *pclParent)
 : OnlineSourceParser(pclNetworkAccess,pclParent)
@@ -19,17 +19,21 @@ WikipediaParser::WikipediaParser(QNetworkAccessManager *pclNetworkAccess, QObjec
 , m_lruRedirects(10000)
 , m_lruContent(1000)
 , m_lruCoverImageURLs(10000)
+, m_pclStoredResults( PersistentResultStore::forDirectory( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + "/parsed_results" ) )
 {
     downloadFavicon(pclNetworkAccess);
 }
 
 
-WikipediaParser::~WikipediaParser() = default;
+WikipediaParser::~WikipediaParser()
+{
+    stopParserThreads();
+}
 
-bool WikipediaParser::getContentFromCacheAndQueryMissing( const QStringList& lstTitles )
+bool WikipediaParser::getContentFromCacheAndQueryMissing( const QStringList& lstTitles, const Query& rclQuery )
 {
     // look in LRU for each title before sending
-    QStringList lst_non_cached = getContentFromCache( lstTitles );
+    QStringList lst_non_cached = getContentFromCache( lstTitles, rclQuery );
     if ( lst_non_cached.isEmpty() )
         return false;
     else
@@ -48,15 +52,15 @@ bool WikipediaParser::getCoverImageURLsFromCacheAndQueryMissing( const QStringLi
     return true;
 }
 
-bool WikipediaParser::getSearchResultFromCacheAndQueryMissing( const QString& strQuery )
+bool WikipediaParser::getSearchResultFromCacheAndQueryMissing( const QString& strSearch, const Query& rclQuery )
 {
-    QStringList* lst_content_titles = m_lruSearchResults[strQuery];
-    if ( lst_content_titles != nullptr )
+    std::optional<QStringList> lst_content_titles = m_lruSearchResults.object(strSearch);
+    if ( lst_content_titles )
         // the result to the search was cached... great.
         // however, maybe there is still work to be done in resolving the title URLs...
-        return resolveTitleURLs( *lst_content_titles );
+        return resolveTitleURLs( *lst_content_titles, rclQuery );
     else
-        emit sendQuery( createSearchRequest(QUrl::toPercentEncoding(strQuery)), SLOT(replyReceived()) );
+        emit sendQuery( createSearchRequest(QUrl::toPercentEncoding(strSearch)), SLOT(replyReceived()) );
     return true;
 }
 
@@ -65,8 +69,10 @@ QStringList WikipediaParser::getCoverImageURLsFromCache( const QStringList& lstC
     QStringList lst_noncached_titles;
     for ( const QString& strTitle : lstCoverImageTitles )
     {
-        QString* map_parsed_URL = m_lruCoverImageURLs[strTitle];
-        if ( map_parsed_URL != nullptr )
+        std::optional<QString> map_parsed_URL = m_lruCoverImageURLs.object(strTitle);
+        if ( !map_parsed_URL && ( map_parsed_URL = m_pclStoredResults->object<QString>( storeKey("cover",strTitle) ) ) )
+            m_lruCoverImageURLs.insert( strTitle, *map_parsed_URL );
+        if ( map_parsed_URL )
             // no need to query wikipedia again, we still have the content for this title in cache
             // replace with cached url
             replaceCoverImageURL( strTitle, *map_parsed_URL );
@@ -76,18 +82,29 @@ QStringList WikipediaParser::getCoverImageURLsFromCache( const QStringList& lstC
     return lst_noncached_titles;
 }
 
-QStringList WikipediaParser::getContentFromCache( const QStringList& lstTitles )
+QStringList WikipediaParser::getContentFromCache( const QStringList& lstTitles, const Query& rclQuery )
 {
     QStringList lst_noncached_titles;
     for ( const QString& strTitle : lstTitles )
     {
         for ( const QString & str_redirected_title : getRedirectsFromCache(strTitle) )
         {
-            SectionsToInfo* map_parsed_infos = m_lruContent[strTitle];
-            if ( map_parsed_infos != nullptr )
+            std::optional<SectionsToInfo> map_parsed_infos = getCachedContent(str_redirected_title, rclQuery);
+            if ( map_parsed_infos )
+            {
                 // no need to query wikipedia again, we still have the content in cache
                 // insert parsed infos into current info table
-                m_mapParsedInfos.insert( map_parsed_infos->begin(), map_parsed_infos->end() );
+                m_mapParsedInfos.modify( [&map_parsed_infos]( SectionsToInfo& rmapInfos ) { rmapInfos.insert( map_parsed_infos->begin(), map_parsed_infos->end() ); } );
+                // cached boxes do not contain their cover URL, but it might be cached as well
+                QStringList lst_cover_titles;
+                for ( const auto& rcl_item : *map_parsed_infos )
+                {
+                    auto pcl_album_box = std::dynamic_pointer_cast<WikipediaAlbumInfoBox>(rcl_item.second);
+                    if ( pcl_album_box && !pcl_album_box->getCoverTitle().isEmpty() )
+                        lst_cover_titles << "File:"+pcl_album_box->getCoverTitle();
+                }
+                getCoverImageURLsFromCache( lst_cover_titles );
+            }
             else
                 lst_noncached_titles << str_redirected_title;
         }
@@ -97,7 +114,9 @@ QStringList WikipediaParser::getContentFromCache( const QStringList& lstTitles )
 
 QStringList WikipediaParser::getRedirectsFromCache( const QString& strTitle )
 {
-    QStringList* lst_redirects = m_lruRedirects[strTitle];
+    std::optional<QStringList> lst_redirects = m_lruRedirects.object(strTitle);
+    if ( !lst_redirects && ( lst_redirects = m_pclStoredResults->object<QStringList>( storeKey("redirects",strTitle) ) ) )
+        m_lruRedirects.insert( strTitle, *lst_redirects );
     if ( lst_redirects )
         return QStringList(*lst_redirects) << strTitle; // add self
     else
@@ -129,29 +148,29 @@ void WikipediaParser::sendRequests( const QString& trackArtist, const QString& t
 {
     // clear the previous results
     clearResults();
-    m_strAlbumTitle  = albumTitle;
-    m_strTrackTitle  = trackTitle;
-    m_strTrackArtist = trackArtist;
-    m_iYear = iYear;
+    m_clQuery.strAlbumTitle  = albumTitle;
+    m_clQuery.strTrackTitle  = trackTitle;
+    m_clQuery.strTrackArtist = trackArtist;
+    m_clQuery.iYear = iYear;
     
     // the track artist could also be combination of artist name (e.g. "feat." or "&" or "with"
     QStringList lst_artists = trackArtist.split( QRegularExpression("\\s(feat\\.|&|and|with|featuring)\\s", QRegularExpression::CaseInsensitiveOption), QString::SkipEmptyParts );
     lst_artists << trackArtist;
     lst_artists.removeDuplicates();
         
-    bool b_any_queries_underway = resolveTitleURLs( createTitleRequests( lst_artists, trackTitle, albumTitle ) );
+    bool b_any_queries_underway = resolveTitleURLs( createTitleRequests( lst_artists, trackTitle, albumTitle ), m_clQuery );
     if ( !b_any_queries_underway )
-        allContentAdded();
+        allContentAdded( m_clQuery );
 }
 
 void WikipediaParser::clearResults()
 {
     m_mapParsedInfos.clear();
-    m_lstParsedPages.clear();
-    m_strAlbumTitle.clear();
-    m_strTrackTitle.clear();
-    m_strTrackArtist.clear();
-    m_iYear = -1;
+    {
+        QMutexLocker cl_lock( &m_clParsedPagesMutex );
+        m_lstParsedPages.clear();
+    }
+    m_clQuery = Query();
     m_bSearchConducted = false;
     
     //cancel any pending requests
@@ -167,9 +186,9 @@ void WikipediaParser::parseFromURL(const QUrl &rclUrl)
     // get the title from the URL
     QString str_title = rclUrl.path().split( "/" ).back();
     
-    bool b_any_queries_underway = resolveTitleURLs( QStringList(str_title) );
+    bool b_any_queries_underway = resolveTitleURLs( QStringList(str_title), m_clQuery );
     if ( !b_any_queries_underway )
-        allContentAdded();
+        allContentAdded( m_clQuery );
 }
 
 
@@ -184,7 +203,7 @@ void WikipediaParser::replyReceived()
     switch ( pcl_reply->error() )
     {
     case QNetworkReply::NoError:
-        startParserThread( pcl_reply->readAll(), [this](QByteArray strReply){ parseWikipediaAPIJSONReply( std::move(strReply) ); } );
+        startParserThread( pcl_reply->readAll(), [this,cl_query = m_clQuery](QByteArray strReply){ parseWikipediaAPIJSONReply( std::move(strReply), cl_query ); } );
         break;
     case QNetworkReply::OperationCanceledError:
         emit info( QString("Network reply to %1 was canceled").arg(pcl_reply->url().toString()) );
@@ -198,26 +217,26 @@ void WikipediaParser::replyReceived()
 
 
 
-bool WikipediaParser::resolveTitleURLs(QStringList lstTitles)
+bool WikipediaParser::resolveTitleURLs(QStringList lstTitles, const Query& rclQuery)
 {
     lstTitles.removeDuplicates();
     for ( QString& str_title : lstTitles )
          str_title = QUrl::toPercentEncoding(str_title);
     if ( !lstTitles.isEmpty() )
-        return getContentFromCacheAndQueryMissing( lstTitles );
+        return getContentFromCacheAndQueryMissing( lstTitles, rclQuery );
     else
         emit error("unable to query wikipedia without either artist, title or album information");
     return false;
 }
 
-bool WikipediaParser::resolveSearchQueries(QStringList lstQueries)
+bool WikipediaParser::resolveSearchQueries(QStringList lstQueries, const Query& rclQuery)
 {
     lstQueries.removeDuplicates();
     if ( !lstQueries.isEmpty() )
     {
         bool b_search_query_underway = false;
         for ( const QString& str_query : lstQueries )
-            b_search_query_underway |= getSearchResultFromCacheAndQueryMissing( str_query );
+            b_search_query_underway |= getSearchResultFromCacheAndQueryMissing( str_query, rclQuery );
         return b_search_query_underway;
     }
     else
@@ -237,79 +256,182 @@ bool WikipediaParser::resolveCoverImageURLs( QStringList lstCoverImageTitles )
     return false;
 }
 
-static QString reverseNormalization( QString strTitle, const QJsonArray& arrNormalizations )
+// reads the first object of the array value of the current name. Its string members listed in lstNames are returned in that order
+static QStringList readFirstArrayObject( JsonStreamReader& rclReader, const QStringList& lstNames )
 {
-    for ( const QJsonValue& rcl_normalization : arrNormalizations )
+    QStringList lst_values;
+    for ( int i_name = 0; i_name < lstNames.size(); ++i_name )
+        lst_values << QString();
+    if ( rclReader.readNext() != JsonStreamReader::StartArray )
     {
-        if ( rcl_normalization.toObject()["to"].toString().compare( strTitle ) == 0 )
-            return rcl_normalization.toObject()["from"].toString();
+        rclReader.skipValue();
+        return lst_values;
     }
-    return strTitle;
+    for ( bool b_first = true; rclReader.readNextElement(); b_first = false )
+    {
+        if ( !b_first || rclReader.tokenType() != JsonStreamReader::StartObject )
+        {
+            rclReader.skipValue();
+            continue;
+        }
+        while ( rclReader.readNextMember() )
+        {
+            int i_name = lstNames.indexOf( rclReader.text() );
+            if ( i_name >= 0 )
+                lst_values[i_name] = rclReader.readString();
+            else
+                rclReader.skipValue();
+        }
+    }
+    return lst_values;
 }
 
-
-
-void WikipediaParser::parseWikipediaAPIJSONReply( QByteArray strReply )
+void WikipediaParser::parseWikipediaAPIJSONReply( QByteArray strReply, const Query& rclQuery )
 {
-    QJsonDocument cl_doc = QJsonDocument::fromJson(strReply);
-    // find the relevant information
-    if ( !cl_doc.isObject() )
+    // the reply is read as a stream, so the wikitext of every page is parsed as soon as it has been read,
+    // instead of holding the content of all pages at once
+    JsonStreamReader cl_reader( std::move(strReply) );
+    if ( cl_reader.readNext() != JsonStreamReader::StartObject )
     {
         emit error("received an invalid JSON reply");
         return;
     }
-    QJsonObject cl_query_object = cl_doc.object()["query"].toObject();
-    QJsonObject arr_pages         = cl_query_object["pages"].toObject();
-    QJsonArray arr_search_results = cl_query_object["search"].toArray();
-    QStringList lst_error_pages, lst_cover_images, lst_redirect_titles;
-    for ( const QJsonValue& rcl_page : arr_pages )
-    {
-        QJsonObject cl_page = rcl_page.toObject();
-        QString str_title = cl_page["title"].toString();
-        if ( m_lstParsedPages.contains(str_title) )
-            continue;
+    QStringList lst_error_pages, lst_cover_images, lst_redirect_titles, lst_search_titles;
+    std::map<QString,QString> map_normalizations;             // normalized title to requested title
+    std::vector<std::pair<QString,QString>> vec_cover_urls; // resolved once the normalizations are known
+    
+    auto fun_parse_page = [&]{
+        QString str_title, str_content, str_url;
+        bool b_missing = false, b_has_content = false, b_has_image_info = false;
+        while ( cl_reader.readNextMember() )
+        {
+            QString str_name = cl_reader.text();
+            if ( str_name == "title" )
+                str_title = cl_reader.readString();
+            else if ( str_name == "missing" )
+            {
+                b_missing = true;
+                cl_reader.skipValue();
+            }
+            else if ( str_name == "revisions" )
+            {
+                b_has_content = true;
+                str_content = readFirstArrayObject( cl_reader, {"*"} ).front();
+            }
+            else if ( str_name == "imageinfo" )
+            {
+                b_has_image_info = true;
+                str_url = readFirstArrayObject( cl_reader, {"url"} ).front();
+            }
+            else
+                cl_reader.skipValue();
+        }
+        if ( cl_reader.hasError() || isPageParsed(str_title) )
+            return;
         
-        if ( !cl_page.contains("missing") )
+        if ( !b_missing )
         {
-            m_lstParsedPages << str_title;
-            if ( cl_page.contains("revisions") ) // reply contains wikitext content
+            if ( !markPageParsed(str_title) ) // parsed by another thread in the meantime
+                return;
+            if ( b_has_content ) // reply contains wikitext content
             {
-                QString str_content = cl_page["revisions"].toArray()[0].toObject()["*"].toString();
                 if ( !str_content.isEmpty() )
                 {
-                    parseWikiText( std::move(str_title), std::move(str_content), lst_cover_images, lst_redirect_titles );
-                    continue;
+                    parseWikiText( std::move(str_title), std::move(str_content), rclQuery, lst_cover_images, lst_redirect_titles );
+                    return;
                 }
             }
-            else if ( cl_page.contains("imageinfo") ) // reply contains image URLs
+            else if ( b_has_image_info ) // reply contains image URLs
             {
-                QString str_url = cl_page["imageinfo"].toArray()[0].toObject()["url"].toString();
                 if ( !str_url.isEmpty() )
                 {
-                    // check if title has been normalized and invert
-                    str_title = reverseNormalization(std::move(str_title), cl_query_object["normalized"].toArray());
-                    
-                    // add URL to lru cache for later
-                    m_lruCoverImageURLs.insert(str_title, new QString(str_title) );
-                    
-                    // replace in content
-                    replaceCoverImageURL( std::move(str_title), std::move(str_url) );
-                    continue;
+                    vec_cover_urls.emplace_back( std::move(str_title), std::move(str_url) );
+                    return;
                 }
             }
         }
         // add entry to LRU, so we don't try to query the missing title again!
-        m_lruContent.insert( QUrl::toPercentEncoding(str_title), new SectionsToInfo() );
+        cacheContent( QUrl::toPercentEncoding(str_title), SectionsToInfo(), rclQuery );
         
         // and mark as error page
         lst_error_pages << str_title;
+    };
+    
+    while ( cl_reader.readNextMember() )
+    {
+        if ( cl_reader.text() != "query" || cl_reader.readNext() != JsonStreamReader::StartObject )
+        {
+            cl_reader.skipValue();
+            continue;
+        }
+        while ( cl_reader.readNextMember() )
+        {
+            QString str_name = cl_reader.text();
+            JsonStreamReader::TokenType e_value = cl_reader.readNext();
+            if ( str_name == "pages" && e_value == JsonStreamReader::StartObject )
+            {
+                while ( cl_reader.readNextMember() ) // keyed by page id
+                {
+                    if ( cl_reader.readNext() == JsonStreamReader::StartObject )
+                        fun_parse_page();
+                    else
+                        cl_reader.skipValue();
+                }
+            }
+            else if ( ( str_name == "search" || str_name == "normalized" ) && e_value == JsonStreamReader::StartArray )
+            {
+                while ( cl_reader.readNextElement() )
+                {
+                    if ( cl_reader.tokenType() != JsonStreamReader::StartObject )
+                    {
+                        cl_reader.skipValue();
+                        continue;
+                    }
+                    QString str_title, str_from, str_to;
+                    while ( cl_reader.readNextMember() )
+                    {
+                        QString str_member = cl_reader.text();
+                        if ( str_member == "title" )
+                            str_title = cl_reader.readString();
+                        else if ( str_member == "from" )
+                            str_from = cl_reader.readString();
+                        else if ( str_member == "to" )
+                            str_to = cl_reader.readString();
+                        else
+                            cl_reader.skipValue();
+                    }
+                    if ( str_name == "search" )
+                        lst_search_titles << str_title;
+                    else if ( !str_to.isEmpty() )
+                        map_normalizations.emplace( str_to, str_from );
+                }
+            }
+            else
+                cl_reader.skipValue();
+        }
     }
-    for ( const QJsonValue& rcl_result : arr_search_results )
+    if ( cl_reader.hasError() )
+        emit error( QString("received an invalid JSON reply: %1").arg(cl_reader.errorString()) );
+    
+    for ( auto& rcl_cover_url : vec_cover_urls )
     {
-        QJsonObject cl_result = rcl_result.toObject();
-        QString str_title = cl_result["title"].toString();
-        if ( !m_lstParsedPages.contains(str_title) )
-            lst_redirect_titles << str_title;
+        // check if title has been normalized and invert
+        QString str_title = std::move(rcl_cover_url.first);
+        auto it_normalization = map_normalizations.find( str_title );
+        if ( it_normalization != map_normalizations.end() )
+            str_title = it_normalization->second;
+        
+        // add URL to lru cache for later
+        m_lruCoverImageURLs.insert( str_title, rcl_cover_url.second );
+        m_pclStoredResults->insertObject( storeKey("cover",str_title), rcl_cover_url.second );
+        
+        // replace in content
+        replaceCoverImageURL( std::move(str_title), std::move(rcl_cover_url.second) );
+    }
+    for ( QString& str_title : lst_search_titles )
+    {
+        if ( !isPageParsed(str_title) )
+            lst_redirect_titles << std::move(str_title);
     }
     
     bool b_more_queries_underway = false;
@@ -321,87 +443,113 @@ void WikipediaParser::parseWikipediaAPIJSONReply( QByteArray strReply )
     if ( !lst_redirect_titles.empty() )
     {
         // make another call to resolve all redirect URLs
-        b_more_queries_underway |= resolveTitleURLs(std::move(lst_redirect_titles));
+        b_more_queries_underway |= resolveTitleURLs(std::move(lst_redirect_titles), rclQuery);
     }
     if ( !b_more_queries_underway )
-        allContentAdded();
+        allContentAdded( rclQuery );
     // verbose info:
+    QStringList lst_parsed_pages = parsedPages();
     emit info( QString("found %1 pages: %2\nfailed for %3 pages: %4")
-                              .arg(m_lstParsedPages.size()).arg(m_lstParsedPages.join("; "))
+                              .arg(lst_parsed_pages.size()).arg(lst_parsed_pages.join("; "))
                               .arg(lst_error_pages.size()).arg(lst_error_pages.join("; ")) );
 }
 
-void WikipediaParser::allContentAdded()
+void WikipediaParser::allContentAdded( const Query& rclQuery )
 {
-    if ( m_mapParsedInfos.empty() && !m_bSearchConducted )
+    // only one thread gets to start the search
+    if ( m_mapParsedInfos.snapshot()->empty() && !m_bSearchConducted.exchange(true) )
     {
         //nothing found yet... desperately attempt to make a title search first
-        m_bSearchConducted = true;
-        resolveSearchQueries( QStringList() << m_strTrackArtist << m_strAlbumTitle << m_strTrackTitle );
+        resolveSearchQueries( QStringList() << rclQuery.strTrackArtist << rclQuery.strAlbumTitle << rclQuery.strTrackTitle, rclQuery );
     }
     else
-        emit parsingFinished(getPages());
+        emit parsingFinished(getPages(rclQuery));
 }
 
 void WikipediaParser::downloadFavicon(QNetworkAccessManager *pclNetworkAccess)
 {
-    CoverDownloader* pcl_downloader = new CoverDownloader( pclNetworkAccess, this );
-    connect( pcl_downloader, &CoverDownloader::imageReady, [this,pcl_downloader]{
-        m_pclIcon = std::make_unique<QIcon>( overlayLanguageHint( pcl_downloader->getImage() ) );
-        pcl_downloader->deleteLater();
+    downloadIcon( pclNetworkAccess, QUrl("https://en.wikipedia.org/favicon.ico"), [this]( const QPixmap& rclIcon ) {
+        m_pclIcon = std::make_unique<QIcon>( overlayLanguageHint( rclIcon ) );
     } );
-    pcl_downloader->downloadImage( QUrl("https://en.wikipedia.org/favicon.ico") );
 }
 
 void WikipediaParser::replaceCoverImageURL( QString strTitle, QString strURL )
 {
-    for ( auto & rcl_item : m_mapParsedInfos )
-    {
-        auto pcl_album_box = std::dynamic_pointer_cast<WikipediaAlbumInfoBox>(rcl_item.second);
-        if ( pcl_album_box && strTitle.compare( "File:"+pcl_album_box->getCoverTitle(), Qt::CaseInsensitive ) == 0 )
-            pcl_album_box->setCover( strURL );
-    }
+    m_mapParsedInfos.modify( [&]( SectionsToInfo& rmapInfos ) {
+        for ( auto & rcl_item : rmapInfos )
+        {
+            auto pcl_album_box = std::dynamic_pointer_cast<WikipediaAlbumInfoBox>(rcl_item.second);
+            if ( pcl_album_box && strTitle.compare( "File:"+pcl_album_box->getCoverTitle(), Qt::CaseInsensitive ) == 0 )
+            {
+                // published boxes might be in use by other threads, so they are replaced by a modified copy
+                auto pcl_copy = std::make_shared<WikipediaAlbumInfoBox>( *pcl_album_box );
+                pcl_copy->setCover( strURL );
+                rcl_item.second = std::move(pcl_copy);
+            }
+        }
+    } );
+}
+
+bool WikipediaParser::isPageParsed( const QString& strTitle ) const
+{
+    QMutexLocker cl_lock( &m_clParsedPagesMutex );
+    return m_lstParsedPages.contains(strTitle);
 }
 
-static std::list<std::unique_ptr<WikipediaInfoBox>> getInfoBoxes(const QString& strTitle, const QString& strContent)
+bool WikipediaParser::markPageParsed( const QString& strTitle )
 {
+    QMutexLocker cl_lock( &m_clParsedPagesMutex );
+    if ( m_lstParsedPages.contains(strTitle) )
+        return false;
+    m_lstParsedPages << strTitle;
+    return true;
+}
+
+QStringList WikipediaParser::parsedPages() const
+{
+    QMutexLocker cl_lock( &m_clParsedPagesMutex );
+    return m_lstParsedPages;
+}
+
+static std::list<std::unique_ptr<WikipediaInfoBox>> getInfoBoxes( const QString& strTitle, const WikiTextTokenizer& rclPage, const WikiTextTokenizer::Section& rclSection )
+{
+    static const QRegularExpression re_box_name("^\\s*Infobox\\s+", QRegularExpression::CaseInsensitiveOption);
     std::list<std::unique_ptr<WikipediaInfoBox>> lst_boxes;
-    QRegularExpression re_box_syntax("{{\\s*Infobox\\s+", QRegularExpression::CaseInsensitiveOption);
-    QRegularExpressionMatchIterator it_matches = re_box_syntax.globalMatch(strContent);
-    while (it_matches.hasNext()) {
-        QRegularExpressionMatch cl_match = it_matches.next();
-        int i_start_of_content;
-        i_start_of_content = cl_match.capturedEnd(0);
+    const auto& vec_tokens = rclPage.tokens();
+    for ( int i_token = rclSection.iFirstToken; i_token+1 < rclSection.iEndToken; ++i_token )
+    {
+        if ( vec_tokens[i_token].eType != WikiTextTokenizer::TemplateStart || vec_tokens[i_token+1].eType != WikiTextTokenizer::Text )
+            continue;
+        QRegularExpressionMatch cl_match = re_box_name.match( rclPage.text( vec_tokens[i_token+1] ) );
+        if ( !cl_match.hasMatch() )
+            continue;
         
-        // Look for for the matching closing pair of "}}". Watch out for possible nested {{}} lists...
+        // split at the separators in the box' context up to the matching closing pair of "}}". Watch out for nested templates and links...
         QStringList lst_items;
+        int i_start_of_content = vec_tokens[i_token+1].iBegin + cl_match.capturedEnd(0);
+        int i_first_item_token = i_token+1;
         int i_open_count = 1, i_link_open_count = 0;
-        for ( int i_current_char = i_start_of_content; i_current_char < strContent.size()-1; ++i_current_char )
+        for ( int i_box_token = i_token+2; i_box_token < rclSection.iEndToken && i_open_count > 0; ++i_box_token )
         {
-            if ( strContent[i_current_char] == QChar('{') && strContent[i_current_char+1] == QChar('{') )
-                i_open_count++;
-            else if ( strContent[i_current_char] == QChar('}') && strContent[i_current_char+1] == QChar('}') )
-                i_open_count--;
-            else if ( strContent[i_current_char] == QChar('[') && strContent[i_current_char+1] == QChar('[') )
-                i_link_open_count++;
-            else if ( strContent[i_current_char] == QChar(']') && strContent[i_current_char+1] == QChar(']') )
-                i_link_open_count--;
-            if ( i_open_count == 0 )
+            const WikiTextTokenizer::Token& rcl_token = vec_tokens[i_box_token];
+            switch ( rcl_token.eType )
             {
-                int i_length = i_current_char-i_start_of_content-1;
-                if ( i_length > 0 )
-                    lst_items << QStringRef( &strContent, i_start_of_content, i_length ).toString();
-                break;
+            case WikiTextTokenizer::TemplateStart: ++i_open_count; break;
+            case WikiTextTokenizer::TemplateEnd:   --i_open_count; break;
+            case WikiTextTokenizer::LinkStart:     ++i_link_open_count; break;
+            case WikiTextTokenizer::LinkEnd:       --i_link_open_count; break;
+            default: break;
             }
-            if ( strContent[i_current_char] == QChar('|') && i_open_count == 1 && i_link_open_count < 1 ) // we encountered a content separator in the box' context
+            if ( i_open_count == 0 || ( rcl_token.eType == WikiTextTokenizer::Separator && i_open_count == 1 && i_link_open_count < 1 ) )
             {
-                int i_length = i_current_char-i_start_of_content;
-                if ( i_length > 0 )
-                    lst_items << QStringRef( &strContent, i_start_of_content, i_length ).toString();
-                i_start_of_content = i_current_char+1;
+                QString str_item = rclPage.textWithoutComments( i_start_of_content, rcl_token.iBegin, i_first_item_token );
+                if ( !str_item.isEmpty() )
+                    lst_items << std::move(str_item);
+                i_start_of_content = rcl_token.iEnd;
+                i_first_item_token = i_box_token+1;
             }
         }
-        if ( lst_items.empty() ) // no content (?!) or didn't find matching closing brackets
+        if ( lst_items.empty() ) // no content (?!)
             continue;
         
         QString str_type = lst_items.front().simplified().toLower();
@@ -416,59 +564,50 @@ static std::list<std::unique_ptr<WikipediaInfoBox>> getInfoBoxes(const QString&
     return lst_boxes;
 }
 
-void WikipediaParser::parseWikiText( QString strTitle, QString strContent, QStringList& lstCoverImages, QStringList& lstRedirectTitles )
+void WikipediaParser::parseWikiText( QString strTitle, QString strContent, const Query& rclQuery, QStringList& lstCoverImages, QStringList& lstRedirectTitles )
 {    
     // check if content is a simple redirect
     if ( strContent.startsWith( "#REDIRECT", Qt::CaseInsensitive ) || strContent.startsWith("#WEITERLEITUNG", Qt::CaseInsensitive) )
     {
+        QStringList lst_encoded_redirects; // cached like the titles they are looked up with
         for ( QString& str_link : WikipediaInfoBox::parseLinkLists( strContent ) )
+        {
             lstRedirectTitles << WikipediaInfoBox::getLinkPartOfLink( str_link );
-        if ( !lstRedirectTitles.isEmpty() )
-            m_lruRedirects.insert( strTitle, new QStringList(lstRedirectTitles) );
-    }
-    
-    // remove any HTML comments
-    strContent.remove(QRegularExpression("<!--.*-->"));
-    
-    // split content into sections
-    QRegularExpression re_section_heading("[^=]==([^=].*[^=])==[^=]");
-    QStringList lst_sections = strContent.split(re_section_heading);
-    QRegularExpressionMatchIterator it_matches = re_section_heading.globalMatch(strContent);
-    QStringList lst_headings;
-    while (it_matches.hasNext()) {
-        QRegularExpressionMatch cl_match = it_matches.next();
-        QString str_heading = cl_match.captured(1);
-        lst_headings << str_heading;
+            lst_encoded_redirects << QUrl::toPercentEncoding( lstRedirectTitles.back() );
+        }
+        if ( !lst_encoded_redirects.isEmpty() )
+        {
+            QString str_encoded_title = QUrl::toPercentEncoding( strTitle );
+            m_pclStoredResults->insertObject( storeKey("redirects",str_encoded_title), lst_encoded_redirects );
+            m_lruRedirects.insert( str_encoded_title, std::move(lst_encoded_redirects) );
+        }
     }
-    // there must always be exactly one more section than headings (the text before the first heading match).
-    // we assign this one an empty heading
-    lst_headings.push_front("");
     
-    std::unique_ptr<SectionsToInfo> map_parsed_infos = std::make_unique<SectionsToInfo>();
-
-    // now headings and sections match and can be iterated in sync.
-    auto it_heading = lst_headings.begin();
-    auto it_section = lst_sections.begin();
-    for ( int i = 0; i < lst_sections.size(); ++i, ++it_heading, ++it_section )
+    // one scan for comments, headings, templates, links and table rows. Sections are split at second level headings
+    WikiTextTokenizer cl_page( strContent );
+    SectionsToInfo map_parsed_infos;
+    bool b_is_discography = matchesDiscography(strTitle);
+    for ( const WikiTextTokenizer::Section& rcl_section : cl_page.sections() )
     {
+        QString str_heading = rcl_section.strHeading.toString();
         std::list<std::shared_ptr<OnlineInfoSource>> lst_infos;
-        if ( matchesDiscography(strTitle) ) // handle discrography pages different than content pages
+        if ( b_is_discography ) // handle discrography pages different than content pages
         {
-            for ( const QString& str_album_title : { m_strAlbumTitle, m_strTrackTitle } )
+            for ( const QString& str_album_title : { rclQuery.strAlbumTitle, rclQuery.strTrackTitle } )
             {
-                auto pcl_discography_info = SingleOrAlbumInDiscographyAsSource::find( str_album_title, *it_section );
+                auto pcl_discography_info = SingleOrAlbumInDiscographyAsSource::find( str_album_title, cl_page, rcl_section );
                 if ( pcl_discography_info )
                 {
-                    pcl_discography_info->fill( lemma2URL(strTitle,*it_heading), m_strTrackArtist );
+                    pcl_discography_info->fill( lemma2URL(strTitle,str_heading), rclQuery.strTrackArtist );
                     lst_infos.emplace_back( std::dynamic_pointer_cast<OnlineInfoSource,SingleOrAlbumInDiscographyAsSource>( std::move(pcl_discography_info)) );
                 }
             }
-            emit info( QString("found %1 discography entries on page %2, section %3").arg(lst_infos.size()).arg(strTitle,*it_heading) );
+            emit info( QString("found %1 discography entries on page %2, section %3").arg(lst_infos.size()).arg(strTitle,str_heading) );
         }
         else
         {
-            auto lst_boxes = getInfoBoxes( lemma2URL(strTitle,*it_heading), *it_section );              
-            emit info( QString("found %1 boxes on page %2, section %3").arg(lst_boxes.size()).arg(strTitle,*it_heading) );
+            auto lst_boxes = getInfoBoxes( lemma2URL(strTitle,str_heading), cl_page, rcl_section );
+            emit info( QString("found %1 boxes on page %2, section %3").arg(lst_boxes.size()).arg(strTitle,str_heading) );
             for ( auto & pcl_box : lst_boxes )
             {
                 lst_infos.emplace_back( std::dynamic_pointer_cast<OnlineInfoSource,WikipediaInfoBox>( std::move(pcl_box) ) );
@@ -479,18 +618,72 @@ void WikipediaParser::parseWikiText( QString strTitle, QString strContent, QStri
         }
         int i_counter = 0;
         QString str_entry = strTitle;
-        if ( !it_heading->isEmpty() ) 
-            str_entry.append( " - "+*it_heading );
+        if ( !str_heading.isEmpty() ) 
+            str_entry.append( " - "+str_heading );
         
         for ( auto & pcl_info : lst_infos )
-            (*map_parsed_infos)[ (lst_infos.size() == 1) ? str_entry : (str_entry + " ("+QString::number(++i_counter) + ")") ] = std::move(pcl_info);
+            map_parsed_infos[ (lst_infos.size() == 1) ? str_entry : (str_entry + " ("+QString::number(++i_counter) + ")") ] = std::move(pcl_info);
     }
     
     // insert parsed infos into current info table
-    m_mapParsedInfos.insert( map_parsed_infos->begin(), map_parsed_infos->end() );
+    m_mapParsedInfos.modify( [&map_parsed_infos]( SectionsToInfo& rmapInfos ) { rmapInfos.insert( map_parsed_infos.begin(), map_parsed_infos.end() ); } );
     
     // and insert parsed infos into LRU
-    m_lruContent.insert( QUrl::toPercentEncoding(strTitle), map_parsed_infos.release() );
+    cacheContent( QUrl::toPercentEncoding(strTitle), std::move(map_parsed_infos), rclQuery );
+}
+
+QString WikipediaParser::storeKey( const char* pcType, const QString& strTitle ) const
+{
+    return QString("wikipedia/%1/%2/%3").arg( m_strLanguageSubDomain, pcType, strTitle );
+}
+
+QString WikipediaParser::contentStoreKey( const QString& strTitle, const Query& rclQuery ) const
+{
+    QString str_key = storeKey( "content", strTitle );
+    // the entries found on discography pages depend on the requested album
+    if ( matchesDiscography( QUrl::fromPercentEncoding( strTitle.toUtf8() ) ) )
+        str_key += QString("/%1/%2/%3").arg( rclQuery.strTrackArtist, rclQuery.strAlbumTitle, rclQuery.strTrackTitle );
+    return str_key;
+}
+
+std::optional<WikipediaParser::SectionsToInfo> WikipediaParser::getCachedContent( const QString& strTitle, const Query& rclQuery )
+{
+    std::optional<SectionsToInfo> map_parsed_infos = m_lruContent.object(strTitle);
+    if ( map_parsed_infos )
+        return map_parsed_infos;
+    // maybe the title was parsed in an earlier session
+    std::optional<QByteArray> arr_stored = m_pclStoredResults->value( contentStoreKey(strTitle,rclQuery) );
+    if ( !arr_stored )
+        return std::nullopt;
+    map_parsed_infos = SectionsToInfo();
+    QDataStream cl_stream( *arr_stored );
+    quint32 ui_num_infos = 0;
+    cl_stream >> ui_num_infos;
+    for ( quint32 ui_info = 0; ui_info < ui_num_infos; ++ui_info )
+    {
+        QString str_entry;
+        cl_stream >> str_entry;
+        std::shared_ptr<OnlineInfoSource> pcl_info = OnlineInfoSource::load( cl_stream );
+        if ( !pcl_info ) // stored by an incompatible version
+            return std::nullopt;
+        (*map_parsed_infos)[str_entry] = std::move(pcl_info);
+    }
+    m_lruContent.insert( strTitle, *map_parsed_infos );
+    return map_parsed_infos;
+}
+
+void WikipediaParser::cacheContent( const QString& strTitle, SectionsToInfo mapInfos, const Query& rclQuery )
+{
+    QByteArray arr_stored;
+    QDataStream cl_stream( &arr_stored, QIODevice::WriteOnly );
+    cl_stream << static_cast<quint32>( mapInfos.size() );
+    for ( const auto& rcl_item : mapInfos )
+    {
+        cl_stream << rcl_item.first;
+        rcl_item.second->save( cl_stream );
+    }
+    m_pclStoredResults->insert( contentStoreKey(strTitle,rclQuery), arr_stored );
+    m_lruContent.insert( strTitle, std::move(mapInfos) );
 }
 
 QString WikipediaParser::lemma2URL(QString strLemma, QString strSection) const
@@ -503,12 +696,18 @@ QString WikipediaParser::lemma2URL(QString strLemma, QString strSection) const
 }
 
 QStringList WikipediaParser::getPages() const
+{
+    return getPages( m_clQuery );
+}
+
+QStringList WikipediaParser::getPages( const Query& rclQuery ) const
 {
     // get pages, sorted by significance
+    auto map_parsed_infos = m_mapParsedInfos.snapshot();
     std::vector<std::pair<int,QString>> lst_pages_with_significance;
-    lst_pages_with_significance.reserve( m_mapParsedInfos.size() );
-    for ( const auto & rcl_item : m_mapParsedInfos )
-        lst_pages_with_significance.emplace_back( rcl_item.second->significance( m_strAlbumTitle, m_strTrackArtist, m_strTrackTitle, m_iYear ), rcl_item.first );
+    lst_pages_with_significance.reserve( map_parsed_infos->size() );
+    for ( const auto & rcl_item : *map_parsed_infos )
+        lst_pages_with_significance.emplace_back( rcl_item.second->significance( rclQuery.strAlbumTitle, rclQuery.strTrackArtist, rclQuery.strTrackTitle, rclQuery.iYear ), rcl_item.first );
     std::sort( lst_pages_with_significance.begin(), lst_pages_with_significance.end() );
     QStringList lst_pages;
     for ( auto it_item = lst_pages_with_significance.rbegin(); it_item != lst_pages_with_significance.rend(); ++it_item )
@@ -518,8 +717,9 @@ QStringList WikipediaParser::getPages() const
 
 std::shared_ptr<OnlineInfoSource> WikipediaParser::getResult(const QString &strPage) const
 {
-    auto it_item = m_mapParsedInfos.find(strPage);
-    if ( it_item != m_mapParsedInfos.end() )
+    auto map_parsed_infos = m_mapParsedInfos.snapshot();
+    auto it_item = map_parsed_infos->find(strPage);
+    if ( it_item != map_parsed_infos->end() )
         return it_item->second;
     else
         return nullptr;
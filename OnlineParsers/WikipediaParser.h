@@ -2,7 +2,8 @@
 #define WIKIPEDIAPARSER_H
 
 #include "OnlineSourceParser.h"
-#include <QCache>
+#include "ParserResultStore.h"
+#include <atomic>
 
 class WikipediaParser : public OnlineSourceParser
 {
@@ -30,48 +31,61 @@ protected:
     explicit WikipediaParser(QNetworkAccessManager *pclNetworkAccess, QObject *pclParent = nullptr);
     
     // returns true, if result to new queries are still expected
-    bool resolveSearchQueries( QStringList lstQueries );
-    bool resolveTitleURLs( QStringList lstTitles );
+    bool resolveSearchQueries( QStringList lstQueries, const Query& rclQuery );
+    bool resolveTitleURLs( QStringList lstTitles, const Query& rclQuery );
     bool resolveCoverImageURLs( QStringList lstCoverImageTitles );
-    void parseWikipediaAPIJSONReply( QByteArray strReply );
-    void parseWikiText( QString strTitle, QString strContent, QStringList& lstImageTitles, QStringList& lstRedirectTitles );
+    void parseWikipediaAPIJSONReply( QByteArray strReply, const Query& rclQuery );
+    void parseWikiText( QString strTitle, QString strContent, const Query& rclQuery, QStringList& lstImageTitles, QStringList& lstRedirectTitles );
     void replaceCoverImageURL( QString strTitle, QString strURL );
+    // pages are parsed at most once per request, even if several replies contain them
+    bool isPageParsed( const QString& strTitle ) const;
+    bool markPageParsed( const QString& strTitle ); // returns false, if the page was already marked
+    QStringList parsedPages() const;
     QString lemma2URL( QString strLemma, QString strSection ) const;
     
     // returns true if new content was queried
-    bool getContentFromCacheAndQueryMissing( const QStringList& lstTitles );
+    bool getContentFromCacheAndQueryMissing( const QStringList& lstTitles, const Query& rclQuery );
     bool getCoverImageURLsFromCacheAndQueryMissing( const QStringList& lstCoverImageTitles );
-    bool getSearchResultFromCacheAndQueryMissing( const QString& strQuery );
+    bool getSearchResultFromCacheAndQueryMissing( const QString& strSearch, const Query& rclQuery );
     
-    void allContentAdded();
+    void allContentAdded( const Query& rclQuery );
+    QStringList getPages( const Query& rclQuery ) const;
     
     void downloadFavicon(QNetworkAccessManager *pclNetworkAccess);
     
     // gets content for titles in list from cache if possible. Returns list of noncached titles
-    QStringList getContentFromCache( const QStringList& lstTitles );
+    QStringList getContentFromCache( const QStringList& lstTitles, const Query& rclQuery );
     QStringList getRedirectsFromCache( const QString& strTitle );
     QStringList getCoverImageURLsFromCache( const QStringList& lstCoverImageTitles );
     
+    using SectionsToInfo = std::map<QString,std::shared_ptr<OnlineInfoSource>>;
+    // parsed content of a (percent encoded) title is looked up in the LRU first and in the results stored by earlier sessions second
+    std::optional<SectionsToInfo> getCachedContent( const QString& strTitle, const Query& rclQuery );
+    void cacheContent( const QString& strTitle, SectionsToInfo mapInfos, const Query& rclQuery );
+    QString storeKey( const char* pcType, const QString& strTitle ) const;
+    QString contentStoreKey( const QString& strTitle, const Query& rclQuery ) const;
+    
     QNetworkRequest createContentRequest( const QStringList & lstTitles ) const;
     QNetworkRequest createImageRequest( const QStringList& lstCoverImageTitles ) const;
     QNetworkRequest createSearchRequest( const QString& strQuery ) const;
     
-    // remember the last requested for later use during parsing
-    QString m_strTrackTitle, m_strAlbumTitle, m_strTrackArtist;
-    int     m_iYear = -1;
+    // remember the last requested for later use during parsing, only used by the GUI thread
+    Query   m_clQuery;
     
     QString m_strLanguageSubDomain;
+    mutable QMutex m_clParsedPagesMutex;
     QStringList m_lstParsedPages; // remember the already parsed pages to avoid double work due to redirects
-    bool m_bSearchConducted;
+    std::atomic_bool m_bSearchConducted{false};
     std::unique_ptr<QIcon> m_pclIcon;
     
-    using SectionsToInfo = std::map<QString,std::shared_ptr<OnlineInfoSource>>;
-    SectionsToInfo m_mapParsedInfos;
+    // results and caches are shared between the parser threads and the GUI
+    SnapshotMap<QString,std::shared_ptr<OnlineInfoSource>> m_mapParsedInfos;
     
-    QCache<QString,QStringList>    m_lruSearchResults;  // caches titles returned for a given search
-    QCache<QString,QStringList>    m_lruRedirects;      // caches any redirects for a given title
-    QCache<QString,SectionsToInfo> m_lruContent;        // caches all sections for a given title
-    QCache<QString,QString>        m_lruCoverImageURLs; // caches image URLs for a given title
+    SharedCache<QString,QStringList>    m_lruSearchResults;  // caches titles returned for a given search
+    SharedCache<QString,QStringList>    m_lruRedirects;      // caches any redirects for a given title
+    SharedCache<QString,SectionsToInfo> m_lruContent;        // caches all sections for a given title
+    SharedCache<QString,QString>        m_lruCoverImageURLs; // caches image URLs for a given title
+    std::shared_ptr<PersistentResultStore> m_pclStoredResults; // contents, redirects and image URLs of the caches above, kept between sessions
 };
 
 class EnglishWikipediaParser : public WikipediaParser
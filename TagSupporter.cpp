@@ -5,7 +5,9 @@
 #include <Tools/EmbeddedSQLConnection.h>
 #include <OnlineParsers/WikipediaParser.h>
 #include <OnlineParsers/DiscogsParser.h>
+#include <OnlineParsers/MetadataPrefetcher.h>
 #include <Tools/CoverDownloader.h>
+#include <Tools/FolderTagIndex.h>
 #include <Tools/TemporaryRecursiveCopy.h>
 #include "ui_TagSupporter.h"
 
@@ -18,10 +20,17 @@ TagSupporter::TagSupporter(QWidget *parent)
     m_pclEnglishWikipediaParser = std::make_shared<EnglishWikipediaParser>(m_pclNetworkAccess.get());
     m_pclGermanWikipediaParser  = std::make_shared<GermanWikipediaParser>(m_pclNetworkAccess.get());
     m_pclDiscogsParser          = std::make_shared<DiscogsParser>(m_pclNetworkAccess.get());
+    // parsers of their own, so looking up the next files does not interfere with the selected one
+    m_pclPrefetcher = std::make_unique<MetadataPrefetcher>();
+    m_pclPrefetcher->addParser( std::make_shared<EnglishWikipediaParser>(m_pclNetworkAccess.get()) );
+    m_pclPrefetcher->addParser( std::make_shared<GermanWikipediaParser>(m_pclNetworkAccess.get()) );
+    m_pclPrefetcher->addParser( std::make_shared<DiscogsParser>(m_pclNetworkAccess.get()) );
     m_pclUI->setupUi(this);
+    m_pclPrefetcher->setTagIndex( &m_pclUI->fileBrowserWidget->tagIndex() );
     
     connect( m_pclUI->fileBrowserWidget, &FileBrowserWidget::noFileSelected, this, &TagSupporter::noFileSelected );
     connect( m_pclUI->fileBrowserWidget, &FileBrowserWidget::fileSelected, this, &TagSupporter::fileSelected );
+    connect( m_pclUI->fileBrowserWidget, &FileBrowserWidget::currentFileRenamed, this, &TagSupporter::fileRenamed );
     connect( m_pclUI->fileBrowserWidget, &FileBrowserWidget::folderChanged, m_pclUI->filenameWidget, &FilenameWidget::setDestinationBaseDirectory );
     connect( m_pclUI->fileBrowserWidget, &FileBrowserWidget::saveFile, this, &TagSupporter::saveFile );
 
@@ -49,7 +58,7 @@ TagSupporter::TagSupporter(QWidget *parent)
     connect( m_pclUI->onlineSourcesWidget, SIGNAL(setTrackArtist(const QString&)), m_pclUI->metadataWidget, SLOT(setTrackArtist(const QString&)));
     connect( m_pclUI->onlineSourcesWidget, SIGNAL(setAlbumArtist(const QString&)), m_pclUI->metadataWidget, SLOT(setAlbumArtist(const QString&)));
     connect( m_pclUI->onlineSourcesWidget, SIGNAL(setGenre(const QString&)), m_pclUI->metadataWidget, SLOT(setGenre(const QString&)));
-    connect( m_pclUI->onlineSourcesWidget, SIGNAL(setCover(const QPixmap&)), m_pclUI->metadataWidget, SLOT(setCover(const QPixmap&)));
+    connect( m_pclUI->onlineSourcesWidget, SIGNAL(setCover(const CoverImage&)), m_pclUI->metadataWidget, SLOT(setCover(const CoverImage&)));
     connect( m_pclUI->onlineSourcesWidget, SIGNAL(setYear(int)), m_pclUI->metadataWidget, SLOT(setYear(int)));
     connect( m_pclUI->onlineSourcesWidget, SIGNAL(setAlbum(const QString&)), m_pclUI->metadataWidget, SLOT(setAlbum(const QString&)));
     connect( m_pclUI->onlineSourcesWidget, SIGNAL(setDiscNumber(const QString&)), m_pclUI->metadataWidget, SLOT(setDiscNumber(const QString&)));
@@ -57,7 +66,7 @@ TagSupporter::TagSupporter(QWidget *parent)
     connect( m_pclUI->onlineSourcesWidget, SIGNAL(setTotalTracks(int)), m_pclUI->metadataWidget, SLOT(setTotalTracks(int)));
     connect( m_pclUI->onlineSourcesWidget, SIGNAL(setTrackNumber(int)), m_pclUI->metadataWidget, SLOT(setTrackNumber(int)));
     
-    connect( m_pclUI->webBrowserWidget, SIGNAL(setCover(const QPixmap&)), m_pclUI->metadataWidget, SLOT(setCover(const QPixmap&)));
+    connect( m_pclUI->webBrowserWidget, SIGNAL(setCover(const CoverImage&)), m_pclUI->metadataWidget, SLOT(setCover(const CoverImage&)));
     connect( m_pclUI->webBrowserWidget, SIGNAL(parseURL(const QUrl&)), m_pclEnglishWikipediaParser.get(), SLOT(parseFromURL(const QUrl&)));
     connect( m_pclUI->webBrowserWidget, SIGNAL(parseURL(const QUrl&)), m_pclGermanWikipediaParser.get(), SLOT(parseFromURL(const QUrl&)));
     connect( m_pclUI->webBrowserWidget, SIGNAL(parseURL(const QUrl&)), m_pclDiscogsParser.get(), SLOT(parseFromURL(const QUrl&)));
@@ -115,6 +124,7 @@ TagSupporter::~TagSupporter()
 
 void TagSupporter::noFileSelected()
 {
+    m_pclPrefetcher->stop();
     m_pclUI->onlineSourcesWidget->clear();
     m_pclUI->metadataWidget->clear();
     m_pclUI->filenameWidget->clear();
@@ -128,7 +138,20 @@ void TagSupporter::fileSelected(const QString& strFullFilePath)
     m_pclUI->filenameWidget->clear();
     m_pclUI->metadataWidget->loadFromFile(strFullFilePath);
     m_pclUI->filenameWidget->setFilename(strFullFilePath);
+    // the length is known from the folder scan already, no need to wait for the player
+    const FolderTagIndex::Entry* pcl_entry = m_pclUI->fileBrowserWidget->tagIndex().find(strFullFilePath);
+    if ( pcl_entry && pcl_entry->iDurationSecs > 0 )
+        m_pclUI->onlineSourcesWidget->setLengthQuery(pcl_entry->iDurationSecs);
     m_pclUI->onlineSourcesWidget->check();
+    // the next files are most likely selected soon
+    m_pclPrefetcher->prefetch( m_pclUI->fileBrowserWidget->upcomingFiles( 5 ) );
+}
+
+void TagSupporter::fileRenamed(const QString& strFullFilePath)
+{
+    // metadata and online results are still valid, only the path changed
+    m_pclUI->playbackWidget->setSource(QUrl::fromLocalFile(strFullFilePath));
+    m_pclUI->filenameWidget->setFilename(strFullFilePath);
 }
 
 void TagSupporter::infoParsingError(QString strError)
@@ -163,9 +186,13 @@ void TagSupporter::scanFolder( QString strFolder )
 
 void TagSupporter::saveFile( const QString& strFullFilePath )
 {
+    bool b_tags_written = false;
     if ( m_pclUI->metadataWidget->isModified() )
+    {
         if ( !m_pclUI->metadataWidget->saveToFile( strFullFilePath ) )
             return; // abort here, if saving the metadata was aborted
+        b_tags_written = true;
+    }
     
     if ( m_pclUI->filenameWidget->isModified() )
     {
@@ -178,5 +205,8 @@ void TagSupporter::saveFile( const QString& strFullFilePath )
 
         m_pclUI->fileBrowserWidget->currentFileMoved(m_pclUI->filenameWidget->filename(),str_new_folder);
     }
+    // a file that was only renamed keeps its entry in the tag index
+    if ( b_tags_written )
+        m_pclUI->fileBrowserWidget->currentFileTagsWritten();
     m_pclUI->fileBrowserWidget->setFileModified( m_pclUI->metadataWidget->isModified() || m_pclUI->filenameWidget->isModified() );   
 }
@@ -26,6 +26,7 @@ protected slots:
 
     void noFileSelected();
     void fileSelected(const QString& strFullFilePath);
+    void fileRenamed(const QString& strFullFilePath);
     void saveFile(const QString& strFullFilePath);
 
 private:
@@ -33,6 +34,7 @@ private:
     std::shared_ptr<class WikipediaParser>       m_pclGermanWikipediaParser, m_pclEnglishWikipediaParser;
     std::shared_ptr<class DiscogsParser>         m_pclDiscogsParser;
     std::unique_ptr<class QNetworkAccessManager> m_pclNetworkAccess;
+    std::unique_ptr<class MetadataPrefetcher>    m_pclPrefetcher;
     std::shared_ptr<class EmbeddedSQLConnection> m_pclDB;
     std::list<class TemporaryRecursiveCopy>      m_lstTemporaryFiles;
 };
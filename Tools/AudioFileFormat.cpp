@@ -0,0 +1,60 @@
+#include "AudioFileFormat.h"
+#include <QFile>
+#include <QFileInfo>
+
+static const int s_iHeaderSize = 512; // enough for the first ogg page header with a full segment table
+
+// size of an ID3v2 tag at the start of the data including header and footer, 0 if there is none
+static qint64 getID3v2Size( const QByteArray& strHeader )
+{
+    if ( strHeader.size() < 10 || !strHeader.startsWith("ID3") )
+        return 0;
+    qint64 i_size = 10;
+    for ( int i = 6; i < 10; ++i ) // sync-safe integer, 7 bits per byte
+        i_size += static_cast<qint64>( strHeader.at(i) & 0x7f ) << ( 7 * (9-i) );
+    if ( strHeader.at(5) & 0x10 ) // footer present
+        i_size += 10;
+    return i_size;
+}
+
+static AudioFileFormat sniffOggCodec( const QByteArray& strHeader )
+{
+    // the first packet follows the page header of 27 bytes and the segment table
+    if ( strHeader.size() < 27 )
+        return AudioFileFormat::Unknown;
+    int i_packet_start = 27 + static_cast<unsigned char>( strHeader.at(26) );
+    QByteArray str_packet = strHeader.mid( i_packet_start, 8 );
+    if ( str_packet.startsWith("\x01vorbis") )
+        return AudioFileFormat::OggVorbis;
+    if ( str_packet.startsWith("OpusHead") )
+        return AudioFileFormat::OggOpus;
+    return AudioFileFormat::Unknown;
+}
+
+AudioFileFormat sniffAudioFileFormat( const QString& strFilename )
+{
+    static const QByteArray s_strASFHeaderGUID( "\x30\x26\xb2\x75\x8e\x66\xcf\x11\xa6\xd9\x00\xaa\x00\x62\xce\x6c", 16 );
+
+    QFile cl_file( strFilename );
+    if ( !cl_file.open( QIODevice::ReadOnly ) )
+        return AudioFileFormat::Unknown;
+    QByteArray str_header = cl_file.read( s_iHeaderSize );
+    qint64 i_id3v2_size = getID3v2Size( str_header );
+    if ( i_id3v2_size > 0 && cl_file.seek( i_id3v2_size ) )
+        str_header = cl_file.read( s_iHeaderSize );
+
+    if ( str_header.startsWith("fLaC") )
+        return AudioFileFormat::FLAC;
+    if ( str_header.startsWith("OggS") )
+        return sniffOggCodec( str_header );
+    if ( str_header.mid( 4, 4 ) == "ftyp" )
+        return AudioFileFormat::MP4;
+    if ( str_header.startsWith( s_strASFHeaderGUID ) )
+        return AudioFileFormat::ASF;
+    if ( str_header.size() >= 2 && static_cast<unsigned char>( str_header.at(0) ) == 0xff && ( static_cast<unsigned char>( str_header.at(1) ) & 0xe0 ) == 0xe0 )
+        return AudioFileFormat::MPEG; // frame sync
+    // ID3v2 is hardly used by anything but MPEG
+    if ( i_id3v2_size > 0 || QFileInfo( strFilename ).suffix().compare( "mp3", Qt::CaseInsensitive ) == 0 )
+        return AudioFileFormat::MPEG;
+    return AudioFileFormat::Unknown;
+}
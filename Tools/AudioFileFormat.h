@@ -0,0 +1,13 @@
+#ifndef AUDIOFILEFORMAT_H
+#define AUDIOFILEFORMAT_H
+
+#include <QString>
+
+enum class AudioFileFormat { Unknown, FLAC, MPEG, OggVorbis, OggOpus, MP4, ASF };
+
+// detects the format by the leading bytes of the file (behind an ID3v2 tag, if any), so that the file can be
+// opened with the matching taglib class right away. Falls back to the file extension for MPEG files starting
+// with garbage
+AudioFileFormat sniffAudioFileFormat( const QString& strFilename );
+
+#endif // AUDIOFILEFORMAT_H
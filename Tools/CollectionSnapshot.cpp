@@ -0,0 +1,402 @@
+#include "CollectionSnapshot.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+
+static const char    s_arrMagic[4] = { 'T', 'S', 'C', 'S' };
+static const quint32 s_uiVersion   = 2;
+
+// folds case and accents like the default collation of the database, "Beyoncé" and "BEYONCE" get the same key
+static QString collationKey( const QString& strName )
+{
+    QString str_decomposed = strName.normalized( QString::NormalizationForm_D );
+    QString str_key;
+    str_key.reserve( str_decomposed.size() );
+    for ( QChar c_char : str_decomposed )
+    {
+        if ( c_char.category() != QChar::Mark_NonSpacing )
+            str_key.append( c_char );
+    }
+    return str_key.toCaseFolded();
+}
+
+// all sections of the file are arrays of quint32 following the header, except for the string data at the end
+struct CollectionSnapshot::Header
+{
+    char    arrMagic[4];
+    quint32 uiVersion;
+    char    arrFingerprint[16];
+    quint32 uiNumStrings;
+    quint32 uiNumGenres;
+    quint32 uiNumArtists;
+    quint32 uiNumAlbums;
+    quint32 uiNumTracks;
+    quint32 uiStringDataSize;
+
+    qint64 fileSize() const {
+        qint64 i_num_values = qint64(uiNumStrings)+1 + uiNumGenres + uiNumArtists + 2*qint64(uiNumAlbums) + 5*qint64(uiNumTracks);
+        return static_cast<qint64>( sizeof(Header) ) + i_num_values*static_cast<qint64>( sizeof(quint32) ) + uiStringDataSize;
+    }
+};
+
+CollectionSnapshot::~CollectionSnapshot()
+{
+    clear();
+}
+
+void CollectionSnapshot::update( EmbeddedSQLConnection& rclDB, const QString& strFile, QObject* pclContext, std::function<void(std::shared_ptr<const CollectionSnapshot>)> funFinished )
+{
+    // passed from the worker to the thread of the connection. The data is only set, if the snapshot had to be rebuilt
+    struct Result
+    {
+        QByteArray arrFingerprint;
+        QByteArray arrData;
+    };
+    auto pcl_result = std::make_shared<Result>();
+    rclDB.runAsync( "collection snapshot", pclContext, [pcl_result, strFile]( const EmbeddedSQLConnection::StatementQuery& funQuery ) {
+        pcl_result->arrFingerprint = fingerprint( funQuery );
+        if ( pcl_result->arrFingerprint.isEmpty() )
+            return false;
+        if ( isUpToDate( strFile, pcl_result->arrFingerprint ) )
+            return true;
+        pcl_result->arrData = build( funQuery, pcl_result->arrFingerprint );
+        if ( pcl_result->arrData.isEmpty() )
+            return false;
+        QDir().mkpath( QFileInfo(strFile).absolutePath() );
+        QSaveFile cl_file( strFile );
+        if ( cl_file.open( QIODevice::WriteOnly ) && cl_file.write( pcl_result->arrData ) == pcl_result->arrData.size() )
+            cl_file.commit();
+        return true;
+    }, [pcl_result, strFile, funFinished]() {
+        auto pcl_snapshot = std::make_shared<CollectionSnapshot>();
+        if ( !pcl_snapshot->map( strFile, pcl_result->arrFingerprint ) && !pcl_result->arrData.isEmpty() )
+        {
+            // could not be stored, keep it in memory for this session
+            pcl_snapshot->m_arrData = std::move(pcl_result->arrData);
+            if ( !pcl_snapshot->attach( reinterpret_cast<const uchar*>( pcl_snapshot->m_arrData.constData() ), pcl_snapshot->m_arrData.size(), pcl_result->arrFingerprint ) )
+                pcl_snapshot->clear();
+        }
+        funFinished( std::move(pcl_snapshot) );
+    } );
+}
+
+void CollectionSnapshot::clear()
+{
+    m_pclHeader = nullptr;
+    m_clTables  = Tables();
+    m_vecStrings.clear();
+    m_arrData.clear();
+    if ( m_clFile.isOpen() )
+        m_clFile.close(); // unmaps the file
+}
+
+QByteArray CollectionSnapshot::fingerprint( const EmbeddedSQLConnection::StatementQuery& funQuery )
+{
+    // row counts and highest ids change with every insert or delete, update times of the tables also cover modifications
+    QStringList lst_fields{ "DATABASE()" };
+    for ( const char* pc_table : { "genres", "artists", "albums", "years", "tracks" } )
+        lst_fields << QString("(SELECT COUNT(*) FROM %1)").arg(pc_table) << QString("(SELECT MAX(id) FROM %1)").arg(pc_table);
+    lst_fields << "(SELECT MAX(UPDATE_TIME) FROM information_schema.TABLES WHERE TABLE_SCHEMA=DATABASE() AND TABLE_NAME IN ('genres','artists','albums','years','tracks'))";
+
+    QCryptographicHash cl_hash( QCryptographicHash::Md5 );
+    bool b_completed = funQuery( "SELECT " + lst_fields.join(", "), {}, [&cl_hash]( const EmbeddedSQLConnection::Row& rclRow ) {
+        for ( int i = 0; i < rclRow.size(); ++i )
+        {
+            cl_hash.addData( rclRow.isNull(i) ? QByteArray("NULL") : rclRow.toUtf8(i) );
+            cl_hash.addData( "|", 1 );
+        }
+    } );
+    return b_completed ? cl_hash.result() : QByteArray();
+}
+
+QByteArray CollectionSnapshot::build( const EmbeddedSQLConnection::StatementQuery& funQuery, const QByteArray& arrFingerprint )
+{
+    // every distinct string is stored only once
+    std::vector<QByteArray>   vec_strings;
+    QHash<QByteArray,quint32> map_strings;
+    auto addString = [&vec_strings,&map_strings]( const EmbeddedSQLConnection::Row& rclRow, int iField ) {
+        QByteArray arr_string = rclRow.toUtf8( iField );
+        auto it_string = map_strings.constFind( arr_string );
+        if ( it_string != map_strings.constEnd() )
+            return *it_string;
+        quint32 ui_string = static_cast<quint32>( vec_strings.size() );
+        map_strings.insert( arr_string, ui_string );
+        vec_strings.push_back( arr_string );
+        return ui_string;
+    };
+    auto optionalId = []( const EmbeddedSQLConnection::Row& rclRow, int iField ) {
+        return rclRow.isNull(iField) ? -1 : rclRow.toInt(iField);
+    };
+    auto readTable = [&funQuery]( const QString& strQuery, const std::function<void(const EmbeddedSQLConnection::Row&)>& funRow ) {
+        return funQuery( strQuery, {}, funRow );
+    };
+
+    struct Entry { int iId; quint32 uiName; int iArtist; };
+    struct Track { quint32 uiTitle; int iArtist; int iAlbum; int iYear; int iGenre; };
+    std::vector<Entry> vec_genres, vec_artists, vec_albums;
+    std::vector<Track> vec_tracks;
+    QHash<int,int>     map_years;
+    bool b_completed = readTable( "SELECT id, name FROM genres", [&]( const EmbeddedSQLConnection::Row& rclRow ) {
+        vec_genres.push_back( { rclRow.toInt(0), addString( rclRow, 1 ), -1 } );
+    } ) && readTable( "SELECT id, name FROM artists", [&]( const EmbeddedSQLConnection::Row& rclRow ) {
+        vec_artists.push_back( { rclRow.toInt(0), addString( rclRow, 1 ), -1 } );
+    } ) && readTable( "SELECT id, name, artist FROM albums", [&]( const EmbeddedSQLConnection::Row& rclRow ) {
+        vec_albums.push_back( { rclRow.toInt(0), addString( rclRow, 1 ), optionalId( rclRow, 2 ) } );
+    } ) && readTable( "SELECT id, name FROM years", [&]( const EmbeddedSQLConnection::Row& rclRow ) {
+        map_years.insert( rclRow.toInt(0), rclRow.toInt(1) );
+    } ) && readTable( "SELECT title, artist, album, year, genre FROM tracks", [&]( const EmbeddedSQLConnection::Row& rclRow ) {
+        vec_tracks.push_back( { addString( rclRow, 0 ), optionalId( rclRow, 1 ), optionalId( rclRow, 2 ), optionalId( rclRow, 3 ), optionalId( rclRow, 4 ) } );
+    } );
+    if ( !b_completed )
+        return QByteArray();
+
+    // order like the database would (case and accent insensitive), ties by id to keep the order stable between snapshots
+    std::vector<QString> vec_keys;
+    vec_keys.reserve( vec_strings.size() );
+    for ( const QByteArray& arr_string : vec_strings )
+        vec_keys.push_back( collationKey( QString::fromUtf8( arr_string ) ) );
+    auto lessByName = [&vec_keys]( quint32 uiLhs, quint32 uiRhs ) {
+        return vec_keys[uiLhs] < vec_keys[uiRhs];
+    };
+    auto sortEntries = [&lessByName]( std::vector<Entry>& rvecEntries ) {
+        std::sort( rvecEntries.begin(), rvecEntries.end(), [&lessByName]( const Entry& rclLhs, const Entry& rclRhs ) {
+            if ( lessByName( rclLhs.uiName, rclRhs.uiName ) ) return true;
+            if ( lessByName( rclRhs.uiName, rclLhs.uiName ) ) return false;
+            return rclLhs.iId < rclRhs.iId;
+        } );
+    };
+    sortEntries( vec_genres );
+    sortEntries( vec_artists );
+    sortEntries( vec_albums );
+    std::stable_sort( vec_tracks.begin(), vec_tracks.end(), [&lessByName]( const Track& rclLhs, const Track& rclRhs ) {
+        return lessByName( rclLhs.uiTitle, rclRhs.uiTitle );
+    } );
+
+    // database ids are replaced by the position in the snapshot tables
+    auto indexById = []( const std::vector<Entry>& vecEntries ) {
+        QHash<int,quint32> map_index;
+        map_index.reserve( static_cast<int>(vecEntries.size()) );
+        for ( size_t ui_entry = 0; ui_entry < vecEntries.size(); ++ui_entry )
+            map_index.insert( vecEntries[ui_entry].iId, static_cast<quint32>(ui_entry) );
+        return map_index;
+    };
+    const QHash<int,quint32> map_genres  = indexById( vec_genres );
+    const QHash<int,quint32> map_artists = indexById( vec_artists );
+    const QHash<int,quint32> map_albums  = indexById( vec_albums );
+
+    Header cl_header;
+    std::memcpy( cl_header.arrMagic, s_arrMagic, sizeof(cl_header.arrMagic) );
+    cl_header.uiVersion = s_uiVersion;
+    std::memcpy( cl_header.arrFingerprint, arrFingerprint.constData(), std::min( sizeof(cl_header.arrFingerprint), static_cast<size_t>(arrFingerprint.size()) ) );
+    cl_header.uiNumStrings = static_cast<quint32>( vec_strings.size() );
+    cl_header.uiNumGenres  = static_cast<quint32>( vec_genres.size() );
+    cl_header.uiNumArtists = static_cast<quint32>( vec_artists.size() );
+    cl_header.uiNumAlbums  = static_cast<quint32>( vec_albums.size() );
+    cl_header.uiNumTracks  = static_cast<quint32>( vec_tracks.size() );
+    cl_header.uiStringDataSize = 0;
+    std::vector<quint32> vec_string_offsets{ 0 };
+    vec_string_offsets.reserve( vec_strings.size()+1 );
+    for ( const QByteArray& arr_string : vec_strings )
+    {
+        cl_header.uiStringDataSize += static_cast<quint32>( arr_string.size() );
+        vec_string_offsets.push_back( cl_header.uiStringDataSize );
+    }
+
+    QByteArray arr_data( reinterpret_cast<const char*>(&cl_header), sizeof(cl_header) );
+    auto appendColumn = [&arr_data]( const std::vector<quint32>& vecColumn ) {
+        arr_data.append( reinterpret_cast<const char*>( vecColumn.data() ), static_cast<int>( vecColumn.size()*sizeof(quint32) ) );
+    };
+    auto column = []( const auto& vecEntries, auto funValue ) {
+        std::vector<quint32> vec_column;
+        vec_column.reserve( vecEntries.size() );
+        for ( const auto& rcl_entry : vecEntries )
+            vec_column.push_back( funValue( rcl_entry ) );
+        return vec_column;
+    };
+    auto reference = []( const QHash<int,quint32>& mapIndex, int iId ) {
+        return mapIndex.value( iId, NoEntry );
+    };
+    appendColumn( vec_string_offsets );
+    appendColumn( column( vec_genres,  []( const Entry& rclEntry ) { return rclEntry.uiName; } ) );
+    appendColumn( column( vec_artists, []( const Entry& rclEntry ) { return rclEntry.uiName; } ) );
+    appendColumn( column( vec_albums,  []( const Entry& rclEntry ) { return rclEntry.uiName; } ) );
+    appendColumn( column( vec_albums,  [&]( const Entry& rclEntry ) { return reference( map_artists, rclEntry.iArtist ); } ) );
+    appendColumn( column( vec_tracks,  []( const Track& rclTrack ) { return rclTrack.uiTitle; } ) );
+    appendColumn( column( vec_tracks,  [&]( const Track& rclTrack ) { return reference( map_artists, rclTrack.iArtist ); } ) );
+    appendColumn( column( vec_tracks,  [&]( const Track& rclTrack ) { return reference( map_albums, rclTrack.iAlbum ); } ) );
+    appendColumn( column( vec_tracks,  [&]( const Track& rclTrack ) { return static_cast<quint32>( map_years.value( rclTrack.iYear, 0 ) ); } ) );
+    appendColumn( column( vec_tracks,  [&]( const Track& rclTrack ) { return reference( map_genres, rclTrack.iGenre ); } ) );
+    for ( const QByteArray& arr_string : vec_strings )
+        arr_data.append( arr_string );
+    return arr_data;
+}
+
+bool CollectionSnapshot::isUpToDate( const QString& strFile, const QByteArray& arrFingerprint )
+{
+    QFile cl_file( strFile );
+    if ( !cl_file.open( QIODevice::ReadOnly ) )
+        return false;
+    Header cl_header;
+    if ( cl_file.read( reinterpret_cast<char*>(&cl_header), sizeof(cl_header) ) != static_cast<qint64>( sizeof(cl_header) ) )
+        return false;
+    if ( std::memcmp( cl_header.arrMagic, s_arrMagic, sizeof(s_arrMagic) ) != 0 || cl_header.uiVersion != s_uiVersion
+         || arrFingerprint != QByteArray::fromRawData( cl_header.arrFingerprint, sizeof(cl_header.arrFingerprint) ) )
+        return false;
+    return cl_file.size() == cl_header.fileSize();
+}
+
+bool CollectionSnapshot::map( const QString& strFile, const QByteArray& arrFingerprint )
+{
+    m_clFile.setFileName( strFile );
+    if ( !m_clFile.open( QIODevice::ReadOnly ) )
+        return false;
+    const uchar* pc_data = m_clFile.map( 0, m_clFile.size() );
+    if ( pc_data && attach( pc_data, m_clFile.size(), arrFingerprint ) )
+        return true;
+    clear();
+    return false;
+}
+
+bool CollectionSnapshot::attach( const uchar* pcData, qint64 iSize, const QByteArray& arrFingerprint )
+{
+    if ( iSize < static_cast<qint64>( sizeof(Header) ) )
+        return false;
+    const Header* pcl_header = reinterpret_cast<const Header*>( pcData );
+    if ( std::memcmp( pcl_header->arrMagic, s_arrMagic, sizeof(s_arrMagic) ) != 0 || pcl_header->uiVersion != s_uiVersion
+         || arrFingerprint != QByteArray::fromRawData( pcl_header->arrFingerprint, sizeof(pcl_header->arrFingerprint) ) )
+        return false;
+    if ( iSize != pcl_header->fileSize() )
+        return false;
+
+    Tables cl_tables;
+    const quint32* pui_values = reinterpret_cast<const quint32*>( pcData + sizeof(Header) );
+    auto nextColumn = [&pui_values]( quint32 uiSize ) {
+        const quint32* pui_column = pui_values;
+        pui_values += uiSize;
+        return pui_column;
+    };
+    cl_tables.puiStringOffsets = nextColumn( pcl_header->uiNumStrings+1 );
+    cl_tables.puiGenreNames    = nextColumn( pcl_header->uiNumGenres );
+    cl_tables.puiArtistNames   = nextColumn( pcl_header->uiNumArtists );
+    cl_tables.puiAlbumNames    = nextColumn( pcl_header->uiNumAlbums );
+    cl_tables.puiAlbumArtists  = nextColumn( pcl_header->uiNumAlbums );
+    cl_tables.puiTrackTitles   = nextColumn( pcl_header->uiNumTracks );
+    cl_tables.puiTrackArtists  = nextColumn( pcl_header->uiNumTracks );
+    cl_tables.puiTrackAlbums   = nextColumn( pcl_header->uiNumTracks );
+    cl_tables.puiTrackYears    = nextColumn( pcl_header->uiNumTracks );
+    cl_tables.puiTrackGenres   = nextColumn( pcl_header->uiNumTracks );
+    cl_tables.pcStringData     = reinterpret_cast<const char*>( pui_values );
+
+    // reject damaged files instead of reading out of bounds later on
+    for ( quint32 ui_string = 0; ui_string < pcl_header->uiNumStrings; ++ui_string )
+    {
+        if ( cl_tables.puiStringOffsets[ui_string] > cl_tables.puiStringOffsets[ui_string+1] )
+            return false;
+    }
+    if ( cl_tables.puiStringOffsets[0] != 0 || cl_tables.puiStringOffsets[pcl_header->uiNumStrings] != pcl_header->uiStringDataSize )
+        return false;
+    auto isValidColumn = []( const quint32* puiColumn, quint32 uiSize, quint32 uiNumTargets, bool bOptional ) {
+        return std::all_of( puiColumn, puiColumn+uiSize, [uiNumTargets,bOptional]( quint32 uiTarget ) {
+            return uiTarget < uiNumTargets || ( bOptional && uiTarget == NoEntry );
+        } );
+    };
+    if ( !isValidColumn( cl_tables.puiGenreNames,   pcl_header->uiNumGenres,  pcl_header->uiNumStrings, false )
+      || !isValidColumn( cl_tables.puiArtistNames,  pcl_header->uiNumArtists, pcl_header->uiNumStrings, false )
+      || !isValidColumn( cl_tables.puiAlbumNames,   pcl_header->uiNumAlbums,  pcl_header->uiNumStrings, false )
+      || !isValidColumn( cl_tables.puiAlbumArtists, pcl_header->uiNumAlbums,  pcl_header->uiNumArtists, true )
+      || !isValidColumn( cl_tables.puiTrackTitles,  pcl_header->uiNumTracks,  pcl_header->uiNumStrings, false )
+      || !isValidColumn( cl_tables.puiTrackArtists, pcl_header->uiNumTracks,  pcl_header->uiNumArtists, true )
+      || !isValidColumn( cl_tables.puiTrackAlbums,  pcl_header->uiNumTracks,  pcl_header->uiNumAlbums,  true )
+      || !isValidColumn( cl_tables.puiTrackGenres,  pcl_header->uiNumTracks,  pcl_header->uiNumGenres,  true ) )
+        return false;
+
+    m_pclHeader = pcl_header;
+    m_clTables  = cl_tables;
+    m_vecStrings.assign( pcl_header->uiNumStrings, QString() );
+    return true;
+}
+
+QString CollectionSnapshot::string( quint32 uiString ) const
+{
+    // decoded on first use only
+    QString& rstr_string = m_vecStrings[uiString];
+    if ( rstr_string.isNull() )
+    {
+        quint32 ui_begin = m_clTables.puiStringOffsets[uiString];
+        rstr_string = QString::fromUtf8( m_clTables.pcStringData+ui_begin, static_cast<int>( m_clTables.puiStringOffsets[uiString+1]-ui_begin ) );
+    }
+    return rstr_string;
+}
+
+quint32 CollectionSnapshot::numGenres() const  { return m_pclHeader ? m_pclHeader->uiNumGenres  : 0; }
+quint32 CollectionSnapshot::numArtists() const { return m_pclHeader ? m_pclHeader->uiNumArtists : 0; }
+quint32 CollectionSnapshot::numAlbums() const  { return m_pclHeader ? m_pclHeader->uiNumAlbums  : 0; }
+quint32 CollectionSnapshot::numTracks() const  { return m_pclHeader ? m_pclHeader->uiNumTracks  : 0; }
+
+QString CollectionSnapshot::genreName( quint32 uiGenre ) const
+{
+    return uiGenre == NoEntry ? QString() : string( m_clTables.puiGenreNames[uiGenre] );
+}
+
+QString CollectionSnapshot::artistName( quint32 uiArtist ) const
+{
+    return uiArtist == NoEntry ? QString() : string( m_clTables.puiArtistNames[uiArtist] );
+}
+
+QString CollectionSnapshot::albumName( quint32 uiAlbum ) const
+{
+    return uiAlbum == NoEntry ? QString() : string( m_clTables.puiAlbumNames[uiAlbum] );
+}
+
+quint32 CollectionSnapshot::albumArtist( quint32 uiAlbum ) const
+{
+    return m_clTables.puiAlbumArtists[uiAlbum];
+}
+
+QString CollectionSnapshot::trackTitle( quint32 uiTrack ) const
+{
+    return string( m_clTables.puiTrackTitles[uiTrack] );
+}
+
+quint32 CollectionSnapshot::trackArtist( quint32 uiTrack ) const
+{
+    return m_clTables.puiTrackArtists[uiTrack];
+}
+
+quint32 CollectionSnapshot::trackAlbum( quint32 uiTrack ) const
+{
+    return m_clTables.puiTrackAlbums[uiTrack];
+}
+
+int CollectionSnapshot::trackYear( quint32 uiTrack ) const
+{
+    return static_cast<int>( m_clTables.puiTrackYears[uiTrack] );
+}
+
+quint32 CollectionSnapshot::trackGenre( quint32 uiTrack ) const
+{
+    return m_clTables.puiTrackGenres[uiTrack];
+}
+
+std::vector<quint32> CollectionSnapshot::findArtists( const QString& strName ) const
+{
+    // artists are ordered by their collation key, so all matches are next to each other
+    std::vector<quint32> vec_artists;
+    QString str_key = collationKey( strName );
+    quint32 ui_begin = 0, ui_end = numArtists();
+    while ( ui_begin < ui_end )
+    {
+        quint32 ui_middle = ui_begin + (ui_end-ui_begin)/2;
+        if ( collationKey( artistName(ui_middle) ) < str_key )
+            ui_begin = ui_middle+1;
+        else
+            ui_end = ui_middle;
+    }
+    for ( quint32 ui_artist = ui_begin; ui_artist < numArtists() && collationKey( artistName(ui_artist) ) == str_key; ++ui_artist )
+        vec_artists.push_back( ui_artist );
+    return vec_artists;
+}
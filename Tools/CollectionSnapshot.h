@@ -0,0 +1,85 @@
+#ifndef COLLECTIONSNAPSHOT_H
+#define COLLECTIONSNAPSHOT_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <Tools/EmbeddedSQLConnection.h>
+
+// compact copy of the amarok collection (genres, artists, albums and tracks), kept in a memory mapped file.
+// Every string is stored once in a string table, the tables reference strings and each other by index.
+// The file is only rebuilt, if the database reports changes of the collection tables.
+// A snapshot decodes its strings on first use, so it must not be read by several threads at once
+class CollectionSnapshot
+{
+public:
+    static constexpr quint32 NoEntry = 0xffffffff;
+
+    CollectionSnapshot() = default;
+    ~CollectionSnapshot();
+    CollectionSnapshot( const CollectionSnapshot& ) = delete;
+    CollectionSnapshot& operator=( const CollectionSnapshot& ) = delete;
+
+    // compares the snapshot in strFile to the current state of the database and rebuilds it, if necessary. Both is done by the worker thread of the connection.
+    // funFinished gets the up to date snapshot in the thread of the connection. It is not called, if the database could not be read (the connection reports the error)
+    static void update( EmbeddedSQLConnection& rclDB, const QString& strFile, QObject* pclContext, std::function<void(std::shared_ptr<const CollectionSnapshot>)> funFinished );
+    void clear();
+    bool isValid() const { return m_pclHeader != nullptr; }
+
+    // genres, artists and albums are ordered by name, tracks by title (both case and accent insensitive)
+    quint32 numGenres() const;
+    quint32 numArtists() const;
+    quint32 numAlbums() const;
+    quint32 numTracks() const;
+
+    QString genreName( quint32 uiGenre ) const;
+    QString artistName( quint32 uiArtist ) const;
+    QString albumName( quint32 uiAlbum ) const;
+    quint32 albumArtist( quint32 uiAlbum ) const;
+    QString trackTitle( quint32 uiTrack ) const;
+    quint32 trackArtist( quint32 uiTrack ) const;
+    quint32 trackAlbum( quint32 uiTrack ) const;
+    int     trackYear( quint32 uiTrack ) const;
+    quint32 trackGenre( quint32 uiTrack ) const;
+
+    // artists called strName (compared case and accent insensitive like the database does)
+    std::vector<quint32> findArtists( const QString& strName ) const;
+
+protected:
+    struct Header;
+    struct Tables
+    {
+        const quint32* puiStringOffsets{nullptr};
+        const char*    pcStringData{nullptr};
+        const quint32* puiGenreNames{nullptr};
+        const quint32* puiArtistNames{nullptr};
+        const quint32* puiAlbumNames{nullptr};
+        const quint32* puiAlbumArtists{nullptr};
+        const quint32* puiTrackTitles{nullptr};
+        const quint32* puiTrackArtists{nullptr};
+        const quint32* puiTrackAlbums{nullptr};
+        const quint32* puiTrackYears{nullptr};
+        const quint32* puiTrackGenres{nullptr};
+    };
+
+    // both return an empty array, if the queries have been superseded
+    static QByteArray fingerprint( const EmbeddedSQLConnection::StatementQuery& funQuery );
+    // returns the contents of a snapshot file
+    static QByteArray build( const EmbeddedSQLConnection::StatementQuery& funQuery, const QByteArray& arrFingerprint );
+    // checks the header and size of the file only
+    static bool isUpToDate( const QString& strFile, const QByteArray& arrFingerprint );
+    bool map( const QString& strFile, const QByteArray& arrFingerprint );
+    bool attach( const uchar* pcData, qint64 iSize, const QByteArray& arrFingerprint );
+    QString string( quint32 uiString ) const;
+
+    QFile         m_clFile;
+    QByteArray    m_arrData; // snapshot kept in memory, if it could not be stored
+    const Header* m_pclHeader{nullptr};
+    Tables        m_clTables;
+    mutable std::vector<QString> m_vecStrings; // decoded strings, shared by all references to them
+};
+
+#endif // COLLECTIONSNAPSHOT_H
@@ -1,12 +1,10 @@
 #include "CoverDownloader.h"
-#include <QPixmap>
 #include <QNetworkRequest>
 #include <QNetworkReply>
 
 CoverDownloader::CoverDownloader(QNetworkAccessManager *pclNetworkAccess, QObject *pclParent)
 : QObject(pclParent)
 , m_pclNetworkAccess(pclNetworkAccess)
-, m_pclPixmap( std::make_unique<QPixmap>() )
 {
 }
 
@@ -24,14 +22,14 @@ void CoverDownloader::downloadImage(const QUrl &rclURL)
         emit error( QString("invalid URL requested: \"%1\"").arg(rclURL.toDisplayString()) );
 }
 
-const QPixmap &CoverDownloader::getImage() const
+const CoverImage &CoverDownloader::getImage() const
 {
-    return *m_pclPixmap;
+    return m_clImage;
 }
 
 void CoverDownloader::clear()
 {
-    *m_pclPixmap = QPixmap();
+    m_clImage = CoverImage();
 }
 
 void CoverDownloader::downloadImage(const QNetworkRequest &rclRequest)
@@ -49,8 +47,12 @@ void CoverDownloader::fileDownloaded()
     // check for error
     if ( pcl_reply->error() == QNetworkReply::NoError )
     {
-        if ( m_pclPixmap->loadFromData( pcl_reply->readAll() ) )
+        CoverImage cl_image( pcl_reply->readAll() );
+        if ( !cl_image.isNull() )
+        {
+            m_clImage = std::move(cl_image);
             emit imageReady();
+        }
         else
             emit error( QString( "failed to open downloaded image data from %1" ).arg(pcl_reply->url().toDisplayString()) );   
     }
@@ -2,7 +2,7 @@
 #define COVERDOWNLOADER_H
 
 #include <QObject>
-#include <memory>
+#include "CoverImage.h"
 
 class QNetworkRequest;
 class QNetworkAccessManager;
@@ -15,7 +15,7 @@ public:
     ~CoverDownloader() override;
 
     void downloadImage( const QUrl& rclURL );
-    const QPixmap& getImage() const;
+    const CoverImage& getImage() const;
     void clear();
 
 public slots:
@@ -30,7 +30,7 @@ protected slots:
     
 protected:
     QNetworkAccessManager* m_pclNetworkAccess;
-    std::unique_ptr<QPixmap> m_pclPixmap;
+    CoverImage m_clImage; // as downloaded, not decoded
 };
 
 #endif // COVERDOWNLOADER_H
@@ -0,0 +1,89 @@
+#include "CoverImage.h"
+#include <QBuffer>
+#include <QFile>
+#include <QImageReader>
+#include <QtConcurrent>
+#include <utility>
+
+// formats of the image reader, whose MIME type is not just "image/" followed by the format
+static const std::pair<const char*,const char*> s_arrMimeTypes[] = {
+    { "jpg",  "image/jpeg" },
+    { "tif",  "image/tiff" },
+    { "svg",  "image/svg+xml" },
+    { "ico",  "image/x-icon" }
+};
+
+CoverImage::CoverImage( QByteArray strData )
+: m_strData( std::move(strData) )
+{
+    if ( m_strData.isEmpty() )
+        return;
+    QBuffer cl_buffer;
+    cl_buffer.setData( m_strData );
+    cl_buffer.open( QIODevice::ReadOnly );
+    QByteArray str_format = QImageReader::imageFormat( &cl_buffer ).toLower();
+    if ( str_format.isEmpty() )
+        return;
+    for ( const auto& rcl_format : s_arrMimeTypes )
+    {
+        if ( str_format == rcl_format.first )
+        {
+            m_strMimeType = QString::fromLatin1( rcl_format.second );
+            return;
+        }
+    }
+    m_strMimeType = "image/" + QString::fromLatin1( str_format );
+}
+
+bool CoverImage::isEmbeddable() const
+{
+    return m_strMimeType == "image/jpeg" || m_strMimeType == "image/png";
+}
+
+CoverImage CoverImage::toEmbeddable() const
+{
+    if ( isNull() || isEmbeddable() )
+        return *this;
+
+    // anything else (WebP, GIF, TIFF, SVG, ...) is transcoded to JPEG, as every cover used to be
+    QImage cl_image;
+    CoverImage cl_jpeg;
+    QBuffer cl_jpeg_buffer( &cl_jpeg.m_strData );
+    if ( !cl_image.loadFromData( m_strData ) || !cl_jpeg_buffer.open( QIODevice::WriteOnly ) || !cl_image.save( &cl_jpeg_buffer, "JPG" ) )
+        return CoverImage();
+    cl_jpeg.m_strMimeType = "image/jpeg";
+    return cl_jpeg;
+}
+
+CoverImage CoverImage::fromFile( const QString& strFilename )
+{
+    QFile cl_file( strFilename );
+    if ( !cl_file.open( QIODevice::ReadOnly ) )
+        return CoverImage();
+    return CoverImage( cl_file.readAll() );
+}
+
+QSize CoverImage::size() const
+{
+    QBuffer cl_buffer;
+    cl_buffer.setData( m_strData );
+    cl_buffer.open( QIODevice::ReadOnly );
+    return QImageReader( &cl_buffer ).size();
+}
+
+static QImage decodeScaled( QByteArray strData, QSize clMaxSize )
+{
+    QBuffer cl_buffer;
+    cl_buffer.setData( strData );
+    cl_buffer.open( QIODevice::ReadOnly );
+    QImageReader cl_reader( &cl_buffer );
+    QSize cl_size = cl_reader.size();
+    if ( cl_size.isValid() && ( cl_size.width() > clMaxSize.width() || cl_size.height() > clMaxSize.height() ) )
+        cl_reader.setScaledSize( cl_size.scaled( clMaxSize, Qt::KeepAspectRatio ) );
+    return cl_reader.read();
+}
+
+QFuture<QImage> CoverImage::decodePreview( const QSize& rclMaxSize ) const
+{
+    return QtConcurrent::run( &decodeScaled, m_strData, rclMaxSize );
+}
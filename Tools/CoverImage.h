@@ -0,0 +1,39 @@
+#ifndef COVERIMAGE_H
+#define COVERIMAGE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QSize>
+#include <QFuture>
+#include <QImage>
+
+// an encoded cover image as embedded in a file or downloaded, together with its MIME type. It is only decoded for
+// display, so that saving writes the original bytes
+class CoverImage
+{
+public:
+    CoverImage() = default;
+    // the MIME type is detected from the data, which is kept as it is. Data in an unknown format makes a null image
+    explicit CoverImage( QByteArray strData );
+    static CoverImage fromFile( const QString& strFilename );
+
+    bool              isNull() const { return m_strMimeType.isEmpty(); }
+    const QByteArray& data() const { return m_strData; }
+    const QString&    mimeType() const { return m_strMimeType; }
+    // JPEG and PNG, that every tag format and player supports
+    bool              isEmbeddable() const;
+    // the image itself if embeddable, otherwise transcoded to JPEG. Only to be called when writing the cover, as it
+    // decodes the whole image. A failed transcode makes a null image
+    CoverImage        toEmbeddable() const;
+    // reads the image header only
+    QSize             size() const;
+    // decodes the image on the global thread pool, scaled down to fit into the given size while decoding.
+    // Large JPEGs are then only partially decoded
+    QFuture<QImage>   decodePreview( const QSize& rclMaxSize ) const;
+
+protected:
+    QByteArray m_strData;
+    QString    m_strMimeType;
+};
+
+#endif // COVERIMAGE_H
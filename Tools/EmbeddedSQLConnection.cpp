@@ -1,11 +1,160 @@
 #include "EmbeddedSQLConnection.h"
 #include <mysql/mysql.h>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QPointer>
+#include <algorithm>
 #include <array>
+#include <deque>
 
-#define CHECK_MYSQL( Fun, Description ) if ( int errornum = Fun; errornum != 0 ) throwMysqlError( errornum, "failed to " Description ": %1 (error %2)" );
+#define CHECK_MYSQL( Client, Fun, Description ) if ( int errornum = Fun; errornum != 0 ) throwMysqlError( Client, errornum, "failed to " Description ": %1 (error %2)" );
 
 
 struct EmbeddedSQLConnection::MySQLConn : public MYSQL {};
+
+static void throwStatementError( MYSQL_STMT* pclStatement, QString strText )
+{
+    QString str_error( mysql_stmt_error(pclStatement) );
+    str_error.replace("%","%%");
+    throw std::runtime_error( qPrintable( strText.arg( str_error ).arg( mysql_stmt_errno(pclStatement) ) ) );
+}
+
+#define CHECK_MYSQL_STMT( Statement, Fun, Description ) if ( Fun != 0 ) throwStatementError( Statement, "failed to " Description ": %1 (error %2)" );
+
+// prepared statements of a client connection, identified by their query text. They have to be closed before the connection
+struct EmbeddedSQLConnection::StatementCache
+{
+    ~StatementCache() { clear(); }
+
+    MYSQL_STMT* get( MySQLConn* pclClient, const QString& strQuery ) {
+        auto it_statement = mapStatements.find( strQuery );
+        if ( it_statement != mapStatements.end() )
+            return it_statement->second;
+        MYSQL_STMT* pcl_statement = mysql_stmt_init( pclClient );
+        if ( !pcl_statement )
+            throwMysqlError( pclClient, "failed to init statement: %1" );
+        QByteArray arr_query = strQuery.toUtf8();
+        if ( mysql_stmt_prepare( pcl_statement, arr_query.constData(), static_cast<unsigned long>(arr_query.size()) ) != 0 )
+        {
+            QString str_error( mysql_stmt_error(pcl_statement) );
+            mysql_stmt_close( pcl_statement );
+            throw std::runtime_error( qPrintable( QString("failed to prepare statement: %1").arg( str_error ) ) );
+        }
+        mapStatements.emplace( strQuery, pcl_statement );
+        return pcl_statement;
+    }
+
+    // statements that failed are prepared again on the next use
+    void remove( const QString& strQuery ) {
+        auto it_statement = mapStatements.find( strQuery );
+        if ( it_statement != mapStatements.end() )
+        {
+            mysql_stmt_close( it_statement->second );
+            mapStatements.erase( it_statement );
+        }
+    }
+
+    void clear() {
+        for ( auto& rcl_statement : mapStatements )
+            mysql_stmt_close( rcl_statement.second );
+        mapStatements.clear();
+    }
+
+    std::map<QString,MYSQL_STMT*> mapStatements;
+};
+
+// executes work one after another on its own connection to the database
+class EmbeddedSQLConnection::QueryWorkerThread : public QThread
+{
+public:
+    struct Job
+    {
+        QString strPurpose;
+        std::function<bool(const StatementQuery&)> funWork;
+        std::function<void()>                      funFinished;
+    };
+
+    QueryWorkerThread( EmbeddedSQLConnection* pclConnection )
+    : QThread()
+    , m_pclConnection(pclConnection)
+    {}
+
+    // pending jobs with the same purpose are replaced by the new one
+    void enqueue( Job&& clJob ) {
+        QMutexLocker cl_lock( &m_clMutex );
+        auto it_job = std::find_if( m_deqJobs.begin(), m_deqJobs.end(), [&clJob]( const Job& rcl_job ) { return rcl_job.strPurpose == clJob.strPurpose; } );
+        if ( it_job != m_deqJobs.end() )
+            *it_job = std::move(clJob);
+        else
+            m_deqJobs.push_back( std::move(clJob) );
+        m_clJobAvailable.wakeOne();
+    }
+
+    // a running job is superseded, if there is a newer one with the same purpose
+    bool isSuperseded( const QString& strPurpose ) {
+        QMutexLocker cl_lock( &m_clMutex );
+        return m_bStop || std::any_of( m_deqJobs.begin(), m_deqJobs.end(), [&strPurpose]( const Job& rcl_job ) { return rcl_job.strPurpose == strPurpose; } );
+    }
+
+    void stop() {
+        QMutexLocker cl_lock( &m_clMutex );
+        m_deqJobs.clear();
+        m_bStop = true;
+        m_clJobAvailable.wakeOne();
+    }
+
+    void run() override {
+        // every thread using the client library needs its own initialization
+        mysql_thread_init();
+        MySQLConn* pcl_client = nullptr;
+        StatementCache cl_statements;
+        for(;;)
+        {
+            Job cl_job;
+            {
+                QMutexLocker cl_lock( &m_clMutex );
+                while ( m_deqJobs.empty() && !m_bStop )
+                    m_clJobAvailable.wait( &m_clMutex );
+                if ( m_bStop )
+                    break;
+                cl_job = std::move( m_deqJobs.front() );
+                m_deqJobs.pop_front();
+            }
+            QString str_query;
+            try
+            {
+                if ( !pcl_client )
+                    pcl_client = m_pclConnection->openClient();
+                // stop fetching rows as soon as the result isn't of interest anymore
+                StatementQuery fun_query = [this, &cl_job, &pcl_client, &cl_statements, &str_query]( const QString& strQuery, const QStringList& lstParameters, const std::function<void(const Row&)>& funRow ) {
+                    str_query = strQuery;
+                    return streamStatementResults( pcl_client, cl_statements, strQuery, lstParameters, funRow, [this,&cl_job]{ return isSuperseded( cl_job.strPurpose ); } );
+                };
+                if ( cl_job.funWork( fun_query ) )
+                    cl_job.funFinished();
+            }
+            catch( const std::exception& rclExc )
+            {
+                // signals of the connection are only emitted in its own thread
+                EmbeddedSQLConnection* pcl_connection = m_pclConnection;
+                QString str_error = QString("error during asynchronous execution of query\n\n%1\n\n:%2").arg(str_query,QString(rclExc.what()));
+                QMetaObject::invokeMethod( pcl_connection, [pcl_connection, str_error]() { emit pcl_connection->error( str_error ); }, Qt::QueuedConnection );
+            }
+        }
+        cl_statements.clear();
+        if ( pcl_client )
+            mysql_close( pcl_client );
+        mysql_thread_end();
+    }
+
+protected:
+    EmbeddedSQLConnection* m_pclConnection;
+    QMutex          m_clMutex;
+    QWaitCondition  m_clJobAvailable;
+    std::deque<Job> m_deqJobs;
+    bool            m_bStop{false};
+};
     
 EmbeddedSQLConnection::EmbeddedSQLConnection( QObject *pclParent )
 : QObject(pclParent)
@@ -57,6 +206,34 @@ void EmbeddedSQLConnection::closeServer()
     }
 }
    
+EmbeddedSQLConnection::MySQLConn* EmbeddedSQLConnection::openClient() const
+{
+    MySQLConn* pcl_client = reinterpret_cast<MySQLConn*>( mysql_init(nullptr) );
+    if ( !pcl_client )
+        throw std::runtime_error( "failed to init mysql client" );
+
+    try
+    {
+        // amarok stores its collection as UTF-8, let the connection transfer it unchanged
+        CHECK_MYSQL( pcl_client, mysql_options(pcl_client, MYSQL_SET_CHARSET_NAME, "utf8mb4"), "set character set of connection" );
+        MYSQL* mysql;
+        if ( m_clConnectionParameters.bEmbedded )
+        {
+            CHECK_MYSQL( pcl_client, mysql_options(pcl_client, MYSQL_OPT_USE_EMBEDDED_CONNECTION, nullptr), "set option for using embedded MySQL" );
+            mysql = mysql_real_connect(pcl_client, nullptr, nullptr, nullptr, qPrintable(m_clConnectionParameters.strDatabase), 0, nullptr,0);
+        }
+        else
+            mysql = mysql_real_connect(pcl_client, nullptr, qPrintable(m_clConnectionParameters.strUser), qPrintable(m_clConnectionParameters.strPassword), qPrintable(m_clConnectionParameters.strDatabase), 0, nullptr,0);
+        if ( mysql == nullptr || mysql != pcl_client )
+            throwMysqlError( pcl_client, "failed to connect to database: %1" );
+        return pcl_client;
+    }
+    catch ( ... )
+    {
+        mysql_close( pcl_client );
+        throw;
+    }
+}
 
 void EmbeddedSQLConnection::connectToEmbeddedDB( const QString& strDatabase )
 {
@@ -66,16 +243,12 @@ void EmbeddedSQLConnection::connectToEmbeddedDB( const QString& strDatabase )
     //disconnect previous connection first
     disconnectFromDB();
     
+    m_clConnectionParameters = ConnectionParameters();
+    m_clConnectionParameters.bEmbedded   = true;
+    m_clConnectionParameters.strDatabase = strDatabase;
     try
     {
-        m_pclClient = reinterpret_cast<MySQLConn*>( mysql_init(nullptr) );
-        if ( !m_pclClient )
-            throw std::runtime_error( "failed to init mysql client" );
-    
-        CHECK_MYSQL( mysql_options(m_pclClient, MYSQL_OPT_USE_EMBEDDED_CONNECTION, nullptr), "set option for using embedded MySQL" );
-        MYSQL* mysql = mysql_real_connect(m_pclClient, nullptr, nullptr, nullptr, qPrintable(strDatabase), 0, nullptr,0);
-        if ( mysql == nullptr || mysql != m_pclClient )
-            throwMysqlError( "failed to connect to database: %1" );
+        m_pclClient = openClient();
         emit connected();
     }
     catch ( ... )
@@ -90,15 +263,13 @@ void EmbeddedSQLConnection::connectToExternalDB(const QString & strUser,const QS
     //disconnect previous connection first
     disconnectFromDB();
 
+    m_clConnectionParameters.bEmbedded   = false;
+    m_clConnectionParameters.strUser     = strUser;
+    m_clConnectionParameters.strPassword = strPassword;
+    m_clConnectionParameters.strDatabase = strDatabase;
     try
     {
-        m_pclClient = reinterpret_cast<MySQLConn*>( mysql_init(nullptr) );
-        if ( !m_pclClient )
-            throw std::runtime_error( "failed to init mysql client" );
-
-        MYSQL* mysql = mysql_real_connect(m_pclClient, nullptr, qPrintable(strUser), qPrintable(strPassword), qPrintable(strDatabase), 0, nullptr,0);
-        if ( mysql == nullptr || mysql != m_pclClient )
-            throwMysqlError( "failed to connect to database: %1" );
+        m_pclClient = openClient();
         emit connected();
     }
     catch ( ... )
@@ -108,27 +279,62 @@ void EmbeddedSQLConnection::connectToExternalDB(const QString & strUser,const QS
     }
 }
 
-template<class ResultT, class ParseFunT>
-ResultT EmbeddedSQLConnection::queryAndParseResults( const QString& strQuery, ParseFunT parseFun )
+QString EmbeddedSQLConnection::Row::toString( int iField ) const
 {
-    ResultT vec_results;
-    if ( !isConnected() )
+    if ( isNull(iField) ) // leave the QString to be null()
+        return QString();
+    return QString::fromUtf8( m_ppcFields[iField], static_cast<int>(m_puiLengths[iField]) );
+}
+
+QByteArray EmbeddedSQLConnection::Row::toUtf8( int iField ) const
+{
+    if ( isNull(iField) )
+        return QByteArray();
+    return QByteArray( m_ppcFields[iField], static_cast<int>(m_puiLengths[iField]) );
+}
+
+int EmbeddedSQLConnection::Row::toInt( int iField ) const
+{
+    if ( isNull(iField) )
+        return 0;
+    return QByteArray::fromRawData( m_ppcFields[iField], static_cast<int>(m_puiLengths[iField]) ).toInt();
+}
+
+bool EmbeddedSQLConnection::streamResults( MySQLConn* pclClient, const QString& strQuery, const std::function<void(const Row&)>& funRow, const std::function<bool()>& funCancelled )
+{
+    if ( !pclClient )
         throw std::runtime_error("not connected to a database");
     
-    CHECK_MYSQL( mysql_real_query(m_pclClient, strQuery.toLatin1().data(), strQuery.length() ), "query database" )
+    QByteArray arr_query = strQuery.toUtf8();
+    CHECK_MYSQL( pclClient, mysql_real_query(pclClient, arr_query.constData(), static_cast<unsigned long>(arr_query.size()) ), "query database" )
  
-    MYSQL_RES* pcl_results = mysql_store_result( m_pclClient );
+    // rows are fetched one by one from the server instead of storing the whole result on the client first
+    MYSQL_RES* pcl_results = mysql_use_result( pclClient );
     if ( !pcl_results ) // query might have returned an empty result set
     {
-        CHECK_MYSQL( mysql_errno(m_pclClient), "store query result" );
-        return vec_results;
+        CHECK_MYSQL( pclClient, mysql_errno(pclClient), "fetch query result" );
+        return true;
     }
     
     try
     {
-        vec_results = parseFun( pcl_results );
-        mysql_free_result( pcl_results );
-        return vec_results;
+        const int i_num_fields = static_cast<int>( mysql_num_fields(pcl_results) );
+        bool b_completed = true;
+        MYSQL_ROW cl_record;
+        while ( (cl_record = mysql_fetch_row(pcl_results)) )
+        {
+            if ( funCancelled && funCancelled() )
+            {
+                b_completed = false;
+                break;
+            }
+            funRow( Row( cl_record, mysql_fetch_lengths(pcl_results), i_num_fields ) );
+        }
+        // fetching stops on errors as well
+        if ( b_completed )
+            CHECK_MYSQL( pclClient, mysql_errno(pclClient), "fetch query result" );
+        mysql_free_result( pcl_results ); // discards all rows not fetched yet
+        return b_completed;
     }
     catch ( ... )
     {
@@ -137,30 +343,120 @@ ResultT EmbeddedSQLConnection::queryAndParseResults( const QString& strQuery, Pa
     }
 }
 
-/// return value contains one row of the result per vector entry, which in turn contains a vector of fields
-std::vector<std::vector<QString>> EmbeddedSQLConnection::query( const QString& strQuery )
+bool EmbeddedSQLConnection::streamStatementResults( MySQLConn* pclClient, StatementCache& rclStatements, const QString& strQuery, const QStringList& lstParameters, const std::function<void(const Row&)>& funRow, const std::function<bool()>& funCancelled )
 {
+    if ( !pclClient )
+        throw std::runtime_error("not connected to a database");
+
+    // the statement is only parsed and planned on its first use
+    MYSQL_STMT* pcl_statement = rclStatements.get( pclClient, strQuery );
     try
     {
-        return queryAndParseResults<std::vector<std::vector<QString>>>( strQuery, []( MYSQL_RES* pcl_results ) {
-            std::vector<std::vector<QString>> vec_results;
-            size_t ui_num_rows = mysql_num_rows(pcl_results);
-            size_t ui_num_cols = mysql_num_fields(pcl_results);
-            vec_results.reserve( ui_num_rows );
+        if ( mysql_stmt_param_count( pcl_statement ) != static_cast<unsigned long>(lstParameters.size()) )
+            throw std::runtime_error( qPrintable( QString("statement expects %1 parameters, but %2 were given").arg( mysql_stmt_param_count( pcl_statement ) ).arg( lstParameters.size() ) ) );
+
+        // all parameters are bound as strings, the server converts them if necessary
+        std::vector<QByteArray>    vec_parameter_data;
+        std::vector<unsigned long> vec_parameter_lengths;
+        std::vector<MYSQL_BIND>    vec_parameters( static_cast<size_t>(lstParameters.size()) );
+        vec_parameter_data.reserve( vec_parameters.size() );
+        vec_parameter_lengths.reserve( vec_parameters.size() );
+        for ( const QString& str_parameter : lstParameters )
+        {
+            vec_parameter_data.push_back( str_parameter.toUtf8() );
+            vec_parameter_lengths.push_back( static_cast<unsigned long>(vec_parameter_data.back().size()) );
+            MYSQL_BIND& rcl_bind = vec_parameters[vec_parameter_data.size()-1];
+            rcl_bind.buffer_type   = str_parameter.isNull() ? MYSQL_TYPE_NULL : MYSQL_TYPE_STRING;
+            rcl_bind.buffer        = vec_parameter_data.back().data();
+            rcl_bind.buffer_length = vec_parameter_lengths.back();
+            rcl_bind.length        = &vec_parameter_lengths.back();
+        }
+        CHECK_MYSQL_STMT( pcl_statement, mysql_stmt_bind_param( pcl_statement, vec_parameters.data() ), "bind statement parameters" );
+        CHECK_MYSQL_STMT( pcl_statement, mysql_stmt_execute( pcl_statement ), "execute statement" );
+
+        MYSQL_RES* pcl_metadata = mysql_stmt_result_metadata( pcl_statement );
+        if ( !pcl_metadata ) // statement does not produce a result set
+            return true;
+        const int i_num_fields = static_cast<int>( mysql_num_fields(pcl_metadata) );
+        mysql_free_result( pcl_metadata );
+
+        // result fields are fetched into growing character buffers, that are presented by a row view
+        std::vector<QByteArray>    vec_buffers( static_cast<size_t>(i_num_fields), QByteArray( 256, Qt::Uninitialized ) );
+        std::vector<unsigned long> vec_lengths( static_cast<size_t>(i_num_fields), 0 );
+        std::vector<my_bool>       vec_is_null( static_cast<size_t>(i_num_fields), 0 );
+        std::vector<MYSQL_BIND>    vec_results( static_cast<size_t>(i_num_fields) );
+        std::vector<char*>         vec_fields( static_cast<size_t>(i_num_fields), nullptr );
+        auto bindResults = [&]() {
+            for ( size_t i = 0; i < vec_results.size(); ++i )
+            {
+                vec_results[i] = MYSQL_BIND();
+                vec_results[i].buffer_type   = MYSQL_TYPE_STRING;
+                vec_results[i].buffer        = vec_buffers[i].data();
+                vec_results[i].buffer_length = static_cast<unsigned long>(vec_buffers[i].size());
+                vec_results[i].length        = &vec_lengths[i];
+                vec_results[i].is_null       = &vec_is_null[i];
+            }
+            CHECK_MYSQL_STMT( pcl_statement, mysql_stmt_bind_result( pcl_statement, vec_results.data() ), "bind statement results" );
+        };
+        bindResults();
 
-            MYSQL_ROW cl_record;
-            while ( (cl_record = mysql_fetch_row(pcl_results)) )
+        bool b_completed = true;
+        for(;;)
+        {
+            int i_status = mysql_stmt_fetch( pcl_statement );
+            if ( i_status == MYSQL_NO_DATA )
+                break;
+            if ( i_status == 1 )
+                throwStatementError( pcl_statement, "failed to fetch statement result: %1 (error %2)" );
+            if ( i_status == MYSQL_DATA_TRUNCATED )
             {
-                std::vector<QString> vec_row( ui_num_cols );
-                for ( size_t i = 0; i < ui_num_cols; ++i )
+                // enlarge the buffers of the truncated fields and fetch them again
+                bool b_rebind = false;
+                for ( size_t i = 0; i < vec_buffers.size(); ++i )
                 {
-                    if ( cl_record[i] != nullptr ) //nullptr indicates a NULL result value. In that case, leave the QString to be null()
-                        vec_row[i] = QString::fromLatin1( cl_record[i] );
+                    if ( vec_is_null[i] || vec_lengths[i] <= static_cast<unsigned long>(vec_buffers[i].size()) )
+                        continue;
+                    vec_buffers[i].resize( static_cast<int>(vec_lengths[i]) );
+                    vec_results[i].buffer        = vec_buffers[i].data();
+                    vec_results[i].buffer_length = vec_lengths[i];
+                    CHECK_MYSQL_STMT( pcl_statement, mysql_stmt_fetch_column( pcl_statement, &vec_results[i], static_cast<unsigned int>(i), 0 ), "fetch truncated column" );
+                    b_rebind = true;
                 }
-                vec_results.emplace_back( std::move(vec_row) );
+                if ( b_rebind )
+                    bindResults();
+            }
+            if ( funCancelled && funCancelled() )
+            {
+                b_completed = false;
+                break;
             }
-            return vec_results;
+            for ( size_t i = 0; i < vec_fields.size(); ++i )
+                vec_fields[i] = vec_is_null[i] ? nullptr : vec_buffers[i].data();
+            funRow( Row( vec_fields.data(), vec_lengths.data(), i_num_fields ) );
+        }
+        mysql_stmt_free_result( pcl_statement ); // discards all rows not fetched yet
+        return b_completed;
+    }
+    catch ( ... )
+    {
+        rclStatements.remove( strQuery );
+        throw;
+    }
+}
+
+/// return value contains one row of the result per vector entry, which in turn contains a vector of fields
+std::vector<std::vector<QString>> EmbeddedSQLConnection::query( const QString& strQuery )
+{
+    std::vector<std::vector<QString>> vec_results;
+    try
+    {
+        streamResults( m_pclClient, strQuery, [&vec_results]( const Row& rclRow ) {
+            std::vector<QString> vec_row( static_cast<size_t>(rclRow.size()) );
+            for ( int i = 0; i < rclRow.size(); ++i )
+                vec_row[i] = rclRow.toString(i);
+            vec_results.emplace_back( std::move(vec_row) );
         } );
+        return vec_results;
     }
     catch( const std::exception& rclExc )
     {
@@ -173,8 +469,51 @@ std::vector<std::vector<QString>> EmbeddedSQLConnection::query( const QString& s
     return {};
 }
 
+void EmbeddedSQLConnection::runAsync( const QString& strPurpose, QObject* pclContext, std::function<bool(const StatementQuery&)> funWork, std::function<void()> funFinished )
+{
+    if ( !isConnected() )
+    {
+        emit error(qPrintable(QString("not connected to a database for %1").arg(strPurpose)));
+        return;
+    }
+    if ( !m_pclQueryWorker )
+    {
+        m_pclQueryWorker = new QueryWorkerThread( this );
+        m_pclQueryWorker->start();
+    }
+
+    quint64 ui_ticket = ++m_uiLastTicket;
+    m_mapLatestTickets[strPurpose] = ui_ticket;
+    QPointer<QObject> pcl_context( pclContext );
+    auto funDeliver = [this, strPurpose, ui_ticket, pcl_context, funFinished = std::move(funFinished)]() {
+        // called in the worker thread, hand over to the thread of the connection
+        QMetaObject::invokeMethod( this, [this, strPurpose, ui_ticket, pcl_context, funFinished]() {
+            // drop results of work that has been superseded in the meantime
+            auto it_latest = m_mapLatestTickets.find( strPurpose );
+            if ( it_latest == m_mapLatestTickets.end() || it_latest->second != ui_ticket || !pcl_context )
+                return;
+            funFinished();
+        }, Qt::QueuedConnection );
+    };
+    m_pclQueryWorker->enqueue( { strPurpose, std::move(funWork), std::move(funDeliver) } );
+}
+
+void EmbeddedSQLConnection::stopQueryWorker()
+{
+    if ( m_pclQueryWorker )
+    {
+        m_pclQueryWorker->stop();
+        m_pclQueryWorker->wait();
+        delete m_pclQueryWorker;
+        m_pclQueryWorker = nullptr;
+    }
+    // results of work still on its way are not of interest anymore
+    m_mapLatestTickets.clear();
+}
+
 void EmbeddedSQLConnection::disconnectFromDB()
 {
+    stopQueryWorker();
     if ( m_pclClient )
     {
         mysql_close( m_pclClient );
@@ -187,16 +526,16 @@ bool EmbeddedSQLConnection::isConnected() const
     return m_pclClient != nullptr;
 }
 
-void EmbeddedSQLConnection::throwMysqlError( QString strText ) const
+void EmbeddedSQLConnection::throwMysqlError( MySQLConn* pclClient, QString strText )
 {
-    QString str_error( mysql_error(m_pclClient) );
+    QString str_error( mysql_error(pclClient) );
     str_error.replace("%","%%");
     throw std::runtime_error( qPrintable( strText.arg( str_error ) ) );
 }
 
-void EmbeddedSQLConnection::throwMysqlError( int iError, QString strText ) const
+void EmbeddedSQLConnection::throwMysqlError( MySQLConn* pclClient, int iError, QString strText )
 {
-    QString str_error( mysql_error(m_pclClient) );
+    QString str_error( mysql_error(pclClient) );
     str_error.replace("%","%%");
     throw std::runtime_error( qPrintable( strText.arg( str_error ).arg(iError) ) );
 }
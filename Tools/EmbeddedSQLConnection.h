@@ -2,12 +2,36 @@
 #define EMBEDDEDSQLCONNECTION_H
 
 #include <QObject>
+#include <QStringList>
+#include <functional>
+#include <map>
 #include <vector>
 
 class EmbeddedSQLConnection : public QObject
 {
     Q_OBJECT
 public:
+    /// view on the fields of the current row of a result. Only valid while it is handed to a callback
+    class Row
+    {
+    public:
+        int     size() const { return m_iNumFields; }
+        bool    isNull( int iField ) const { return m_ppcFields[iField] == nullptr; }
+        QString toString( int iField ) const;
+        /// the field as it was transferred (UTF-8), without decoding it
+        QByteArray toUtf8( int iField ) const;
+        int     toInt( int iField ) const;
+    protected:
+        friend class EmbeddedSQLConnection;
+        Row( char** ppcFields, const unsigned long* puiLengths, int iNumFields ) : m_ppcFields(ppcFields), m_puiLengths(puiLengths), m_iNumFields(iNumFields) {}
+        char**               m_ppcFields;
+        const unsigned long* m_puiLengths;
+        int                  m_iNumFields;
+    };
+    /// executes a query as prepared statement with the parameters bound to its placeholders ("?") and streams the result row by row to funRow.
+    /// Returns false, if the work it belongs to has been superseded before all rows have been handed over
+    using StatementQuery = std::function<bool( const QString& strQuery, const QStringList& lstParameters, const std::function<void(const Row&)>& funRow )>;
+    
     EmbeddedSQLConnection( QObject *pclParent = nullptr );
     ~EmbeddedSQLConnection() override;
     
@@ -22,19 +46,44 @@ public:
     /// return value contains one row of the result per vector entry, which in turn contains a vector of fields
     std::vector<std::vector<QString>> query( const QString& strQuery );
     
+    /// runs funWork on a worker thread with its own connection, it executes its queries through the given function. Statements are prepared once and cached by their query text.
+    /// funFinished is called in the thread of this connection, if funWork returned true.
+    /// Newer work with the same purpose supersedes older work: it is dropped if not started yet, otherwise its queries stop and its result is discarded.
+    /// funFinished is not called, if pclContext was destroyed in the meantime. Errors are reported by the error signal
+    void runAsync( const QString& strPurpose, QObject* pclContext, std::function<bool(const StatementQuery&)> funWork, std::function<void()> funFinished );
+    
 signals:
     void connected();
     void error( QString );
 
 protected:
-    void throwMysqlError( QString strText ) const;
-    void throwMysqlError( int iError, QString strText ) const;
-    template<class ResultT, class ParseFunT>
-    ResultT queryAndParseResults( const QString& strQuery, ParseFunT parseFun );
-    
     struct MySQLConn;
-    MySQLConn* m_pclClient{nullptr};
-    bool       m_bServer{false};
+    struct StatementCache;
+    class QueryWorkerThread;
+    
+    MySQLConn* openClient() const;
+    void stopQueryWorker();
+    static void throwMysqlError( MySQLConn* pclClient, QString strText );
+    static void throwMysqlError( MySQLConn* pclClient, int iError, QString strText );
+    // returns false, if streaming has been cancelled before all rows have been handed over
+    static bool streamResults( MySQLConn* pclClient, const QString& strQuery, const std::function<void(const Row&)>& funRow, const std::function<bool()>& funCancelled = {} );
+    static bool streamStatementResults( MySQLConn* pclClient, StatementCache& rclStatements, const QString& strQuery, const QStringList& lstParameters, const std::function<void(const Row&)>& funRow, const std::function<bool()>& funCancelled = {} );
+    
+    // parameters of the current connection, used to open further connections for the worker thread
+    struct ConnectionParameters
+    {
+        bool    bEmbedded{true};
+        QString strUser;
+        QString strPassword;
+        QString strDatabase;
+    };
+    ConnectionParameters m_clConnectionParameters;
+    
+    MySQLConn*         m_pclClient{nullptr};
+    bool               m_bServer{false};
+    QueryWorkerThread* m_pclQueryWorker{nullptr};
+    quint64            m_uiLastTicket{0};
+    std::map<QString,quint64> m_mapLatestTickets; // ticket of the latest work per purpose
 };
 
 #endif // EMBEDDEDSQLCONNECTION_H
@@ -0,0 +1,182 @@
+#include "FolderTagIndex.h"
+#include <QtConcurrent>
+#include <taglib/fileref.h>
+#include <taglib/tag.h>
+#include <taglib/flacfile.h>
+#include <taglib/mpegfile.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/mp4file.h>
+#include <taglib/vorbisfile.h>
+#include <taglib/opusfile.h>
+#include <taglib/xiphcomment.h>
+#include <taglib/asffile.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+static const int s_iMaxScanThreads = 2;
+
+static QByteArray T2B( const TagLib::String& str )
+{
+    std::string str_utf8 = str.to8Bit(true);
+    return QByteArray( str_utf8.data(), static_cast<int>( str_utf8.size() ) );
+}
+
+static bool hasCover( TagLib::File* pclFile )
+{
+    if ( auto pcl_flac = dynamic_cast<TagLib::FLAC::File*>( pclFile ) )
+        return !pcl_flac->pictureList().isEmpty() || ( pcl_flac->ID3v2Tag() && pcl_flac->ID3v2Tag()->frameListMap().contains("APIC") );
+    if ( auto pcl_mpeg = dynamic_cast<TagLib::MPEG::File*>( pclFile ) )
+        return pcl_mpeg->ID3v2Tag() && pcl_mpeg->ID3v2Tag()->frameListMap().contains("APIC");
+    if ( auto pcl_mp4 = dynamic_cast<TagLib::MP4::File*>( pclFile ) )
+        return pcl_mp4->tag() && pcl_mp4->tag()->contains("covr");
+    if ( auto pcl_vorbis = dynamic_cast<TagLib::Ogg::Vorbis::File*>( pclFile ) )
+        return pcl_vorbis->tag() && !pcl_vorbis->tag()->pictureList().isEmpty();
+    if ( auto pcl_opus = dynamic_cast<TagLib::Ogg::Opus::File*>( pclFile ) )
+        return pcl_opus->tag() && !pcl_opus->tag()->pictureList().isEmpty();
+    if ( auto pcl_asf = dynamic_cast<TagLib::ASF::File*>( pclFile ) )
+        return pcl_asf->tag() && pcl_asf->tag()->attributeListMap().contains("WM/Picture");
+    return false;
+}
+
+FolderTagIndex::FolderTagIndex( QObject *pclParent )
+: QObject( pclParent )
+{
+    m_clScanPool.setMaxThreadCount( s_iMaxScanThreads );
+    connect( &m_clScan, &QFutureWatcher<FileTags>::resultReadyAt, this, &FolderTagIndex::scanResultReady );
+    connect( &m_clScan, &QFutureWatcher<FileTags>::finished, this, &FolderTagIndex::scanFinished );
+}
+
+FolderTagIndex::~FolderTagIndex()
+{
+    m_clScan.cancel();
+    m_clScan.waitForFinished();
+}
+
+FolderTagIndex::FileTags FolderTagIndex::readFile( const QString& strFullFilePath )
+{
+    FileTags cl_tags;
+    cl_tags.strFullFilePath = strFullFilePath;
+    TagLib::FileRef cl_file( strFullFilePath.toLocal8Bit().data(), true, TagLib::AudioProperties::Fast );
+    if ( cl_file.isNull() )
+        return cl_tags;
+    cl_tags.bValid = true;
+    if ( TagLib::Tag* pcl_tag = cl_file.tag() )
+    {
+        cl_tags.strArtist = T2B( pcl_tag->artist() );
+        cl_tags.strAlbum  = T2B( pcl_tag->album() );
+        cl_tags.strTitle  = T2B( pcl_tag->title() );
+        cl_tags.iTrack    = static_cast<int>( pcl_tag->track() );
+        cl_tags.iYear     = static_cast<int>( pcl_tag->year() );
+    }
+    if ( cl_file.audioProperties() )
+        cl_tags.iDurationSecs = cl_file.audioProperties()->lengthInSeconds();
+    cl_tags.bHasCover = hasCover( cl_file.file() );
+    return cl_tags;
+}
+
+void FolderTagIndex::scan( const QStringList& lstFullFilePaths )
+{
+    clear();
+    // QtConcurrent::mapped always runs on the global pool in Qt 5, so the results are reported by hand
+    struct Scan
+    {
+        QFutureInterface<FileTags> clResults;
+        QStringList                lstFiles;
+        std::atomic<int>           iNextFile{0};
+        std::atomic<int>           iRunning{0};
+    };
+    auto pcl_scan = std::make_shared<Scan>();
+    pcl_scan->lstFiles = lstFullFilePaths;
+    pcl_scan->clResults.reportStarted();
+    m_clScan.setFuture( pcl_scan->clResults.future() );
+
+    int i_threads = std::min( s_iMaxScanThreads, lstFullFilePaths.size() );
+    if ( i_threads == 0 )
+    {
+        pcl_scan->clResults.reportFinished();
+        return;
+    }
+    pcl_scan->iRunning = i_threads;
+    for ( int i_thread = 0; i_thread < i_threads; ++i_thread )
+    {
+        QtConcurrent::run( &m_clScanPool, [pcl_scan]{
+            for ( int i_file; !pcl_scan->clResults.isCanceled() && ( i_file = pcl_scan->iNextFile++ ) < pcl_scan->lstFiles.size(); )
+                pcl_scan->clResults.reportResult( readFile( pcl_scan->lstFiles.at(i_file) ), i_file );
+            if ( --pcl_scan->iRunning == 0 )
+                pcl_scan->clResults.reportFinished();
+        } );
+    }
+}
+
+void FolderTagIndex::refresh( const QString& strFullFilePath )
+{
+    auto pcl_watcher = new QFutureWatcher<FileTags>( this );
+    quint64 ui_generation = m_uiGeneration;
+    connect( pcl_watcher, &QFutureWatcher<FileTags>::finished, this, [this,pcl_watcher,ui_generation]{
+        if ( ui_generation == m_uiGeneration )
+            addEntry( pcl_watcher->result() );
+        pcl_watcher->deleteLater();
+    } );
+    pcl_watcher->setFuture( QtConcurrent::run( &FolderTagIndex::readFile, strFullFilePath ) );
+}
+
+void FolderTagIndex::rename( const QString& strOldFullFilePath, const QString& strNewFullFilePath )
+{
+    auto it_entry = m_mapEntries.find( strOldFullFilePath );
+    if ( it_entry == m_mapEntries.end() || strOldFullFilePath == strNewFullFilePath )
+        return;
+    Entry cl_entry = std::move(*it_entry);
+    m_mapEntries.erase( it_entry );
+    m_mapEntries.insert( strNewFullFilePath, std::move(cl_entry) );
+    emit entryChanged( strNewFullFilePath );
+}
+
+void FolderTagIndex::remove( const QString& strFullFilePath )
+{
+    if ( m_mapEntries.remove( strFullFilePath ) > 0 )
+        emit entryChanged( strFullFilePath );
+}
+
+void FolderTagIndex::clear()
+{
+    m_clScan.cancel();
+    m_mapEntries.clear();
+    m_clStrings.clear();
+    ++m_uiGeneration;
+}
+
+const FolderTagIndex::Entry* FolderTagIndex::find( const QString& strFullFilePath ) const
+{
+    auto it_entry = m_mapEntries.constFind( strFullFilePath );
+    return ( it_entry != m_mapEntries.constEnd() ) ? &*it_entry : nullptr;
+}
+
+bool FolderTagIndex::isScanning() const
+{
+    return m_clScan.isRunning();
+}
+
+void FolderTagIndex::scanResultReady( int iIndex )
+{
+    addEntry( m_clScan.resultAt( iIndex ) );
+}
+
+void FolderTagIndex::addEntry( const FileTags& rclTags )
+{
+    if ( !rclTags.bValid )
+    {
+        remove( rclTags.strFullFilePath );
+        return;
+    }
+    Entry cl_entry;
+    cl_entry.strArtist     = m_clStrings.intern( rclTags.strArtist.constData(), rclTags.strArtist.size() );
+    cl_entry.strAlbum      = m_clStrings.intern( rclTags.strAlbum.constData(), rclTags.strAlbum.size() );
+    cl_entry.strTitle      = QString::fromUtf8( rclTags.strTitle );
+    cl_entry.iTrack        = rclTags.iTrack;
+    cl_entry.iYear         = rclTags.iYear;
+    cl_entry.iDurationSecs = rclTags.iDurationSecs;
+    cl_entry.bHasCover     = rclTags.bHasCover;
+    m_mapEntries.insert( rclTags.strFullFilePath, std::move(cl_entry) );
+    emit entryChanged( rclTags.strFullFilePath );
+}
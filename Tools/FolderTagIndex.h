@@ -0,0 +1,71 @@
+#ifndef FOLDERTAGINDEX_H
+#define FOLDERTAGINDEX_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QStringList>
+#include <QThreadPool>
+#include "StringPool.h"
+
+// tags and audio properties of the audio files of a folder. A scan reads them in the background on two threads
+// of its own, so the global thread pool stays free for refreshes and decoding covers. Each file is opened once. Artist and album names repeat within a folder, so their strings are
+// shared. Only to be used from the GUI thread
+class FolderTagIndex : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry
+    {
+        QString strArtist, strAlbum, strTitle;
+        int     iTrack = 0;
+        int     iYear = 0;
+        int     iDurationSecs = 0;
+        bool    bHasCover = false;
+    };
+
+    explicit FolderTagIndex( QObject *pclParent = nullptr );
+    ~FolderTagIndex() override;
+
+    // forgets all entries and starts reading the files
+    void scan( const QStringList& lstFullFilePaths );
+    // reads a single file again, e.g. after it was saved
+    void refresh( const QString& strFullFilePath );
+    void rename( const QString& strOldFullFilePath, const QString& strNewFullFilePath );
+    void remove( const QString& strFullFilePath );
+    void clear();
+
+    // nullptr, if the file has not been read (yet) or could not be read
+    const Entry* find( const QString& strFullFilePath ) const;
+    bool isScanning() const;
+
+signals:
+    void entryChanged( QString strFullFilePath );
+    void scanFinished();
+
+protected slots:
+    void scanResultReady( int iIndex );
+
+protected:
+    // encoded, as the shared strings are looked up by their encoding
+    struct FileTags
+    {
+        QString    strFullFilePath;
+        bool       bValid = false;
+        QByteArray strArtist, strAlbum, strTitle;
+        int        iTrack = 0;
+        int        iYear = 0;
+        int        iDurationSecs = 0;
+        bool       bHasCover = false;
+    };
+    static FileTags readFile( const QString& strFullFilePath );
+    void addEntry( const FileTags& rclTags );
+
+    QThreadPool              m_clScanPool;
+    QFutureWatcher<FileTags> m_clScan;
+    QHash<QString,Entry>     m_mapEntries;
+    StringPool               m_clStrings;
+    quint64                  m_uiGeneration = 0; // refreshes started before a new scan are dropped
+};
+
+#endif // FOLDERTAGINDEX_H
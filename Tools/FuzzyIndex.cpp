@@ -0,0 +1,103 @@
+#include "FuzzyIndex.h"
+#include <Tools/StringDistance.h>
+#include <QtConcurrent>
+#include <algorithm>
+
+// number of candidates ranked by string distance for each requested result
+static const int s_iCandidatesPerResult = 4;
+static const int s_iMinCandidates = 64;
+
+std::vector<quint32> FuzzyIndex::bigrams( const QString& strEntry )
+{
+    // pad the string with a null character at both ends, so that the first and last characters get their own bigram
+    const QString str_upper = strEntry.toUpper();
+    std::vector<quint32> vec_bigrams;
+    vec_bigrams.reserve( static_cast<size_t>(str_upper.size())+1 );
+    ushort ui_previous = 0;
+    for ( QChar c_char : str_upper )
+    {
+        vec_bigrams.push_back( (quint32(ui_previous) << 16) | c_char.unicode() );
+        ui_previous = c_char.unicode();
+    }
+    vec_bigrams.push_back( quint32(ui_previous) << 16 );
+    std::sort( vec_bigrams.begin(), vec_bigrams.end() );
+    vec_bigrams.erase( std::unique( vec_bigrams.begin(), vec_bigrams.end() ), vec_bigrams.end() );
+    return vec_bigrams;
+}
+
+void FuzzyIndex::build( const QStringList& lstEntries )
+{
+    clear();
+    m_lstEntries = lstEntries;
+    m_vecNumBigrams.reserve( static_cast<size_t>(m_lstEntries.size()) );
+    for ( int i_entry = 0; i_entry < m_lstEntries.size(); ++i_entry )
+    {
+        std::vector<quint32> vec_bigrams = bigrams( m_lstEntries.at(i_entry) );
+        m_vecNumBigrams.push_back( static_cast<int>(vec_bigrams.size()) );
+        for ( quint32 ui_bigram : vec_bigrams )
+            m_mapPostings[ui_bigram].push_back( i_entry );
+    }
+}
+
+void FuzzyIndex::clear()
+{
+    m_lstEntries.clear();
+    m_vecNumBigrams.clear();
+    m_mapPostings.clear();
+}
+
+int FuzzyIndex::size() const
+{
+    return m_lstEntries.size();
+}
+
+std::vector<std::pair<int,double>> FuzzyIndex::closest( const QString& strQuery, int iMaxResults ) const
+{
+    if ( strQuery.isEmpty() || iMaxResults <= 0 || m_lstEntries.isEmpty() )
+        return {};
+
+    // count the bigrams shared with the query. Only entries touched here are candidates
+    std::vector<quint32> vec_query_bigrams = bigrams( strQuery );
+    std::vector<int> vec_shared( static_cast<size_t>(m_lstEntries.size()), 0 );
+    std::vector<int> vec_candidates;
+    for ( quint32 ui_bigram : vec_query_bigrams )
+    {
+        auto it_postings = m_mapPostings.constFind( ui_bigram );
+        if ( it_postings == m_mapPostings.constEnd() )
+            continue;
+        for ( int i_entry : *it_postings )
+        {
+            if ( vec_shared[i_entry]++ == 0 )
+                vec_candidates.push_back( i_entry );
+        }
+    }
+
+    // keep only the most similar candidates in terms of bigrams (dice coefficient)
+    const int i_num_query_bigrams = static_cast<int>(vec_query_bigrams.size());
+    auto similarity = [&]( int i_entry ) {
+        return 2.0*vec_shared[i_entry]/static_cast<double>( i_num_query_bigrams + m_vecNumBigrams[i_entry] );
+    };
+    size_t ui_num_candidates = static_cast<size_t>( std::max( iMaxResults*s_iCandidatesPerResult, s_iMinCandidates ) );
+    if ( vec_candidates.size() > ui_num_candidates )
+    {
+        std::nth_element( vec_candidates.begin(), vec_candidates.begin()+static_cast<std::ptrdiff_t>(ui_num_candidates), vec_candidates.end(),
+                          [&]( int i_lhs, int i_rhs ) { return similarity(i_lhs) > similarity(i_rhs); } );
+        vec_candidates.resize( ui_num_candidates );
+    }
+
+    // rank the remaining candidates by their actual string distance (in parallel)
+    StringDistance cl_query( strQuery, StringDistance::CaseInsensitive );
+    std::vector<std::pair<int,double>> vec_results;
+    vec_results.reserve( vec_candidates.size() );
+    for ( int i_entry : vec_candidates )
+        vec_results.emplace_back( i_entry, 1. );
+    QtConcurrent::blockingMap( vec_results, [this,&cl_query]( std::pair<int,double>& rcl_result ) {
+        rcl_result.second = cl_query.NormalizedLevenshtein( m_lstEntries.at(rcl_result.first) );
+    } );
+    std::sort( vec_results.begin(), vec_results.end(), []( const std::pair<int,double>& rcl_lhs, const std::pair<int,double>& rcl_rhs ) {
+        return rcl_lhs.second < rcl_rhs.second || ( rcl_lhs.second == rcl_rhs.second && rcl_lhs.first < rcl_rhs.first );
+    } );
+    if ( vec_results.size() > static_cast<size_t>(iMaxResults) )
+        vec_results.resize( static_cast<size_t>(iMaxResults) );
+    return vec_results;
+}
@@ -0,0 +1,31 @@
+#ifndef FUZZYINDEX_H
+#define FUZZYINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+// case insensitive bigram inverted index for finding the closest entries of a (large) collection of strings.
+// Only entries sharing bigrams with the query are considered and only the most promising ones are ranked by string distance
+class FuzzyIndex
+{
+public:
+    FuzzyIndex() = default;
+
+    void build( const QStringList& lstEntries );
+    void clear();
+    int  size() const;
+
+    // returns the indices of the (at most) iMaxResults closest entries together with their normalized Levenshtein distance, ordered by distance
+    std::vector<std::pair<int,double>> closest( const QString& strQuery, int iMaxResults ) const;
+
+protected:
+    static std::vector<quint32> bigrams( const QString& strEntry );
+
+    QStringList                            m_lstEntries;
+    std::vector<int>                       m_vecNumBigrams; // number of distinct bigrams per entry
+    QHash<quint32,std::vector<int>>        m_mapPostings;   // entries containing a bigram, in ascending order
+};
+
+#endif // FUZZYINDEX_H
@@ -0,0 +1,223 @@
+#include "JsonStreamReader.h"
+#include <cstring>
+
+JsonStreamReader::JsonStreamReader( QByteArray strData )
+: m_strData( std::move(strData) )
+{
+}
+
+JsonStreamReader::TokenType JsonStreamReader::raiseError( const QString& strError )
+{
+    m_strError = QString( "%1 at offset %2" ).arg( strError ).arg( m_iPos );
+    m_eToken = Invalid;
+    return m_eToken;
+}
+
+void JsonStreamReader::skipWhitespace()
+{
+    const char* pc_data = m_strData.constData();
+    while ( m_iPos < m_strData.size() && ( pc_data[m_iPos] == ' ' || pc_data[m_iPos] == '\n' || pc_data[m_iPos] == '\r' || pc_data[m_iPos] == '\t' ) )
+        ++m_iPos;
+}
+
+bool JsonStreamReader::scanString()
+{
+    const char* pc_data = m_strData.constData();
+    m_iTokenBegin = ++m_iPos;
+    m_bTokenHasEscapes = false;
+    while ( m_iPos < m_strData.size() )
+    {
+        if ( pc_data[m_iPos] == '\\' )
+        {
+            m_bTokenHasEscapes = true;
+            m_iPos += 2;
+        }
+        else if ( pc_data[m_iPos] == '"' )
+        {
+            m_iTokenEnd = m_iPos++;
+            return true;
+        }
+        else
+            ++m_iPos;
+    }
+    return false;
+}
+
+JsonStreamReader::TokenType JsonStreamReader::readNext()
+{
+    if ( m_eToken == Invalid || m_eToken == EndDocument )
+        return m_eToken;
+    const char* pc_data = m_strData.constData();
+    skipWhitespace();
+
+    // separators only ever precede a token
+    if ( m_iPos < m_strData.size() && pc_data[m_iPos] == ',' )
+    {
+        if ( m_vecContainers.empty() || m_eToken == StartObject || m_eToken == StartArray || m_eToken == Name )
+            return raiseError( "unexpected comma" );
+        ++m_iPos;
+        m_bExpectName = ( m_vecContainers.back() == '{' );
+        skipWhitespace();
+    }
+    if ( m_iPos >= m_strData.size() )
+    {
+        if ( !m_vecContainers.empty() || m_eToken == NoToken )
+            return raiseError( "unexpected end of document" );
+        m_eToken = EndDocument;
+        return m_eToken;
+    }
+    if ( m_vecContainers.empty() && m_eToken != NoToken )
+        return raiseError( "garbage after document" );
+
+    char c_char = pc_data[m_iPos];
+    if ( m_bExpectName && c_char != '"' && c_char != '}' )
+        return raiseError( "expected name" );
+    switch ( c_char )
+    {
+    case '{':
+    case '[':
+        m_vecContainers.push_back( c_char );
+        m_bExpectName = ( c_char == '{' );
+        m_eToken = ( c_char == '{' ) ? StartObject : StartArray;
+        ++m_iPos;
+        return m_eToken;
+    case '}':
+    case ']':
+        if ( m_vecContainers.empty() || m_vecContainers.back() != ( c_char == '}' ? '{' : '[' ) )
+            return raiseError( "unbalanced brackets" );
+        m_vecContainers.pop_back();
+        m_bExpectName = false;
+        m_eToken = ( c_char == '}' ) ? EndObject : EndArray;
+        ++m_iPos;
+        return m_eToken;
+    case '"':
+        if ( !scanString() )
+            return raiseError( "unterminated string" );
+        if ( !m_bExpectName )
+        {
+            m_eToken = String;
+            return m_eToken;
+        }
+        m_bExpectName = false;
+        skipWhitespace();
+        if ( m_iPos >= m_strData.size() || pc_data[m_iPos] != ':' )
+            return raiseError( "expected colon" );
+        ++m_iPos;
+        m_eToken = Name;
+        return m_eToken;
+    default:
+        break;
+    }
+
+    // numbers and literals
+    m_iTokenBegin = m_iPos;
+    if ( c_char == '-' || ( c_char >= '0' && c_char <= '9' ) )
+    {
+        while ( m_iPos < m_strData.size() && std::strchr( "+-.eE0123456789", pc_data[m_iPos] ) && pc_data[m_iPos] != '\0' )
+            ++m_iPos;
+        m_iTokenEnd = m_iPos;
+        m_eToken = Number;
+        return m_eToken;
+    }
+    for ( const char* pc_literal : { "true", "false", "null" } )
+    {
+        int i_length = static_cast<int>( std::strlen( pc_literal ) );
+        if ( m_strData.size() - m_iPos >= i_length && std::strncmp( pc_data + m_iPos, pc_literal, i_length ) == 0 )
+        {
+            m_iPos += i_length;
+            m_iTokenEnd = m_iPos;
+            m_eToken = ( c_char == 'n' ) ? Null : Bool;
+            return m_eToken;
+        }
+    }
+    return raiseError( QString( "unexpected character '%1'" ).arg( QChar( c_char ) ) );
+}
+
+QString JsonStreamReader::text() const
+{
+    switch ( m_eToken )
+    {
+    case Number:
+    case Bool:
+    case Null:
+        return QString::fromLatin1( m_strData.constData() + m_iTokenBegin, m_iTokenEnd - m_iTokenBegin );
+    case Name:
+    case String:
+        break;
+    default:
+        return QString();
+    }
+    const char* pc_data = m_strData.constData();
+    if ( !m_bTokenHasEscapes )
+        return QString::fromUtf8( pc_data + m_iTokenBegin, m_iTokenEnd - m_iTokenBegin );
+
+    // decode the unescaped runs in one go
+    QString str_text;
+    str_text.reserve( m_iTokenEnd - m_iTokenBegin );
+    int i_run = m_iTokenBegin;
+    for ( int i_pos = m_iTokenBegin; i_pos < m_iTokenEnd; ++i_pos )
+    {
+        if ( pc_data[i_pos] != '\\' )
+            continue;
+        str_text += QString::fromUtf8( pc_data + i_run, i_pos - i_run );
+        switch ( pc_data[++i_pos] )
+        {
+        case 'b': str_text += QChar('\b'); break;
+        case 'f': str_text += QChar('\f'); break;
+        case 'n': str_text += QChar('\n'); break;
+        case 'r': str_text += QChar('\r'); break;
+        case 't': str_text += QChar('\t'); break;
+        case 'u':
+            if ( i_pos + 4 < m_iTokenEnd )
+            {
+                // surrogate pairs are simply appended as two UTF-16 code units
+                bool b_ok = false;
+                ushort us_code = QByteArray::fromRawData( pc_data + i_pos + 1, 4 ).toUShort( &b_ok, 16 );
+                str_text += b_ok ? QChar( us_code ) : QChar( QChar::ReplacementCharacter );
+                i_pos += 4;
+            }
+            break;
+        default: // quote, backslash and slash
+            str_text += QChar( pc_data[i_pos] );
+            break;
+        }
+        i_run = i_pos + 1;
+    }
+    str_text += QString::fromUtf8( pc_data + i_run, m_iTokenEnd - i_run );
+    return str_text;
+}
+
+bool JsonStreamReader::readNextMember()
+{
+    return readNext() == Name;
+}
+
+bool JsonStreamReader::readNextElement()
+{
+    TokenType e_token = readNext();
+    return e_token != EndArray && e_token != Invalid && e_token != EndDocument;
+}
+
+QString JsonStreamReader::readString()
+{
+    if ( readNext() == String )
+        return text();
+    skipValue();
+    return QString();
+}
+
+void JsonStreamReader::skipValue()
+{
+    if ( m_eToken == Name )
+        readNext();
+    if ( m_eToken != StartObject && m_eToken != StartArray )
+        return;
+    // strings are not decoded, so skipping is a mere scan
+    size_t i_depth = m_vecContainers.size();
+    while ( m_vecContainers.size() >= i_depth )
+    {
+        TokenType e_token = readNext();
+        if ( e_token == Invalid || e_token == EndDocument )
+            return;
+    }
+}
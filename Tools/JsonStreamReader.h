@@ -0,0 +1,50 @@
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <vector>
+
+// reads a JSON document token by token, in the manner of QXmlStreamReader. No document tree is built
+// and strings are only decoded, if their text is asked for, so large values can be handed on one by one
+// (or skipped) while reading. Not thread safe
+class JsonStreamReader
+{
+public:
+    enum TokenType { NoToken, Invalid, StartObject, EndObject, StartArray, EndArray, Name, String, Number, Bool, Null, EndDocument };
+
+    explicit JsonStreamReader( QByteArray strData );
+
+    TokenType readNext();
+    TokenType tokenType() const { return m_eToken; }
+    // decoded text of a name or string, the literal for numbers and booleans
+    QString   text() const;
+
+    // reads the next name of the current object. Returns false at its end
+    bool readNextMember();
+    // reads the start of the next value of the current array. Returns false at its end
+    bool readNextElement();
+    // reads the value of the current name and returns it, if it is a string. Other values are skipped
+    QString readString();
+    // skips the value starting with the current token, or the value of the current name
+    void skipValue();
+
+    bool hasError() const { return m_eToken == Invalid; }
+    QString errorString() const { return m_strError; }
+
+protected:
+    TokenType raiseError( const QString& strError );
+    void skipWhitespace();
+    bool scanString(); // scans to the closing quote, remembering whether the string has escapes
+
+    QByteArray        m_strData;
+    int               m_iPos = 0;
+    int               m_iTokenBegin = 0, m_iTokenEnd = 0; // the text of the token, without quotes
+    bool              m_bTokenHasEscapes = false;
+    TokenType         m_eToken = NoToken;
+    std::vector<char> m_vecContainers;      // '{' or '[' for every container that is open
+    bool              m_bExpectName = false; // the next string in the current object is a name
+    QString           m_strError;
+};
+
+#endif // JSONSTREAMREADER_H
@@ -1,73 +1,179 @@
 #include "StringDistance.h"
-#include <string>
-#include <numeric>
+#include <algorithm>
+#include <cstdlib>
+#include <QVarLengthArray>
 
 StringDistance::StringDistance(QString strReference, StringDistance::CaseSensitivitiy eCaseSensitivity)
-: m_strReference( eCaseSensitivity == CaseInsensitive ? strReference.toUpper() : std::move(strReference) )
+: m_strReference( std::move(strReference) )
 , m_eCaseSensitivity(eCaseSensitivity)
+, m_iNumBlocks( std::max( (m_strReference.size()+63)/64, 1 ) )
+, m_vecLatin1Masks( 256*static_cast<size_t>(m_iNumBlocks), 0 )
+, m_vecEmptyMask( static_cast<size_t>(m_iNumBlocks), 0 )
 {
+    // precompute the pattern match masks: bit i of a character's mask is set, if the reference contains the character at position i
+    for ( int i = 0; i < m_strReference.size(); ++i )
+    {
+        QChar c_char = normalized( m_strReference.at(i) );
+        m_strReference[i] = c_char;
+        quint64 ui_bit = quint64(1) << (i%64);
+        if ( c_char.unicode() < 256 )
+            m_vecLatin1Masks[ c_char.unicode()*m_iNumBlocks + i/64 ] |= ui_bit;
+        else
+        {
+            std::vector<quint64>& vec_mask = m_mapOtherMasks[c_char.unicode()];
+            vec_mask.resize( static_cast<size_t>(m_iNumBlocks), 0 );
+            vec_mask[i/64] |= ui_bit;
+        }
+    }
 }
 
-int StringDistance::Levenshtein(const QString &strQuery) const
+QChar StringDistance::normalized( QChar cChar ) const
 {
-    switch ( m_eCaseSensitivity )
-    {
-    case CaseInsensitive: return Levenshtein( m_strReference, strQuery.toUpper() );
-    case CaseSensitive:   return Levenshtein( m_strReference, strQuery );
-    }
+    return m_eCaseSensitivity == CaseInsensitive ? cChar.toUpper() : cChar;
 }
 
-double StringDistance::NormalizedLevenshtein(const QString &strQuery) const
+const quint64* StringDistance::matchMask( QChar cChar ) const
+{
+    if ( cChar.unicode() < 256 )
+        return &m_vecLatin1Masks[ cChar.unicode()*m_iNumBlocks ];
+    auto it_mask = m_mapOtherMasks.find( cChar.unicode() );
+    if ( it_mask != m_mapOtherMasks.end() )
+        return it_mask->second.data();
+    return m_vecEmptyMask.data();
+}
+
+int StringDistance::levenshteinBitParallel( const QString& strQuery ) const
 {
-    switch ( m_eCaseSensitivity )
+    // see Hyyrö, "A Bit-Vector Algorithm for Computing Levenshtein and Damerau Edit Distances" (2003)
+    // and Myers, "A Fast Bit-Vector Algorithm for Approximate String Matching Based on Dynamic Programming" (1999)
+    int i_length = m_strReference.size();
+    if ( i_length == 0 )
+        return strQuery.size();
+
+    // vertical deltas of the current column, encoded as positive and negative bit-vectors for each block
+    quint64 arr_local_pv[2], arr_local_mv[2];
+    std::vector<quint64> vec_pv, vec_mv;
+    quint64* pui_pv = arr_local_pv;
+    quint64* pui_mv = arr_local_mv;
+    if ( m_iNumBlocks > 2 ) // only allocate for really long references
     {
-    case CaseInsensitive: return NormalizedLevenshtein( m_strReference, strQuery.toUpper() );
-    case CaseSensitive:   return NormalizedLevenshtein( m_strReference, strQuery );
+        vec_pv.resize( static_cast<size_t>(m_iNumBlocks) );
+        vec_mv.resize( static_cast<size_t>(m_iNumBlocks) );
+        pui_pv = vec_pv.data();
+        pui_mv = vec_mv.data();
+    }
+    std::fill( pui_pv, pui_pv+m_iNumBlocks, ~quint64(0) );
+    std::fill( pui_mv, pui_mv+m_iNumBlocks, quint64(0) );
+
+    const quint64 ui_last_bit = quint64(1) << ((i_length-1)%64);
+    int i_score = i_length;
+    for ( QChar c_char : strQuery )
+    {
+        const quint64* pui_eq = matchMask( normalized(c_char) );
+        int i_horizontal = 1; // for the global distance, the first row always increases by one
+        for ( int i_block = 0; i_block < m_iNumBlocks; ++i_block )
+        {
+            quint64 ui_pv = pui_pv[i_block];
+            quint64 ui_mv = pui_mv[i_block];
+            quint64 ui_eq = pui_eq[i_block];
+
+            quint64 ui_xv = ui_eq | ui_mv;
+            if ( i_horizontal < 0 )
+                ui_eq |= 1;
+            quint64 ui_xh = (((ui_eq & ui_pv) + ui_pv) ^ ui_pv) | ui_eq;
+            quint64 ui_ph = ui_mv | ~(ui_xh | ui_pv);
+            quint64 ui_mh = ui_pv & ui_xh;
+
+            quint64 ui_high_bit = (i_block+1 == m_iNumBlocks) ? ui_last_bit : (quint64(1) << 63);
+            int i_horizontal_out = (ui_ph & ui_high_bit) ? 1 : ((ui_mh & ui_high_bit) ? -1 : 0);
+
+            ui_ph <<= 1;
+            ui_mh <<= 1;
+            if ( i_horizontal < 0 )
+                ui_mh |= 1;
+            else if ( i_horizontal > 0 )
+                ui_ph |= 1;
+
+            pui_pv[i_block] = ui_mh | ~(ui_xv | ui_ph);
+            pui_mv[i_block] = ui_ph & ui_xv;
+            i_horizontal = i_horizontal_out;
+        }
+        i_score += i_horizontal;
     }
+    return i_score;
 }
 
-int StringDistance::Levenshtein( const std::string &s1, const std::string &s2 )
+int StringDistance::Levenshtein(const QString &strQuery) const
 {
-	// To change the type this function manipulates and returns, change
-	// the return type and the types of the two variables below.
-	int s1len = s1.size();
-	int s2len = s2.size();
-	
-	auto column_start = (decltype(s1len))1;
-	
-	auto column = new decltype(s1len)[s1len + 1];
-	std::iota(column + column_start, column + s1len + 1, column_start);
-	
-	for (auto x = column_start; x <= s2len; x++) {
-		column[0] = x;
-		auto last_diagonal = x - column_start;
-		for (auto y = column_start; y <= s1len; y++) {
-			auto old_diagonal = column[y];
-			auto possibilities = {
-				column[y] + 1,
-				column[y - 1] + 1,
-				last_diagonal + (s1[y - 1] == s2[x - 1]? 0 : 1)
-			};
-			column[y] = std::min(possibilities);
-			last_diagonal = old_diagonal;
-		}
-	}
-	auto result = column[s1len];
-	delete[] column;
-	return result;
+    return levenshteinBitParallel( strQuery );
 }
 
-int StringDistance::Levenshtein( const QString &s1, const QString &s2 )
+int StringDistance::LevenshteinBounded( const QString& strQuery, int iMaxDistance ) const
+{
+    int i_ref_length   = m_strReference.size();
+    int i_query_length = strQuery.size();
+    iMaxDistance = std::max( iMaxDistance, 0 );
+    // the bound can't be exceeded at all. No need to restrict the computation
+    if ( iMaxDistance >= std::max( i_ref_length, i_query_length ) )
+        return Levenshtein( strQuery );
+    // at least the difference in length has to be inserted or deleted
+    if ( std::abs( i_ref_length - i_query_length ) > iMaxDistance )
+        return iMaxDistance+1;
+
+    // banded computation (Ukkonen): only cells on the diagonals -k..k can have a distance <= k.
+    // The band of the current row is stored by diagonal, i.e. column j of row i is found at index j-i+k
+    const int i_infinity   = iMaxDistance+1;
+    const int i_band_width = 2*iMaxDistance+1;
+    QVarLengthArray<int,32> arr_band( i_band_width );
+    for ( int i_diagonal = -iMaxDistance; i_diagonal <= iMaxDistance; ++i_diagonal )
+        arr_band[i_diagonal+iMaxDistance] = ( i_diagonal >= 0 && i_diagonal <= i_query_length ) ? i_diagonal : i_infinity;
+
+    for ( int i_row = 1; i_row <= i_ref_length; ++i_row )
+    {
+        const QChar c_ref = m_strReference.at(i_row-1);
+        int i_row_minimum = i_infinity;
+        for ( int i_idx = 0; i_idx < i_band_width; ++i_idx )
+        {
+            int i_col = i_row + i_idx - iMaxDistance;
+            int i_distance;
+            if ( i_col < 0 || i_col > i_query_length )
+                i_distance = i_infinity;
+            else if ( i_col == 0 )
+                i_distance = std::min( i_row, i_infinity );
+            else
+            {
+                // substitution (same diagonal, previous row), deletion (next diagonal, previous row), insertion (previous diagonal, current row)
+                i_distance = arr_band[i_idx] + ( c_ref == normalized( strQuery.at(i_col-1) ) ? 0 : 1 );
+                if ( i_idx+1 < i_band_width )
+                    i_distance = std::min( i_distance, arr_band[i_idx+1]+1 );
+                if ( i_idx > 0 )
+                    i_distance = std::min( i_distance, arr_band[i_idx-1]+1 );
+                i_distance = std::min( i_distance, i_infinity );
+            }
+            arr_band[i_idx] = i_distance;
+            i_row_minimum = std::min( i_row_minimum, i_distance );
+        }
+        // early exit: the distance can only grow from here on
+        if ( i_row_minimum > iMaxDistance )
+            return i_infinity;
+    }
+    return arr_band[ i_query_length - i_ref_length + iMaxDistance ];
+}
+
+double StringDistance::NormalizedLevenshtein(const QString &strQuery) const
 {
-    return Levenshtein( s1.toStdString(), s2.toStdString() );
+    int i_max_length = std::max( m_strReference.size(), strQuery.size() );
+    if ( i_max_length == 0 ) // two empty strings are equal
+        return 0;
+    return static_cast<double>(Levenshtein( strQuery ))/static_cast<double>(i_max_length);
 }
 
-double StringDistance::NormalizedLevenshtein(const std::string &s1, const std::string &s2)
+int StringDistance::Levenshtein( const QString &s1, const QString &s2 )
 {
-    return static_cast<double>(Levenshtein( s1, s2 ))/static_cast<double>(std::max(s1.length(),s2.length()));
+    return StringDistance( s1, CaseSensitive ).Levenshtein( s2 );
 }
 
 double StringDistance::NormalizedLevenshtein(const QString &s1, const QString&s2)
 {
-    return NormalizedLevenshtein( s1.toStdString(), s2.toStdString() );
+    return StringDistance( s1, CaseSensitive ).NormalizedLevenshtein( s2 );
 }
@@ -2,27 +2,40 @@
 #define STRINGDISTANCE_H
 
 #include <QString>
+#include <vector>
+#include <unordered_map>
 
 class StringDistance
 {
 public:
     enum CaseSensitivitiy { CaseSensitive, CaseInsensitive };
     StringDistance( QString strReference, CaseSensitivitiy eCaseSensitivity );
-    
+
     int    Levenshtein( const QString& strQuery ) const;
     double NormalizedLevenshtein( const QString& strQuery ) const;
-    
+    // returns the Levenshtein distance if it does not exceed iMaxDistance, otherwise iMaxDistance+1 is returned
+    int    LevenshteinBounded( const QString& strQuery, int iMaxDistance ) const;
+
     // returns the number of edit operations to get from s1 to s2
-    static int Levenshtein( const std::string& s1, const std::string& s2 );
     static int Levenshtein( const QString& s1, const QString& s2 );
-    
+
     // returns Levenshtein, noramlized by the length of the longer string
-    static double NormalizedLevenshtein( const std::string &s1, const std::string &s2 );
     static double NormalizedLevenshtein( const QString &s1, const QString &s2 );
-    
+
 protected:
+    // bit-parallel computation (Myers/Hyyrö) using the precomputed match masks of the reference
+    int levenshteinBitParallel( const QString& strQuery ) const;
+    const quint64* matchMask( QChar cChar ) const;
+    QChar normalized( QChar cChar ) const;
+
     QString m_strReference;
-    bool m_eCaseSensitivity;
+    CaseSensitivitiy m_eCaseSensitivity;
+
+    // the reference is split into blocks of 64 characters, each mask contains one word per block
+    int m_iNumBlocks;
+    std::vector<quint64> m_vecLatin1Masks; // masks for the first 256 code points, stored consecutively
+    std::unordered_map<ushort,std::vector<quint64>> m_mapOtherMasks; // masks for all other code points occurring in the reference
+    std::vector<quint64> m_vecEmptyMask;
 };
 
 #endif // STRINGDISTANCE_H
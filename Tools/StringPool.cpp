@@ -0,0 +1,22 @@
+#include "StringPool.h"
+
+QString StringPool::intern( const char* pcUtf8, int iLength )
+{
+    // look up without copying the value
+    auto it_string = m_mapStrings.constFind( QByteArray::fromRawData( pcUtf8, iLength ) );
+    if ( it_string != m_mapStrings.constEnd() )
+        return *it_string;
+    QString str_value = QString::fromUtf8( pcUtf8, iLength );
+    m_mapStrings.insert( QByteArray( pcUtf8, iLength ), str_value );
+    return str_value;
+}
+
+void StringPool::clear()
+{
+    m_mapStrings.clear();
+}
+
+int StringPool::size() const
+{
+    return m_mapStrings.size();
+}
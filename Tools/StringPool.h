@@ -0,0 +1,23 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+// decodes UTF-8 values and shares the storage of equal values between all QStrings returned for them.
+// Meant for values repeating many times (e.g. artist or genre names in a result). Not thread safe
+class StringPool
+{
+public:
+    StringPool() = default;
+
+    QString intern( const char* pcUtf8, int iLength );
+    void    clear();
+    int     size() const;
+
+protected:
+    QHash<QByteArray,QString> m_mapStrings; // keyed by the encoded value, so that known values need not be decoded again
+};
+
+#endif // STRINGPOOL_H
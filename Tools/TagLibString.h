@@ -0,0 +1,17 @@
+#ifndef TAGLIBSTRING_H
+#define TAGLIBSTRING_H
+
+#include <QString>
+#include <taglib/tstring.h>
+
+// conversions between the strings of taglib and Qt, both ways through UTF-8
+inline QString T2Q( const TagLib::String& str )
+{
+    return QString::fromUtf8( str.to8Bit(true).c_str() );
+}
+inline TagLib::String Q2T( const QString& str )
+{
+    return TagLib::String( str.toUtf8().data(), TagLib::String::UTF8 );
+}
+
+#endif // TAGLIBSTRING_H
@@ -1,55 +1,51 @@
 #include "AmarokDatabaseWidget.h"
 #include <QMessageBox>
+#include <QStandardPaths>
+#include <QtConcurrent>
 #include <Tools/EmbeddedSQLConnection.h>
-#include <Tools/StringDistance.h>
+#include <algorithm>
+#include "CollectionListModel.h"
 #include "ui_AmarokDatabaseWidget.h"
 
-enum { OriginalFieldValue = Qt::UserRole, ItemOrderValue = Qt::UserRole+1, ItemArtistValue = Qt::UserRole+2, ItemYearValue = Qt::UserRole+3, ItemGenreValue = Qt::UserRole+4 };
-
-class OrderedQListWidgetItem : public QListWidgetItem
-{
-public:
-    bool operator<(const QListWidgetItem &rclOther) const override {
-        bool b_success;
-        double f_this_order = data(ItemOrderValue).toDouble( &b_success );
-        if ( b_success )
-        {
-            double f_other_order = rclOther.data(ItemOrderValue).toDouble( &b_success );
-            if ( b_success )
-            {
-                if ( f_this_order < f_other_order )
-                    return true;
-                else if ( f_this_order > f_other_order )
-                    return false;
-            }
-        }
-        return QListWidgetItem::operator<(rclOther);
-    }
-};
-
-static QString escapeQuotes(QString strInput)
-{
-    strInput.replace("\"","\\\"");
-    return strInput;
-}
+static const int s_iArtistFilterDelay = 250; // ms
 
 AmarokDatabaseWidget::AmarokDatabaseWidget(QWidget *pclParent)
 : QWidget(pclParent)
 , m_pclUI(std::make_unique<Ui::AmarokDatabaseWidget>() )
+, m_pclSnapshot( std::make_shared<CollectionSnapshot>() )
+, m_pclGenreModel( new CollectionListModel( CollectionListModel::NameWithCount, this ) )
+, m_pclArtistModel( new CollectionListModel( CollectionListModel::NameWithCount, this ) )
+, m_pclAlbumModel( new CollectionListModel( CollectionListModel::AlbumWithCountAndArtistAndYear, this ) )
+, m_pclTitleModel( new CollectionListModel( CollectionListModel::TitleWithArtistAndAlbumAndYearAndGenre, this ) )
 {
     m_pclUI->setupUi(this);
+    m_pclUI->genreList->setModel( m_pclGenreModel );
+    m_pclUI->artistList->setModel( m_pclArtistModel );
+    m_pclUI->albumList->setModel( m_pclAlbumModel );
+    m_pclUI->titleList->setModel( m_pclTitleModel );
+    
     connect( m_pclUI->genreEdit,  SIGNAL(textChanged(const QString&)), this, SLOT(orderGenres(const QString&)) );
     connect( m_pclUI->artistEdit, SIGNAL(textChanged(const QString&)), this, SLOT(orderArtists(const QString&)) );
     connect( m_pclUI->albumEdit,  SIGNAL(textChanged(const QString&)), this, SLOT(orderAlbums(const QString&)) );
     connect( m_pclUI->titleEdit,  SIGNAL(textChanged(const QString&)), this, SLOT(orderTitles(const QString&)) );
     
-    connect( m_pclUI->genreList, SIGNAL(itemDoubleClicked(QListWidgetItem*)), this, SLOT(applyGenre(QListWidgetItem*)) );
-    connect( m_pclUI->albumList, SIGNAL(itemDoubleClicked(QListWidgetItem*)), this, SLOT(applyAlbum(QListWidgetItem*)) );
-    connect( m_pclUI->artistList, SIGNAL(itemDoubleClicked(QListWidgetItem*)), this, SLOT(applyArtist(QListWidgetItem*)) );
-    connect( m_pclUI->titleList, SIGNAL(itemDoubleClicked(QListWidgetItem*)), this, SLOT(applyTitle(QListWidgetItem*)) );
+    connect( m_pclUI->genreList, SIGNAL(doubleClicked(const QModelIndex&)), this, SLOT(applyGenre(const QModelIndex&)) );
+    connect( m_pclUI->albumList, SIGNAL(doubleClicked(const QModelIndex&)), this, SLOT(applyAlbum(const QModelIndex&)) );
+    connect( m_pclUI->artistList, SIGNAL(doubleClicked(const QModelIndex&)), this, SLOT(applyArtist(const QModelIndex&)) );
+    connect( m_pclUI->titleList, SIGNAL(doubleClicked(const QModelIndex&)), this, SLOT(applyTitle(const QModelIndex&)) );
     
     connect( m_pclUI->titleArtistFilterCheck, SIGNAL(stateChanged(int)), this, SLOT(titleFilterChanged()), Qt::QueuedConnection );
     connect( m_pclUI->genreArtistFilterCheck, SIGNAL(stateChanged(int)), this, SLOT(genreFilterChanged()), Qt::QueuedConnection );
+    
+    m_clSnapshotReader.setMaxThreadCount( 1 );
+    m_clArtistFilterDelay.setSingleShot( true );
+    m_clArtistFilterDelay.setInterval( s_iArtistFilterDelay );
+    connect( &m_clArtistFilterDelay, SIGNAL(timeout()), this, SLOT(artistFilterChanged()) );
+    
+    connect( &m_clGenreEntries,  SIGNAL(finished()), this, SLOT(genresReady()) );
+    connect( &m_clArtistEntries, SIGNAL(finished()), this, SLOT(artistsReady()) );
+    connect( &m_clAlbumEntries,  SIGNAL(finished()), this, SLOT(albumsReady()) );
+    connect( &m_clTitleEntries,  SIGNAL(finished()), this, SLOT(titlesReady()) );
 }
 
 AmarokDatabaseWidget::~AmarokDatabaseWidget() = default;
@@ -86,110 +82,48 @@ void AmarokDatabaseWidget::setTitleQuery(const QString &strGenre)
     m_pclUI->titleEdit->setText(strGenre);
 }
 
-static std::unique_ptr<QListWidgetItem> entryWithCount( const std::pair<QString,int>&  rcl_entry )
+void AmarokDatabaseWidget::connectedToDB()
 {
-    auto pcl_item = std::make_unique<OrderedQListWidgetItem>();
-    pcl_item->setData( OriginalFieldValue, rcl_entry.first);
-    pcl_item->setData( ItemOrderValue, 1 );
-    pcl_item->setText( QString("%1 [%2]").arg(rcl_entry.first).arg(rcl_entry.second) );
-    return pcl_item;
+    // the lists are filled from a local snapshot of the collection, which is only rebuilt when the database has changed
+    CollectionSnapshot::update( *m_pclDB, QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + "/amarok_collection.snapshot", this,
+                                [this]( std::shared_ptr<const CollectionSnapshot> pclSnapshot ) {
+        m_pclSnapshot = std::move(pclSnapshot);
+        if ( !m_pclSnapshot->isValid() )
+            QMessageBox::critical( this, "Database Error", "failed to create snapshot of collection" );
+        fillLists();
+    } );
 }
 
-static std::unique_ptr<QListWidgetItem> entryWithCountAndArtistAndYear( const std::tuple<QString,int,QString,int>& rcl_entry )
+template<class Fun>
+void AmarokDatabaseWidget::updateEntries( QFutureWatcher<CollectionListModel::Entries>& rclWatcher, Fun funEntries )
 {
-    auto pcl_item = std::make_unique<OrderedQListWidgetItem>();
-    pcl_item->setData( OriginalFieldValue, std::get<0>(rcl_entry));
-    pcl_item->setData( ItemOrderValue, 1 );
-    pcl_item->setData( ItemArtistValue, std::get<2>(rcl_entry) );
-    pcl_item->setData( ItemYearValue, std::get<3>(rcl_entry) );
-    if ( std::get<2>(rcl_entry).isEmpty() ) //it's a compilation
-        pcl_item->setText( QString("%1 (Compilation in %3) [%2]").arg(std::get<0>(rcl_entry)).arg(std::get<1>(rcl_entry)).arg(std::get<3>(rcl_entry)) );
-    else
-        pcl_item->setText( QString("%1 (by %2 in %4) [%3]").arg(std::get<0>(rcl_entry),std::get<2>(rcl_entry)).arg(std::get<1>(rcl_entry)).arg(std::get<3>(rcl_entry)) );
-    return pcl_item;
+    // the task keeps the snapshot alive, even if a newer one is loaded in the meantime
+    std::shared_ptr<const CollectionSnapshot> pcl_snapshot = m_pclSnapshot;
+    rclWatcher.setFuture( QtConcurrent::run( &m_clSnapshotReader, [pcl_snapshot, funEntries]() {
+        return CollectionListModel::prepareEntries( funEntries( *pcl_snapshot ) );
+    } ) );
 }
 
-static std::unique_ptr<QListWidgetItem> entryWithArtistAndAlbumAndYearAndGenre( const std::tuple<QString,QString,QString,int,QString>& rcl_entry )
+void AmarokDatabaseWidget::fillLists()
 {
-    auto pcl_item = std::make_unique<OrderedQListWidgetItem>();
-    pcl_item->setData( OriginalFieldValue, std::get<0>(rcl_entry));
-    pcl_item->setData( ItemOrderValue, 1 );
-    pcl_item->setData( ItemArtistValue, std::get<1>(rcl_entry) );
-    pcl_item->setData( ItemYearValue, std::get<3>(rcl_entry) );
-    pcl_item->setData( ItemGenreValue, std::get<4>(rcl_entry) );
-    pcl_item->setText( QString("%1 [%4]\n(by %2 on %3 in %5)").arg(std::get<0>(rcl_entry),std::get<1>(rcl_entry),std::get<2>(rcl_entry),std::get<4>(rcl_entry)).arg(std::get<3>(rcl_entry)) );
-    return pcl_item;
-}
-
-void AmarokDatabaseWidget::connectedToDB()
-{
-    QSignalBlocker cl_block_genres(m_pclUI->genreList);
-    QSignalBlocker cl_block_artists(m_pclUI->artistList);
-    QSignalBlocker cl_block_albums(m_pclUI->albumList);
-    QSignalBlocker cl_block_titles(m_pclUI->titleList);
-    
     // get table entries and fill lists
-    m_pclUI->genreList->clear();
-    QStringList lst_genres;
-    for ( const auto& rcl_genre_count : getWithCount("genre") )
-    {
-        m_pclUI->genreList->addItem( entryWithCount(rcl_genre_count).release() );
-        lst_genres << rcl_genre_count.first;
-    }
-    
-    m_pclUI->artistList->clear();
-    for ( const auto& rcl_artist_count : getWithCount("artist") )
-        m_pclUI->artistList->addItem( entryWithCount(rcl_artist_count).release() );
-    
-    m_pclUI->albumList->clear();
-    for ( const auto& rcl_album_count_artist_year : getAlbumsWithCountAndArtistAndYear() )
-        m_pclUI->albumList->addItem( entryWithCountAndArtistAndYear(rcl_album_count_artist_year).release() );
-    
-    m_pclUI->titleList->clear();
-    for ( const auto& rcl_title_artist_album_year_genre : getTitlesWithArtistsAndAlbumsAndYearAndGenre() )
-        m_pclUI->titleList->addItem( entryWithArtistAndAlbumAndYearAndGenre(rcl_title_artist_album_year_genre).release() );
-    
-    emit genresChanged(lst_genres);
-}
-
-static void computeOrderForList( QListWidget& rclList, const QString &strQuery )
-{
-    if ( strQuery.isEmpty() ) //take the easy way out. no need to do heavy compuations
-    {
-        #pragma omp parallel for
-        for ( int i = 0; i < rclList.count(); ++i )
-        {
-            rclList.item(i)->setData( ItemOrderValue, 1 );
-        }
-    }
-    else
-    {
-        // iterate through all entries and compute the order based on string distance (in parallel)
-        StringDistance cl_query( strQuery, StringDistance::CaseInsensitive );
-        #pragma omp parallel for
-        for ( int i = 0; i < rclList.count(); ++i )
-        {
-            QListWidgetItem* pcl_item = rclList.item(i);
-            pcl_item->setData( ItemOrderValue, cl_query.NormalizedLevenshtein( pcl_item->data( OriginalFieldValue ).toString() ) );
-        }
-    }
+    updateEntries( m_clArtistEntries, []( const CollectionSnapshot& rclSnapshot ) { return getArtistsWithCount( rclSnapshot ); } );
+    updateEntries( m_clAlbumEntries, []( const CollectionSnapshot& rclSnapshot ) { return getAlbumsWithCountAndArtistAndYear( rclSnapshot ); } );
+    genreFilterChanged();
+    titleFilterChanged();
 }
 
-static bool selectAndShowExactMatch( QListWidget& rclList )
+static bool selectAndShowExactMatch( QListView& rclList, const CollectionListModel& rclModel )
 {
     rclList.clearSelection();
-    for ( int i = rclList.count()-1; i >= 0; --i )
-    {
-        // look for matches with distance "0" (which must be an exact match, as no more editing was required
-        QListWidgetItem* pcl_item = rclList.item(i);
-        if ( pcl_item->data( ItemOrderValue ).toDouble() == 0 )
-        {
-            pcl_item->setSelected(true);
-            rclList.scrollToItem( pcl_item );
-            return true;
-        }
-    }
-    return false;
+    // after sorting, matches with distance "0" (which must be an exact match, as no more editing was required) are on top
+    int i_num_exact = rclModel.numExactMatches();
+    if ( i_num_exact == 0 )
+        return false;
+    QModelIndex cl_index = rclModel.index( i_num_exact-1 );
+    rclList.selectionModel()->select( cl_index, QItemSelectionModel::Select );
+    rclList.scrollTo( cl_index );
+    return true;
 }
 
 void AmarokDatabaseWidget::setExactMatchIcon( QWidget* pclTab, bool bMatch )
@@ -203,147 +137,211 @@ void AmarokDatabaseWidget::setExactMatchIcon( QWidget* pclTab, bool bMatch )
 
 void AmarokDatabaseWidget::orderGenres(const QString &strGenre)
 {
-    computeOrderForList( *m_pclUI->genreList, strGenre );
-    m_pclUI->genreList->sortItems();
+    m_pclGenreModel->orderByQuery( strGenre );
     
-    bool b_exact_match = selectAndShowExactMatch( *m_pclUI->genreList );
+    bool b_exact_match = selectAndShowExactMatch( *m_pclUI->genreList, *m_pclGenreModel );
     setExactMatchIcon( m_pclUI->genreTab, b_exact_match );
 }
 
 void AmarokDatabaseWidget::orderArtists(const QString &strArtist)
 {
-    computeOrderForList( *m_pclUI->artistList, strArtist );
-    m_pclUI->artistList->sortItems();
+    m_pclArtistModel->orderByQuery( strArtist );
     
-    bool b_exact_match = selectAndShowExactMatch( *m_pclUI->artistList );
+    bool b_exact_match = selectAndShowExactMatch( *m_pclUI->artistList, *m_pclArtistModel );
     setExactMatchIcon( m_pclUI->artistTab, b_exact_match );
     
-    // could be that we need to requery
-    if ( m_pclUI->titleArtistFilterCheck->isChecked() )
-        titleFilterChanged();
-    // could be that we need to requery
-    if ( m_pclUI->genreArtistFilterCheck->isChecked() )
-        genreFilterChanged();
+    // could be that we need to filter again
+    if ( m_pclUI->titleArtistFilterCheck->isChecked() || m_pclUI->genreArtistFilterCheck->isChecked() )
+        m_clArtistFilterDelay.start();
     
     QStringList lst_closest_artists;
-    for ( int i = 0; i < std::min(3,m_pclUI->artistList->count()); ++i )
-        lst_closest_artists << m_pclUI->artistList->item(i)->data( OriginalFieldValue ).toString();
+    for ( int i = 0; i < std::min(3,m_pclArtistModel->rowCount()); ++i )
+        lst_closest_artists << m_pclArtistModel->index(i).data( CollectionListModel::OriginalFieldValue ).toString();
     emit closestArtistsChanged(lst_closest_artists);
 }
 
 void AmarokDatabaseWidget::orderAlbums(const QString &strAlbum)
 {
-    computeOrderForList( *m_pclUI->albumList, strAlbum );
-    m_pclUI->albumList->sortItems();
-    bool b_exact_match = selectAndShowExactMatch( *m_pclUI->albumList );
+    m_pclAlbumModel->orderByQuery( strAlbum );
+    bool b_exact_match = selectAndShowExactMatch( *m_pclUI->albumList, *m_pclAlbumModel );
     setExactMatchIcon( m_pclUI->albumTab, b_exact_match );
 }
 
 void AmarokDatabaseWidget::orderTitles(const QString &strTitle)
 {
-    computeOrderForList( *m_pclUI->titleList, strTitle );
-    m_pclUI->titleList->sortItems();
-    bool b_exact_match = selectAndShowExactMatch( *m_pclUI->titleList );
+    m_pclTitleModel->orderByQuery( strTitle );
+    bool b_exact_match = selectAndShowExactMatch( *m_pclUI->titleList, *m_pclTitleModel );
     setExactMatchIcon( m_pclUI->titleTab, b_exact_match );
 }
 
-void AmarokDatabaseWidget::applyGenre(QListWidgetItem* pclItem)
+void AmarokDatabaseWidget::applyGenre(const QModelIndex& rclIndex)
 {
-    emit setGenre( pclItem->data( OriginalFieldValue ).toString() );
+    emit setGenre( rclIndex.data( CollectionListModel::OriginalFieldValue ).toString() );
 }
 
-void AmarokDatabaseWidget::applyArtist(QListWidgetItem* pclItem)
+void AmarokDatabaseWidget::applyArtist(const QModelIndex& rclIndex)
 {
-    emit setTrackArtist( pclItem->data( OriginalFieldValue ).toString() );
+    emit setTrackArtist( rclIndex.data( CollectionListModel::OriginalFieldValue ).toString() );
 }
 
-void AmarokDatabaseWidget::applyTitle(QListWidgetItem *pclItem)
+void AmarokDatabaseWidget::applyTitle(const QModelIndex& rclIndex)
 {
-    emit setTitle( pclItem->data( OriginalFieldValue ).toString() );
-    emit setTrackArtist( pclItem->data( ItemArtistValue ).toString() );
-    emit setYear( pclItem->data( ItemYearValue ).toInt() );
-    emit setGenre( pclItem->data( ItemGenreValue ).toString() );
+    emit setTitle( rclIndex.data( CollectionListModel::OriginalFieldValue ).toString() );
+    emit setTrackArtist( rclIndex.data( CollectionListModel::ItemArtistValue ).toString() );
+    emit setYear( rclIndex.data( CollectionListModel::ItemYearValue ).toInt() );
+    emit setGenre( rclIndex.data( CollectionListModel::ItemGenreValue ).toString() );
 }
 
 void AmarokDatabaseWidget::titleFilterChanged()
 {
-    QSignalBlocker cl_block_titles(m_pclUI->titleList);
-    m_pclUI->titleList->clear();
-    for ( const auto& rcl_title_artist_album_year_genre : getTitlesWithArtistsAndAlbumsAndYearAndGenre(m_pclUI->artistEdit->text()) )
-        m_pclUI->titleList->addItem( entryWithArtistAndAlbumAndYearAndGenre(rcl_title_artist_album_year_genre).release() );
-    orderTitles( m_pclUI->titleEdit->text() );
+    // filtered on the snapshot in the background, the entries of a newer filter replace older ones
+    bool b_with_artist_filter = m_pclUI->titleArtistFilterCheck->isChecked();
+    QString str_artist = m_pclUI->artistEdit->text();
+    updateEntries( m_clTitleEntries, [b_with_artist_filter, str_artist]( const CollectionSnapshot& rclSnapshot ) {
+        return getTitlesWithArtistAndAlbumAndYearAndGenre( rclSnapshot, b_with_artist_filter, str_artist );
+    } );
 }
 
 void AmarokDatabaseWidget::genreFilterChanged()
 {
-    QSignalBlocker cl_block_titles(m_pclUI->genreList);
-    m_pclUI->genreList->clear();
-    for ( const auto& rcl_genre_count : getWithCount("genre",m_pclUI->artistEdit->text()) )
-        m_pclUI->genreList->addItem( entryWithCount(rcl_genre_count).release() );
+    bool b_with_artist_filter = m_pclUI->genreArtistFilterCheck->isChecked();
+    QString str_artist = m_pclUI->artistEdit->text();
+    m_bGenresFiltered = b_with_artist_filter;
+    updateEntries( m_clGenreEntries, [b_with_artist_filter, str_artist]( const CollectionSnapshot& rclSnapshot ) {
+        return getGenresWithCount( rclSnapshot, b_with_artist_filter, str_artist );
+    } );
+}
+
+void AmarokDatabaseWidget::artistFilterChanged()
+{
+    if ( m_pclUI->titleArtistFilterCheck->isChecked() )
+        titleFilterChanged();
+    if ( m_pclUI->genreArtistFilterCheck->isChecked() )
+        genreFilterChanged();
+}
+
+void AmarokDatabaseWidget::genresReady()
+{
+    // a finished signal of entries replaced meanwhile may still arrive
+    if ( !m_clGenreEntries.isFinished() || m_clGenreEntries.isCanceled() )
+        return;
+    CollectionListModel::Entries cl_entries = m_clGenreEntries.result();
+    if ( !m_bGenresFiltered )
+    {
+        QStringList lst_genres;
+        for ( const QString& str_genre : cl_entries.vecNames )
+            lst_genres << str_genre;
+        emit genresChanged(lst_genres);
+    }
+    m_pclGenreModel->setEntries( std::move(cl_entries) );
     orderGenres( m_pclUI->genreEdit->text() );
 }
 
-void AmarokDatabaseWidget::applyAlbum(QListWidgetItem* pclItem)
+void AmarokDatabaseWidget::artistsReady()
+{
+    if ( m_clArtistEntries.isFinished() && !m_clArtistEntries.isCanceled() )
+        m_pclArtistModel->setEntries( m_clArtistEntries.result() );
+}
+
+void AmarokDatabaseWidget::albumsReady()
+{
+    if ( m_clAlbumEntries.isFinished() && !m_clAlbumEntries.isCanceled() )
+        m_pclAlbumModel->setEntries( m_clAlbumEntries.result() );
+}
+
+void AmarokDatabaseWidget::titlesReady()
+{
+    if ( !m_clTitleEntries.isFinished() || m_clTitleEntries.isCanceled() )
+        return;
+    m_pclTitleModel->setEntries( m_clTitleEntries.result() );
+    orderTitles( m_pclUI->titleEdit->text() );
+}
+
+void AmarokDatabaseWidget::applyAlbum(const QModelIndex& rclIndex)
 {
-    emit setAlbum( pclItem->data( OriginalFieldValue ).toString() );
-    emit setAlbumArtist( pclItem->data( ItemArtistValue ).toString() );
-    emit setYear( pclItem->data( ItemYearValue ).toInt() );
+    emit setAlbum( rclIndex.data( CollectionListModel::OriginalFieldValue ).toString() );
+    emit setAlbumArtist( rclIndex.data( CollectionListModel::ItemArtistValue ).toString() );
+    emit setYear( rclIndex.data( CollectionListModel::ItemYearValue ).toInt() );
 }
 
-std::vector<std::pair<QString,int>> AmarokDatabaseWidget::getWithCount( const QString& strField, const QString& strArtistFilter ) const
+std::vector<std::pair<QString,int>> AmarokDatabaseWidget::getGenresWithCount( const CollectionSnapshot& rclSnapshot, bool bWithArtistFilter, const QString& strArtistFilter )
 {
-    if ( m_pclUI->genreArtistFilterCheck->isChecked() && strArtistFilter.isEmpty() )
+    if ( bWithArtistFilter && strArtistFilter.isEmpty() )
         return {};
-    if ( m_pclDB && m_pclDB->isConnected() )
+    std::vector<quint32> vec_artists = rclSnapshot.findArtists( strArtistFilter );
+    std::vector<int> vec_counts( rclSnapshot.numGenres(), 0 );
+    for ( quint32 ui_track = 0; ui_track < rclSnapshot.numTracks(); ++ui_track )
     {
-        QString str_query = "SELECT %1s.name, count(*) FROM %1s";
-        bool b_with_artist_filter = m_pclUI->genreArtistFilterCheck->isChecked() && !strArtistFilter.isEmpty();
-        if ( b_with_artist_filter )
-            str_query.append( " INNER JOIN (SELECT tracks.id as id, tracks.%1 as %1 FROM tracks INNER JOIN (SELECT id FROM artists WHERE name=\"%2\") as artists ON tracks.artist=artists.id) AS" );
-        else
-            str_query.append( " LEFT JOIN");
-        str_query.append( " tracks ON %1s.id=tracks.%1 GROUP BY %1s.id ORDER BY %1s.name" );
-        std::vector<std::vector<QString>> vec_rows = m_pclDB->query( b_with_artist_filter ? str_query.arg(strField,escapeQuotes(strArtistFilter)) : str_query.arg(strField) );
-        
-        std::vector<std::pair<QString,int>> vec_results; vec_results.reserve(vec_rows.size());
-        for ( std::vector<QString>& vec_cols : vec_rows )
-            vec_results.emplace_back( std::move(vec_cols[0]), vec_cols[1].toInt() );
-        return vec_results;
+        quint32 ui_genre = rclSnapshot.trackGenre( ui_track );
+        if ( ui_genre == CollectionSnapshot::NoEntry )
+            continue;
+        if ( bWithArtistFilter && std::find( vec_artists.begin(), vec_artists.end(), rclSnapshot.trackArtist( ui_track ) ) == vec_artists.end() )
+            continue;
+        ++vec_counts[ui_genre];
     }
-    else
-        return {};
+    std::vector<std::pair<QString,int>> vec_results;
+    for ( quint32 ui_genre = 0; ui_genre < rclSnapshot.numGenres(); ++ui_genre )
+    {
+        // with an artist filter, only genres of that artist are of interest
+        if ( !bWithArtistFilter || vec_counts[ui_genre] > 0 )
+            vec_results.emplace_back( rclSnapshot.genreName( ui_genre ), vec_counts[ui_genre] );
+    }
+    return vec_results;
 }
 
-std::vector<std::tuple<QString, int, QString, int> > AmarokDatabaseWidget::getAlbumsWithCountAndArtistAndYear() const
+std::vector<std::pair<QString,int>> AmarokDatabaseWidget::getArtistsWithCount( const CollectionSnapshot& rclSnapshot )
 {
-    if ( m_pclDB && m_pclDB->isConnected() )
+    std::vector<int> vec_counts( rclSnapshot.numArtists(), 0 );
+    for ( quint32 ui_track = 0; ui_track < rclSnapshot.numTracks(); ++ui_track )
     {
-        std::vector<std::vector<QString>> vec_rows = m_pclDB->query( "SELECT album.name, album.num_tracks, album.artist, years.name FROM ( SELECT albums.name AS name, COUNT(tracks.id) AS num_tracks, artists.name AS artist, MAX(tracks.year) AS year FROM (albums LEFT JOIN tracks ON albums.id=tracks.album) LEFT JOIN artists ON artists.id=albums.artist GROUP BY albums.id ORDER BY albums.name ) AS album LEFT JOIN years ON album.year=years.id" );
-        std::vector<std::tuple<QString,int,QString,int> > vec_results; vec_results.reserve(vec_rows.size());
-        for ( std::vector<QString>& vec_cols : vec_rows )
-            vec_results.emplace_back( std::move(vec_cols[0]), vec_cols[1].toInt(), std::move(vec_cols[2]), vec_cols[3].toInt() );
-        return vec_results;
+        quint32 ui_artist = rclSnapshot.trackArtist( ui_track );
+        if ( ui_artist != CollectionSnapshot::NoEntry )
+            ++vec_counts[ui_artist];
     }
-    else
-        return {};
+    std::vector<std::pair<QString,int>> vec_results;
+    vec_results.reserve( rclSnapshot.numArtists() );
+    for ( quint32 ui_artist = 0; ui_artist < rclSnapshot.numArtists(); ++ui_artist )
+        vec_results.emplace_back( rclSnapshot.artistName( ui_artist ), vec_counts[ui_artist] );
+    return vec_results;
 }
 
-std::vector<std::tuple<QString, QString, QString, int, QString> > AmarokDatabaseWidget::getTitlesWithArtistsAndAlbumsAndYearAndGenre( const QString& strArtistFilter ) const
+std::vector<std::tuple<QString, int, QString, int> > AmarokDatabaseWidget::getAlbumsWithCountAndArtistAndYear( const CollectionSnapshot& rclSnapshot )
 {
-    if ( m_pclUI->titleArtistFilterCheck->isChecked() && strArtistFilter.isEmpty() )
-        return {};
-    if ( m_pclDB && m_pclDB->isConnected() )
+    // number of tracks and latest year of each album
+    std::vector<std::pair<int,int>> vec_counts_and_years( rclSnapshot.numAlbums(), { 0, 0 } );
+    for ( quint32 ui_track = 0; ui_track < rclSnapshot.numTracks(); ++ui_track )
     {
-        QString str_query = "SELECT tracks.title, artists.name, albums.name, years.name, genres.name FROM ( ( (tracks LEFT JOIN (SELECT albums.id as id, albums.name as name, artists.name as artist FROM albums LEFT JOIN artists ON albums.artist=artists.id ) AS albums ON tracks.album=albums.id) LEFT JOIN artists ON tracks.artist=artists.id ) LEFT JOIN years ON tracks.year=years.id ) LEFT JOIN genres ON tracks.genre=genres.id";
-        if ( m_pclUI->titleArtistFilterCheck->isChecked() && !strArtistFilter.isEmpty() )
-            str_query.append( QString(" WHERE artists.name=\"%1\" OR albums.artist=\"%1\"").arg(escapeQuotes(strArtistFilter)) );
-        str_query.append( " ORDER BY tracks.title" );
-        std::vector<std::vector<QString>> vec_rows = m_pclDB->query( str_query );
-        std::vector<std::tuple<QString, QString, QString, int, QString>> vec_results; vec_results.reserve(vec_rows.size());
-        for ( std::vector<QString>& vec_cols : vec_rows )
-            vec_results.emplace_back( std::move(vec_cols[0]), std::move(vec_cols[1] ), std::move(vec_cols[2]), vec_cols[3].toInt(), std::move(vec_cols[4]) );
-        return vec_results;
+        quint32 ui_album = rclSnapshot.trackAlbum( ui_track );
+        if ( ui_album == CollectionSnapshot::NoEntry )
+            continue;
+        ++vec_counts_and_years[ui_album].first;
+        vec_counts_and_years[ui_album].second = std::max( vec_counts_and_years[ui_album].second, rclSnapshot.trackYear( ui_track ) );
     }
-    else
+    std::vector<std::tuple<QString,int,QString,int> > vec_results;
+    vec_results.reserve( rclSnapshot.numAlbums() );
+    for ( quint32 ui_album = 0; ui_album < rclSnapshot.numAlbums(); ++ui_album )
+        vec_results.emplace_back( rclSnapshot.albumName( ui_album ), vec_counts_and_years[ui_album].first, rclSnapshot.artistName( rclSnapshot.albumArtist( ui_album ) ), vec_counts_and_years[ui_album].second );
+    return vec_results;
+}
+
+std::vector<std::tuple<QString,QString,QString,int,QString>> AmarokDatabaseWidget::getTitlesWithArtistAndAlbumAndYearAndGenre( const CollectionSnapshot& rclSnapshot, bool bWithArtistFilter, const QString& strArtistFilter )
+{
+    if ( bWithArtistFilter && strArtistFilter.isEmpty() )
         return {};
+    // tracks of the artist or on albums of the artist
+    std::vector<quint32> vec_artists = rclSnapshot.findArtists( strArtistFilter );
+    auto isFilteredArtist = [&vec_artists]( quint32 uiArtist ) {
+        return uiArtist != CollectionSnapshot::NoEntry && std::find( vec_artists.begin(), vec_artists.end(), uiArtist ) != vec_artists.end();
+    };
+    std::vector<std::tuple<QString,QString,QString,int,QString>> vec_results;
+    for ( quint32 ui_track = 0; ui_track < rclSnapshot.numTracks(); ++ui_track )
+    {
+        quint32 ui_album = rclSnapshot.trackAlbum( ui_track );
+        if ( bWithArtistFilter && !isFilteredArtist( rclSnapshot.trackArtist( ui_track ) )
+             && ( ui_album == CollectionSnapshot::NoEntry || !isFilteredArtist( rclSnapshot.albumArtist( ui_album ) ) ) )
+            continue;
+        vec_results.emplace_back( rclSnapshot.trackTitle( ui_track ), rclSnapshot.artistName( rclSnapshot.trackArtist( ui_track ) ), rclSnapshot.albumName( ui_album ),
+                                  rclSnapshot.trackYear( ui_track ), rclSnapshot.genreName( rclSnapshot.trackGenre( ui_track ) ) );
+    }
+    return vec_results;
 }
@@ -2,14 +2,19 @@
 #define AMAROKDATABASEWIDGET_H
 
 #include <QWidget>
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <QTimer>
 #include <memory>
+#include <Tools/CollectionSnapshot.h>
+#include <Tools/EmbeddedSQLConnection.h>
+#include "CollectionListModel.h"
 
 namespace Ui {
 class AmarokDatabaseWidget;
 }
 
-class EmbeddedSQLConnection;
-class QListWidgetItem;
+class QModelIndex;
 
 class AmarokDatabaseWidget : public QWidget
 {
@@ -45,23 +50,47 @@ protected slots:
     void orderAlbums(  const QString& strAlbum );
     void orderTitles(  const QString& strTitle );
     
-    void applyGenre(QListWidgetItem* pclItem);
-    void applyAlbum(QListWidgetItem* pclItem);
-    void applyArtist(QListWidgetItem* pclItem);
-    void applyTitle(QListWidgetItem* pclItem);
+    void applyGenre(const QModelIndex& rclIndex);
+    void applyAlbum(const QModelIndex& rclIndex);
+    void applyArtist(const QModelIndex& rclIndex);
+    void applyTitle(const QModelIndex& rclIndex);
     
     void titleFilterChanged();
     void genreFilterChanged();
+    void artistFilterChanged();
+    
+    void genresReady();
+    void artistsReady();
+    void albumsReady();
+    void titlesReady();
     
 protected:
-    std::vector<std::pair<QString,int>> getWithCount( const QString& strField, const QString& strArtistFilter = QString() ) const;
-    std::vector<std::tuple<QString,int,QString,int>> getAlbumsWithCountAndArtistAndYear() const;
-    std::vector<std::tuple<QString,QString,QString,int,QString>> getTitlesWithArtistsAndAlbumsAndYearAndGenre( const QString& strArtistFilter = QString() ) const;
+    void fillLists();
+    // derives the entries from the current snapshot in the thread reading it
+    template<class Fun>
+    void updateEntries( QFutureWatcher<CollectionListModel::Entries>& rclWatcher, Fun funEntries );
+    // lists derived from the snapshot, they are empty if the artist filter is enabled without an artist
+    static std::vector<std::pair<QString,int>> getGenresWithCount( const CollectionSnapshot& rclSnapshot, bool bWithArtistFilter, const QString& strArtistFilter );
+    static std::vector<std::pair<QString,int>> getArtistsWithCount( const CollectionSnapshot& rclSnapshot );
+    static std::vector<std::tuple<QString,int,QString,int>> getAlbumsWithCountAndArtistAndYear( const CollectionSnapshot& rclSnapshot );
+    static std::vector<std::tuple<QString,QString,QString,int,QString>> getTitlesWithArtistAndAlbumAndYearAndGenre( const CollectionSnapshot& rclSnapshot, bool bWithArtistFilter, const QString& strArtistFilter );
     
     void setExactMatchIcon(QWidget *pclTab, bool bMatch);
 private:
     std::unique_ptr<Ui::AmarokDatabaseWidget> m_pclUI;
     std::shared_ptr<EmbeddedSQLConnection>    m_pclDB;
+    std::shared_ptr<const CollectionSnapshot> m_pclSnapshot;
+    QThreadPool                               m_clSnapshotReader; // a single thread, as the snapshot must not be read by several threads at once
+    QTimer                                    m_clArtistFilterDelay; // the filtered lists are only updated once typing pauses
+    QFutureWatcher<CollectionListModel::Entries> m_clGenreEntries;
+    QFutureWatcher<CollectionListModel::Entries> m_clArtistEntries;
+    QFutureWatcher<CollectionListModel::Entries> m_clAlbumEntries;
+    QFutureWatcher<CollectionListModel::Entries> m_clTitleEntries;
+    bool                                      m_bGenresFiltered{false}; // whether the latest genre entries are restricted to an artist
+    CollectionListModel* m_pclGenreModel;
+    CollectionListModel* m_pclArtistModel;
+    CollectionListModel* m_pclAlbumModel;
+    CollectionListModel* m_pclTitleModel;
 };
 
 #endif // AMAROKDATABASEWIDGET_H
@@ -0,0 +1,189 @@
+#include "CollectionListModel.h"
+#include <QStringList>
+#include <algorithm>
+#include <numeric>
+
+// number of closest entries that are ranked for a query. All other entries keep their alphabetical order behind them
+static const int s_iRankingWindowSize = 100;
+// order value of entries without a score. Normalized distances never exceed it
+static const float s_fUnrankedScore = 1.f;
+
+CollectionListModel::CollectionListModel( DisplayFormat eFormat, QObject* pclParent )
+: QAbstractListModel(pclParent)
+, m_eFormat(eFormat)
+{
+}
+
+CollectionListModel::~CollectionListModel() = default;
+
+static void buildIndex( CollectionListModel::Entries& rclEntries )
+{
+    QStringList lst_names;
+    lst_names.reserve( static_cast<int>(rclEntries.vecNames.size()) );
+    for ( const QString& str_name : rclEntries.vecNames )
+        lst_names << str_name;
+    rclEntries.clIndex.build( lst_names );
+}
+
+CollectionListModel::Entries CollectionListModel::prepareEntries( std::vector<std::pair<QString,int>> vecNamesWithCount )
+{
+    Entries cl_entries;
+    cl_entries.vecNames.reserve( vecNamesWithCount.size() );
+    cl_entries.vecCounts.reserve( vecNamesWithCount.size() );
+    for ( auto& rcl_entry : vecNamesWithCount )
+    {
+        cl_entries.vecNames.push_back( std::move(rcl_entry.first) );
+        cl_entries.vecCounts.push_back( rcl_entry.second );
+    }
+    buildIndex( cl_entries );
+    return cl_entries;
+}
+
+CollectionListModel::Entries CollectionListModel::prepareEntries( std::vector<std::tuple<QString,int,QString,int>> vecAlbumsWithCountAndArtistAndYear )
+{
+    Entries cl_entries;
+    cl_entries.vecNames.reserve( vecAlbumsWithCountAndArtistAndYear.size() );
+    cl_entries.vecCounts.reserve( vecAlbumsWithCountAndArtistAndYear.size() );
+    cl_entries.vecArtists.reserve( vecAlbumsWithCountAndArtistAndYear.size() );
+    cl_entries.vecYears.reserve( vecAlbumsWithCountAndArtistAndYear.size() );
+    for ( auto& rcl_entry : vecAlbumsWithCountAndArtistAndYear )
+    {
+        cl_entries.vecNames.push_back( std::move(std::get<0>(rcl_entry)) );
+        cl_entries.vecCounts.push_back( std::get<1>(rcl_entry) );
+        cl_entries.vecArtists.push_back( std::move(std::get<2>(rcl_entry)) );
+        cl_entries.vecYears.push_back( std::get<3>(rcl_entry) );
+    }
+    buildIndex( cl_entries );
+    return cl_entries;
+}
+
+CollectionListModel::Entries CollectionListModel::prepareEntries( std::vector<std::tuple<QString,QString,QString,int,QString>> vecTitlesWithArtistAndAlbumAndYearAndGenre )
+{
+    Entries cl_entries;
+    cl_entries.vecNames.reserve( vecTitlesWithArtistAndAlbumAndYearAndGenre.size() );
+    cl_entries.vecArtists.reserve( vecTitlesWithArtistAndAlbumAndYearAndGenre.size() );
+    cl_entries.vecAlbums.reserve( vecTitlesWithArtistAndAlbumAndYearAndGenre.size() );
+    cl_entries.vecYears.reserve( vecTitlesWithArtistAndAlbumAndYearAndGenre.size() );
+    cl_entries.vecGenres.reserve( vecTitlesWithArtistAndAlbumAndYearAndGenre.size() );
+    for ( auto& rcl_entry : vecTitlesWithArtistAndAlbumAndYearAndGenre )
+    {
+        cl_entries.vecNames.push_back( std::move(std::get<0>(rcl_entry)) );
+        cl_entries.vecArtists.push_back( std::move(std::get<1>(rcl_entry)) );
+        cl_entries.vecAlbums.push_back( std::move(std::get<2>(rcl_entry)) );
+        cl_entries.vecYears.push_back( std::get<3>(rcl_entry) );
+        cl_entries.vecGenres.push_back( std::move(std::get<4>(rcl_entry)) );
+    }
+    buildIndex( cl_entries );
+    return cl_entries;
+}
+
+void CollectionListModel::setEntries( Entries clEntries )
+{
+    beginResetModel();
+    m_vecNames   = std::move(clEntries.vecNames);
+    m_vecCounts  = std::move(clEntries.vecCounts);
+    m_vecArtists = std::move(clEntries.vecArtists);
+    m_vecAlbums  = std::move(clEntries.vecAlbums);
+    m_vecYears   = std::move(clEntries.vecYears);
+    m_vecGenres  = std::move(clEntries.vecGenres);
+    m_clIndex    = std::move(clEntries.clIndex);
+    m_vecRankedEntries.clear();
+    m_vecScores.assign( m_vecNames.size(), s_fUnrankedScore );
+    m_vecRowToEntry.resize( m_vecNames.size() );
+    std::iota( m_vecRowToEntry.begin(), m_vecRowToEntry.end(), 0 );
+    m_vecEntryToRow = m_vecRowToEntry;
+    endResetModel();
+}
+
+void CollectionListModel::clear()
+{
+    setEntries( Entries() );
+}
+
+void CollectionListModel::orderByQuery( const QString& strQuery )
+{
+    // reset the entries ranked by the previous query
+    for ( int i_entry : m_vecRankedEntries )
+        m_vecScores[i_entry] = s_fUnrankedScore;
+    m_vecRankedEntries.clear();
+
+    for ( const std::pair<int,double>& rcl_result : m_clIndex.closest( strQuery, s_iRankingWindowSize ) )
+    {
+        m_vecScores[rcl_result.first] = static_cast<float>(rcl_result.second);
+        m_vecRankedEntries.push_back( rcl_result.first );
+    }
+    sortRows();
+}
+
+void CollectionListModel::sortRows()
+{
+    emit layoutAboutToBeChanged( {}, QAbstractItemModel::VerticalSortHint );
+    QModelIndexList lst_persistent = persistentIndexList();
+    std::vector<int> vec_persistent_entries;
+    vec_persistent_entries.reserve( static_cast<size_t>(lst_persistent.size()) );
+    for ( const QModelIndex& rcl_index : lst_persistent )
+        vec_persistent_entries.push_back( m_vecRowToEntry[rcl_index.row()] );
+
+    // ties are resolved by the original (alphabetical) order of the entries
+    std::sort( m_vecRowToEntry.begin(), m_vecRowToEntry.end(), [this]( int i_lhs, int i_rhs ) {
+        return m_vecScores[i_lhs] < m_vecScores[i_rhs] || ( m_vecScores[i_lhs] == m_vecScores[i_rhs] && i_lhs < i_rhs );
+    } );
+    for ( size_t ui_row = 0; ui_row < m_vecRowToEntry.size(); ++ui_row )
+        m_vecEntryToRow[m_vecRowToEntry[ui_row]] = static_cast<int>(ui_row);
+
+    QModelIndexList lst_moved;
+    lst_moved.reserve( lst_persistent.size() );
+    for ( int i_entry : vec_persistent_entries )
+        lst_moved << index( m_vecEntryToRow[i_entry] );
+    changePersistentIndexList( lst_persistent, lst_moved );
+    emit layoutChanged( {}, QAbstractItemModel::VerticalSortHint );
+}
+
+int CollectionListModel::numExactMatches() const
+{
+    int i_num_matches = 0;
+    while ( i_num_matches < static_cast<int>(m_vecRowToEntry.size()) && m_vecScores[m_vecRowToEntry[i_num_matches]] == 0 )
+        ++i_num_matches;
+    return i_num_matches;
+}
+
+int CollectionListModel::rowCount( const QModelIndex& rclParent ) const
+{
+    return rclParent.isValid() ? 0 : static_cast<int>(m_vecRowToEntry.size());
+}
+
+QString CollectionListModel::displayText( int iEntry ) const
+{
+    switch ( m_eFormat )
+    {
+    case NameWithCount:
+        return QString("%1 [%2]").arg(m_vecNames[iEntry]).arg(m_vecCounts[iEntry]);
+    case AlbumWithCountAndArtistAndYear:
+        if ( m_vecArtists[iEntry].isEmpty() ) //it's a compilation
+            return QString("%1 (Compilation in %3) [%2]").arg(m_vecNames[iEntry]).arg(m_vecCounts[iEntry]).arg(m_vecYears[iEntry]);
+        return QString("%1 (by %2 in %4) [%3]").arg(m_vecNames[iEntry],m_vecArtists[iEntry]).arg(m_vecCounts[iEntry]).arg(m_vecYears[iEntry]);
+    case TitleWithArtistAndAlbumAndYearAndGenre:
+        return QString("%1 [%4]\n(by %2 on %3 in %5)").arg(m_vecNames[iEntry],m_vecArtists[iEntry],m_vecAlbums[iEntry],m_vecGenres[iEntry]).arg(m_vecYears[iEntry]);
+    }
+    return m_vecNames[iEntry];
+}
+
+QVariant CollectionListModel::data( const QModelIndex& rclIndex, int iRole ) const
+{
+    if ( !rclIndex.isValid() || rclIndex.row() >= static_cast<int>(m_vecRowToEntry.size()) )
+        return QVariant();
+    int i_entry = m_vecRowToEntry[rclIndex.row()];
+    auto optionalColumn = [i_entry]( const auto& vec_column ) {
+        return static_cast<size_t>(i_entry) < vec_column.size() ? QVariant( vec_column[i_entry] ) : QVariant();
+    };
+    switch ( iRole )
+    {
+    case Qt::DisplayRole:    return displayText( i_entry );
+    case OriginalFieldValue: return m_vecNames[i_entry];
+    case ItemOrderValue:     return m_vecScores[i_entry];
+    case ItemArtistValue:    return optionalColumn( m_vecArtists );
+    case ItemYearValue:      return optionalColumn( m_vecYears );
+    case ItemGenreValue:     return optionalColumn( m_vecGenres );
+    default:                 return QVariant();
+    }
+}
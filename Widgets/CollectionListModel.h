@@ -0,0 +1,68 @@
+#ifndef COLLECTIONLISTMODEL_H
+#define COLLECTIONLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <Tools/FuzzyIndex.h>
+#include <tuple>
+#include <vector>
+
+// list model over the genres, artists, albums or titles of the collection.
+// Entries are stored column-wise, the displayed text is only formatted for rows that are actually shown
+class CollectionListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Role { OriginalFieldValue = Qt::UserRole, ItemOrderValue = Qt::UserRole+1, ItemArtistValue = Qt::UserRole+2, ItemYearValue = Qt::UserRole+3, ItemGenreValue = Qt::UserRole+4 };
+    enum DisplayFormat { NameWithCount, AlbumWithCountAndArtistAndYear, TitleWithArtistAndAlbumAndYearAndGenre };
+
+    // entries in columns together with their search index. They can be prepared in any thread
+    struct Entries
+    {
+        std::vector<QString> vecNames;
+        std::vector<int>     vecCounts;
+        std::vector<QString> vecArtists;
+        std::vector<QString> vecAlbums;
+        std::vector<int>     vecYears;
+        std::vector<QString> vecGenres;
+        FuzzyIndex           clIndex;
+    };
+
+    explicit CollectionListModel( DisplayFormat eFormat, QObject* pclParent = nullptr );
+    ~CollectionListModel() override;
+
+    // entries are expected to be sorted alphabetically. This order is kept for all entries, that don't match a query
+    static Entries prepareEntries( std::vector<std::pair<QString,int>> vecNamesWithCount );
+    static Entries prepareEntries( std::vector<std::tuple<QString,int,QString,int>> vecAlbumsWithCountAndArtistAndYear );
+    static Entries prepareEntries( std::vector<std::tuple<QString,QString,QString,int,QString>> vecTitlesWithArtistAndAlbumAndYearAndGenre );
+    void setEntries( Entries clEntries );
+    void clear();
+
+    // orders the rows by string distance of the names to the query. Only the closest entries are ranked
+    void orderByQuery( const QString& strQuery );
+    // number of rows on top, that match the last query exactly
+    int numExactMatches() const;
+
+    int rowCount( const QModelIndex& rclParent = QModelIndex() ) const override;
+    QVariant data( const QModelIndex& rclIndex, int iRole = Qt::DisplayRole ) const override;
+
+protected:
+    void sortRows();
+    QString displayText( int iEntry ) const;
+
+    DisplayFormat        m_eFormat;
+    // one element per entry, columns not used by the display format stay empty
+    std::vector<QString> m_vecNames;
+    std::vector<int>     m_vecCounts;
+    std::vector<QString> m_vecArtists;
+    std::vector<QString> m_vecAlbums;
+    std::vector<int>     m_vecYears;
+    std::vector<QString> m_vecGenres;
+    std::vector<float>   m_vecScores;
+    // m_vecRowToEntry is the permutation of the entries currently shown, m_vecEntryToRow its inverse
+    std::vector<int>     m_vecRowToEntry;
+    std::vector<int>     m_vecEntryToRow;
+    std::vector<int>     m_vecRankedEntries;
+    FuzzyIndex           m_clIndex;
+};
+
+#endif // COLLECTIONLISTMODEL_H
@@ -3,28 +3,62 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QSettings>
+#include <Tools/FolderTagIndex.h>
 #include "ui_FileBrowserWidget.h"
 
 enum {
     MediaSourceDirectory = Qt::UserRole,
-    FileIsModified
+    FileIsModified,
+    SortValue
 };
 
+enum Columns { FileColumn = 0, ArtistColumn, AlbumColumn, TitleColumn, TrackColumn, LengthColumn, CoverColumn, NumColumns };
+
+// numeric columns are sorted by their values instead of their displayed text
+class FileItem : public QTreeWidgetItem
+{
+public:
+    using QTreeWidgetItem::QTreeWidgetItem;
+    bool operator<( const QTreeWidgetItem& rclOther ) const override
+    {
+        int i_column = treeWidget() ? treeWidget()->sortColumn() : FileColumn;
+        QVariant cl_value = data( i_column, SortValue ), cl_other_value = rclOther.data( i_column, SortValue );
+        if ( cl_value.isValid() && cl_other_value.isValid() )
+            return cl_value.toInt() < cl_other_value.toInt();
+        return QTreeWidgetItem::operator<( rclOther );
+    }
+};
+
+static QString fullFilePath( const QTreeWidgetItem* pclItem )
+{
+    return pclItem->data(FileColumn,MediaSourceDirectory).toString() + "/" + pclItem->text(FileColumn);
+}
+
+static void setItemFont( QTreeWidgetItem* pclItem, const QFont& rclFont )
+{
+    for ( int i_column = 0; i_column < NumColumns; ++i_column )
+        pclItem->setFont( i_column, rclFont );
+}
+
 FileBrowserWidget::FileBrowserWidget( QWidget *pclParent )
 : QWidget(pclParent)
 , m_pclUI( std::make_unique<Ui::FileBrowserWidget>() )
+, m_pclTagIndex( std::make_unique<FolderTagIndex>() )
 {
     m_pclUI->setupUi(this);
+    m_pclUI->folderFileList->sortByColumn( FileColumn, Qt::AscendingOrder );
 
     connect( m_pclUI->browseFolderButton, &QPushButton::clicked, this, &FileBrowserWidget::browseForFolder );
-    connect( m_pclUI->folderFileList, &QListWidget::currentItemChanged, this,&FileBrowserWidget::switchFile );
-    connect( m_pclUI->folderFileList, &QListWidget::itemDoubleClicked, [this](QListWidgetItem* pclItem){switchFile(pclItem,pclItem);} );    
+    connect( m_pclUI->folderFileList, &QTreeWidget::currentItemChanged, this,&FileBrowserWidget::switchFile );
+    connect( m_pclUI->folderFileList, &QTreeWidget::itemDoubleClicked, [this](QTreeWidgetItem* pclItem){switchFile(pclItem,pclItem);} );
 
     connect( m_pclUI->saveButton, &QPushButton::clicked, this, &FileBrowserWidget::saveCurrent );
     connect( m_pclUI->nextButton, &QPushButton::clicked, this, &FileBrowserWidget::selectNextFile );
     connect( m_pclUI->deleteButton, &QPushButton::clicked, this, &FileBrowserWidget::deleteCurrent );
     connect( m_pclUI->refreshButton, &QPushButton::clicked, [this]{scanFolder(getLastUsedFolder());} );
 
+    connect( m_pclTagIndex.get(), &FolderTagIndex::entryChanged, this, &FileBrowserWidget::showTags );
+
     m_pclUI->refreshButton->setEnabled(false);
     m_pclUI->saveButton->setEnabled(false);
     m_pclUI->nextButton->setEnabled(false);
@@ -33,6 +67,11 @@ FileBrowserWidget::FileBrowserWidget( QWidget *pclParent )
 
 FileBrowserWidget::~FileBrowserWidget() = default;
 
+const FolderTagIndex& FileBrowserWidget::tagIndex() const
+{
+    return *m_pclTagIndex;
+}
+
 void FileBrowserWidget::scanFolder(QString strFolder)
 {
     QDir cl_dir(strFolder);
@@ -43,27 +82,36 @@ void FileBrowserWidget::scanFolder(QString strFolder)
     m_pclUI->refreshButton->setEnabled(true);
     m_pclUI->folderFileList->blockSignals(true);
     m_pclUI->folderFileList->clear();
+    m_mapItems.clear();
 
     // list all audio files in this folder...
     QStringList lst_filters;
     lst_filters << "*.mp3" << "*.ogg" << "*.oga" << "*.flac" << "*.wma" << "*.mp4" << "*.m4a";
     QStringList lst_files = cl_dir.entryList( lst_filters, QDir::Files, QDir::Name | QDir::IgnoreCase | QDir::LocaleAware );
+    QStringList lst_full_file_paths;
+    QList<QTreeWidgetItem*> lst_items;
     for ( const QString& strFilename : lst_files )
     {
-        QListWidgetItem* pcl_item = new QListWidgetItem(strFilename);
-        pcl_item->setData(MediaSourceDirectory,strFolder);
-        pcl_item->setData(FileIsModified,false);
-        m_pclUI->folderFileList->addItem( pcl_item );
+        QTreeWidgetItem* pcl_item = new FileItem( QStringList(strFilename) );
+        pcl_item->setData(FileColumn,MediaSourceDirectory,strFolder);
+        pcl_item->setData(FileColumn,FileIsModified,false);
+        lst_items << pcl_item;
+        lst_full_file_paths << fullFilePath(pcl_item);
+        m_mapItems.insert( lst_full_file_paths.back(), pcl_item );
     }
-    m_pclUI->folderFileList->setCurrentRow(0);
+    m_pclUI->folderFileList->addTopLevelItems( lst_items );
+    m_pclUI->folderFileList->setCurrentItem( m_pclUI->folderFileList->topLevelItem(0) );
     m_pclUI->folderFileList->blockSignals(false);
 
+    // the tag columns are filled in as the files are read
+    m_pclTagIndex->scan( lst_full_file_paths );
+
     updateTotalFileCountLabel();
     
     if ( !lst_files.isEmpty() ) {
         m_pclUI->saveButton->setEnabled(false);
         m_pclUI->deleteButton->setEnabled(true);
-        fileSelected(cl_dir.absoluteFilePath(lst_files.front()));
+        fileSelected(fullFilePath(m_pclUI->folderFileList->topLevelItem(0)));
     }
     else
     {
@@ -75,6 +123,32 @@ void FileBrowserWidget::scanFolder(QString strFolder)
     emit folderChanged( strFolder );
 }
 
+void FileBrowserWidget::showTags( const QString& strFullFilePath )
+{
+    QTreeWidgetItem* pcl_item = m_mapItems.value( strFullFilePath );
+    if ( !pcl_item )
+        return;
+    const FolderTagIndex::Entry* pcl_entry = m_pclTagIndex->find( strFullFilePath );
+    if ( !pcl_entry )
+    {
+        for ( int i_column = ArtistColumn; i_column < NumColumns; ++i_column )
+        {
+            pcl_item->setText( i_column, QString() );
+            pcl_item->setData( i_column, SortValue, QVariant() );
+        }
+        return;
+    }
+    pcl_item->setText( ArtistColumn, pcl_entry->strArtist );
+    pcl_item->setText( AlbumColumn, pcl_entry->strAlbum );
+    pcl_item->setText( TitleColumn, pcl_entry->strTitle );
+    pcl_item->setText( TrackColumn, pcl_entry->iTrack > 0 ? QString::number(pcl_entry->iTrack) : QString() );
+    pcl_item->setData( TrackColumn, SortValue, pcl_entry->iTrack );
+    pcl_item->setText( LengthColumn, QString("%1:%2").arg(pcl_entry->iDurationSecs/60).arg(pcl_entry->iDurationSecs%60,2,10,QChar('0')) );
+    pcl_item->setData( LengthColumn, SortValue, pcl_entry->iDurationSecs );
+    pcl_item->setText( CoverColumn, pcl_entry->bHasCover ? "yes" : "no" );
+    pcl_item->setData( CoverColumn, SortValue, static_cast<int>(pcl_entry->bHasCover) );
+}
+
 void FileBrowserWidget::browseForFolder()
 {
     QString str_folder = QFileDialog::getExistingDirectory( this, "Select folder", getLastUsedFolder() );
@@ -87,10 +161,10 @@ void FileBrowserWidget::updateTotalFileCountLabel()
     QString str_last_used_folder = getLastUsedFolder();
     QDir cl_dir(str_last_used_folder);
     int i_num_considered_files = 0;
-    for ( int i_item = 0; i_item < m_pclUI->folderFileList->count(); ++i_item )
+    for ( int i_item = 0; i_item < m_pclUI->folderFileList->topLevelItemCount(); ++i_item )
     {
-        auto pcl_item = m_pclUI->folderFileList->item(i_item);
-        if ( pcl_item->data(MediaSourceDirectory).toString().compare( str_last_used_folder ) == 0 )
+        auto pcl_item = m_pclUI->folderFileList->topLevelItem(i_item);
+        if ( pcl_item->data(FileColumn,MediaSourceDirectory).toString().compare( str_last_used_folder ) == 0 )
             ++i_num_considered_files;
     }
     m_pclUI->folderContentLabel->setText( QString("%1 audio files.\n%2 other files (not displayed).").arg( i_num_considered_files ).arg(cl_dir.entryList( {}, QDir::Files).count()-i_num_considered_files) );
@@ -103,7 +177,7 @@ void FileBrowserWidget::deleteCurrent()
         auto pcl_item = m_pclUI->folderFileList->currentItem();
         if ( !pcl_item )
             throw std::runtime_error( "no file selected" );
-        QString str_full_file_path = pcl_item->data(MediaSourceDirectory).toString()+"/"+pcl_item->text();
+        QString str_full_file_path = fullFilePath(pcl_item);
         if ( !QFile::exists( str_full_file_path ) )
             throw std::runtime_error( "selected file \""+str_full_file_path.toStdString()+"\" does not exist (any more?)!" );
         
@@ -113,13 +187,15 @@ void FileBrowserWidget::deleteCurrent()
                 throw std::runtime_error( "unable to remove file" );
             // remember to remove the file from the list
             QSignalBlocker cl_list_sig_bloker(m_pclUI->folderFileList);
-            int i_row = m_pclUI->folderFileList->currentRow();
-            pcl_item = m_pclUI->folderFileList->takeItem(i_row);
+            int i_row = m_pclUI->folderFileList->indexOfTopLevelItem(pcl_item);
+            pcl_item = m_pclUI->folderFileList->takeTopLevelItem(i_row);
             delete pcl_item;
-            m_pclUI->folderFileList->setCurrentRow(i_row);
+            m_mapItems.remove( str_full_file_path );
+            m_pclTagIndex->remove( str_full_file_path );
+            m_pclUI->folderFileList->setCurrentItem(m_pclUI->folderFileList->topLevelItem(i_row));
             // and update the file count for the directory
             updateTotalFileCountLabel();
-            switchFile( m_pclUI->folderFileList->item(i_row), nullptr );
+            switchFile( m_pclUI->folderFileList->topLevelItem(i_row), nullptr );
         }
     }
     catch( const std::exception& rclExc )
@@ -130,7 +206,8 @@ void FileBrowserWidget::deleteCurrent()
 
 void FileBrowserWidget::selectNextFile()
 {
-    m_pclUI->folderFileList->setCurrentRow(m_pclUI->folderFileList->currentRow()+1);
+    int i_row = m_pclUI->folderFileList->indexOfTopLevelItem(m_pclUI->folderFileList->currentItem());
+    m_pclUI->folderFileList->setCurrentItem(m_pclUI->folderFileList->topLevelItem(i_row+1));
 }
 
 QString FileBrowserWidget::getLastUsedFolder() const
@@ -138,12 +215,21 @@ QString FileBrowserWidget::getLastUsedFolder() const
     return QSettings().value("filebrowser/last_used").toString();
 }
 
+QStringList FileBrowserWidget::upcomingFiles( int iMaxFiles ) const
+{
+    QStringList lst_files;
+    int i_current_row = m_pclUI->folderFileList->indexOfTopLevelItem(m_pclUI->folderFileList->currentItem());
+    for ( int i_row = i_current_row+1; i_row < m_pclUI->folderFileList->topLevelItemCount() && lst_files.size() < iMaxFiles; ++i_row )
+        lst_files << fullFilePath(m_pclUI->folderFileList->topLevelItem(i_row));
+    return lst_files;
+}
+
 void FileBrowserWidget::setLastUsedFolder( QString strFolder ) const
 {
     QSettings().setValue("filebrowser/last_used", strFolder );
 }
 
-void FileBrowserWidget::switchFile(QListWidgetItem *pclCurrent, QListWidgetItem *pclPrevious)
+void FileBrowserWidget::switchFile(QTreeWidgetItem *pclCurrent, QTreeWidgetItem *pclPrevious)
 {
     // check if previous file was modified...
     if ( pclPrevious )
@@ -151,12 +237,11 @@ void FileBrowserWidget::switchFile(QListWidgetItem *pclCurrent, QListWidgetItem
         if ( isModified(pclPrevious) )
         {
             // ask user and possibly switch back to old item ...
-            if ( QMessageBox::question( this, "unsaved modifications", QString("There are possibly unsaved modifications for file %1. Are you sure you want to discard those?").arg( pclPrevious->text() ) ) 
+            if ( QMessageBox::question( this, "unsaved modifications", QString("There are possibly unsaved modifications for file %1. Are you sure you want to discard those?").arg( pclPrevious->text(FileColumn) ) ) 
                  != QMessageBox::Yes )
             {
                 m_pclUI->folderFileList->blockSignals(true);
                 m_pclUI->folderFileList->setCurrentItem(pclPrevious);
-                m_pclUI->folderFileList->setCurrentRow(m_pclUI->folderFileList->row(pclPrevious));
                 m_pclUI->folderFileList->blockSignals(false);
                 m_pclUI->folderFileList->update();
                 return;
@@ -168,29 +253,29 @@ void FileBrowserWidget::switchFile(QListWidgetItem *pclCurrent, QListWidgetItem
     }
     if ( pclCurrent )
     {
-        emit fileSelected(pclCurrent->data(MediaSourceDirectory).toString() + "/" + pclCurrent->text());
-        m_pclUI->nextButton->setEnabled( m_pclUI->folderFileList->row(pclCurrent) < m_pclUI->folderFileList->count()-1 );
+        emit fileSelected(fullFilePath(pclCurrent));
+        m_pclUI->nextButton->setEnabled( m_pclUI->folderFileList->indexOfTopLevelItem(pclCurrent) < m_pclUI->folderFileList->topLevelItemCount()-1 );
     }
     else {
         emit noFileSelected();
     }
 }
 
-bool FileBrowserWidget::isModified(QListWidgetItem* pclItem)
+bool FileBrowserWidget::isModified(QTreeWidgetItem* pclItem)
 {
     if ( pclItem )
-        return pclItem->data(FileIsModified).toBool();
+        return pclItem->data(FileColumn,FileIsModified).toBool();
     else
         return false;
 }
 
-void FileBrowserWidget::setFileModified( QListWidgetItem* pclItem, bool bModified )
+void FileBrowserWidget::setFileModified( QTreeWidgetItem* pclItem, bool bModified )
 {
     if ( pclItem ) {
-        pclItem->setData(FileIsModified,bModified);
-        QFont cl_font = pclItem->font();
+        pclItem->setData(FileColumn,FileIsModified,bModified);
+        QFont cl_font = pclItem->font(FileColumn);
         cl_font.setBold(bModified);
-        pclItem->setFont( cl_font );
+        setItemFont( pclItem, cl_font );
     }
 }
 
@@ -205,16 +290,29 @@ void FileBrowserWidget::currentFileMoved( const QString& strNewFilename, const Q
     auto pcl_item = m_pclUI->folderFileList->currentItem();
     if ( pcl_item )
     {
-        pcl_item->setText( strNewFilename );
+        QString str_old_full_file_path = fullFilePath(pcl_item);
+        pcl_item->setText( FileColumn, strNewFilename );
         if ( !strNewFolder.isEmpty() )
-            pcl_item->setData( MediaSourceDirectory, strNewFolder );
+            pcl_item->setData( FileColumn, MediaSourceDirectory, strNewFolder );
             
+        // the tags did not change by moving the file
+        m_mapItems.remove( str_old_full_file_path );
+        m_mapItems.insert( fullFilePath(pcl_item), pcl_item );
+        m_pclTagIndex->rename( str_old_full_file_path, fullFilePath(pcl_item) );
+
         updateTotalFileCountLabel();
 
-        emit fileSelected(pcl_item->data(MediaSourceDirectory).toString() + "/" + pcl_item->text());
+        emit currentFileRenamed(fullFilePath(pcl_item));
     }
 }
 
+void FileBrowserWidget::currentFileTagsWritten()
+{
+    auto pcl_item = m_pclUI->folderFileList->currentItem();
+    if ( pcl_item )
+        m_pclTagIndex->refresh( fullFilePath(pcl_item) );
+}
+
 void FileBrowserWidget::saveCurrent()
 {
     try
@@ -222,16 +320,16 @@ void FileBrowserWidget::saveCurrent()
         auto pcl_item = m_pclUI->folderFileList->currentItem();
         if ( !pcl_item )
             throw std::runtime_error( "no file selected" );
-        QString str_full_file_path = pcl_item->data(MediaSourceDirectory).toString()+"/"+pcl_item->text();
+        QString str_full_file_path = fullFilePath(pcl_item);
         if ( !QFile::exists( str_full_file_path ) )
             throw std::runtime_error( "selected file \""+str_full_file_path.toStdString()+"\" does not exist (any more?)!" );
         
         emit saveFile( str_full_file_path );
 
         // set font to italic to indicate: item visited
-        QFont cl_font = pcl_item->font();
+        QFont cl_font = pcl_item->font(FileColumn);
         cl_font.setItalic(true);
-        pcl_item->setFont(cl_font);
+        setItemFont( pcl_item, cl_font );
     }
     catch( const std::exception& rclExc )
     {
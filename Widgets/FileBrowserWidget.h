@@ -2,13 +2,15 @@
 #define FILEBROWSERWIDGET_H
 
 #include <QWidget>
+#include <QHash>
 #include <memory>
 
 namespace Ui {
     class FileBrowserWidget;
 }
 
-class QListWidgetItem;
+class QTreeWidgetItem;
+class FolderTagIndex;
 
 class FileBrowserWidget : public QWidget
 {
@@ -19,16 +21,23 @@ public:
 
     void scanFolder(QString strFolder);
     QString getLastUsedFolder() const;
+    // full paths of the files following the current one
+    QStringList upcomingFiles( int iMaxFiles ) const;
+    // tags of the files in the current folder, as far as they have been read
+    const FolderTagIndex& tagIndex() const;
 
 signals:
     void noFileSelected();
     void fileSelected( QString );
+    // the current file was moved, its content did not change
+    void currentFileRenamed( QString );
     void folderChanged( QString );
     void saveFile(QString);
 
 public slots:
     void setFileModified(bool bModified = true);
     void currentFileMoved( const QString& strNewFilename, const QString& strNewFolder );
+    void currentFileTagsWritten(); // reads the tags of the current file into the index again
 
 protected slots:
     void browseForFolder();
@@ -36,16 +45,19 @@ protected slots:
     void deleteCurrent();
     void selectNextFile();
 
-    void switchFile(QListWidgetItem* pclCurrent, QListWidgetItem* pclPrevious);
+    void switchFile(QTreeWidgetItem* pclCurrent, QTreeWidgetItem* pclPrevious);
+    void showTags( const QString& strFullFilePath );
 
 protected:
-    void setFileModified(QListWidgetItem* pclItem, bool bModified);
+    void setFileModified(QTreeWidgetItem* pclItem, bool bModified);
     void updateTotalFileCountLabel();
     void setLastUsedFolder( QString folder ) const;
-    bool isModified(QListWidgetItem *pclItem);
+    bool isModified(QTreeWidgetItem *pclItem);
 
 private:
     std::unique_ptr<Ui::FileBrowserWidget> m_pclUI;   
+    std::unique_ptr<FolderTagIndex>        m_pclTagIndex;
+    QHash<QString,QTreeWidgetItem*>        m_mapItems; // the list items by their full file path
 };
 
 #endif
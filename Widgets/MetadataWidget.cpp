@@ -1,7 +1,7 @@
 #include "MetadataWidget.h"
 #include "ui_MetadataWidget.h"
 
-#include <QBuffer>
+#include <QPixmap>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QDate>
@@ -12,11 +12,17 @@
 #include <taglib/flacpicture.h>
 #include <taglib/flacfile.h>
 #include <taglib/mpegfile.h>
+#include <taglib/vorbisfile.h>
+#include <taglib/opusfile.h>
+#include <taglib/mp4file.h>
+#include <taglib/asffile.h>
 #include <taglib/id3v1tag.h>
 #include <taglib/id3v2tag.h>
 #include <taglib/apetag.h>
 #include <taglib/attachedpictureframe.h>
 #include <Tools/StringDistance.h>
+#include <Tools/CoverImage.h>
+#include <Tools/TagLibString.h>
 
 const QStringList MetadataWidget::s_lstStandardTags = QStringList() 
     << "TITLE" << "ALBUM" << "ARTIST" << "TRACKNUMBER" << "DATE" << "GENRE";
@@ -29,15 +35,6 @@ enum StandardTags {  TrackTitle = 0, Album = 1, TrackArtist = 2, TrackNumber = 3
 // enum to consistently address the extended tag list
 enum ExtendedTags {  AlbumArtist = 0, TotalTracks = 1, DiscNumber = 2 };
 
-static inline QString T2Q( const TagLib::String& str )
-{
-    return QString::fromUtf8( str.to8Bit(true).c_str() );
-}
-static inline TagLib::String Q2T( const QString& str )
-{
-    return TagLib::String( str.toUtf8().data(), TagLib::String::UTF8 );
-}
-
 MetadataWidget::MetadataWidget(QWidget *parent)
 : QWidget(parent)
 , m_pclUI( std::make_unique<Ui::MetadataWidget>() )
@@ -69,6 +66,7 @@ MetadataWidget::MetadataWidget(QWidget *parent)
     connect( m_pclUI->singleTrackButton, SIGNAL(clicked()), this, SLOT(setSingleTrack()) );
     
     connect( this, &MetadataWidget::metadataModified, [this]{m_bIsModified = true;} );
+    connect( &m_clCoverPreview, &QFutureWatcher<QImage>::finished, this, &MetadataWidget::showCoverPreview );
 }
 
 MetadataWidget::~MetadataWidget() = default;
@@ -201,11 +199,7 @@ void MetadataWidget::parseFile( TagLib::FLAC::File& rclFile )
     TagLib::FLAC::Picture* pcl_selected_picture = selectFrontCoverFromPictureList( lst_pictures, TagLib::FLAC::Picture::FrontCover) ;
     
     if ( pcl_selected_picture )
-    {
-        m_pclFullResCover = std::make_unique<QPixmap>();
-        m_pclFullResCover->loadFromData( QByteArray( pcl_selected_picture->data().data(), pcl_selected_picture->data().size() ) );
-        showCover();
-    }
+        setCoverFromFile( pcl_selected_picture->data() );
 }
 
 void MetadataWidget::parseFile( TagLib::MPEG::File& rclFile )
@@ -249,20 +243,121 @@ void MetadataWidget::parseFile( TagLib::MPEG::File& rclFile )
     TagLib::ID3v2::AttachedPictureFrame* pcl_selected_picture = selectFrontCoverFromPictureList( lst_pictures, TagLib::ID3v2::AttachedPictureFrame::FrontCover);
     
     if ( pcl_selected_picture )
-    {
-        m_pclFullResCover = std::make_unique<QPixmap>();
-        m_pclFullResCover->loadFromData( QByteArray( pcl_selected_picture->picture().data(), pcl_selected_picture->picture().size() ) );
-        showCover();
-    }
+        setCoverFromFile( pcl_selected_picture->picture() );
 }
 
-static TagLib::ByteVector getJPEGData(const QPixmap& rclPixmap)
+void MetadataWidget::parseXiphComment( TagLib::Ogg::XiphComment* pclTag )
 {
-    QByteArray cl_jpeg_data;
-    QBuffer cl_buffer(&cl_jpeg_data);
-    rclPixmap.save(&cl_buffer, "JPG");
-    cl_buffer.close();
-    return TagLib::ByteVector( cl_jpeg_data.data(), cl_jpeg_data.size() );
+    if (!pclTag)
+        throw std::runtime_error( "file doesn't have a tag" );
+    parseGenericTagInformation( pclTag );
+    m_pclUI->otherTagsList->addItems( parseFreeTagInformation( pclTag->properties() ) );
+    m_pclUI->tagTypesLabel->setText( "XiphComment" );
+    
+    std::list<TagLib::FLAC::Picture*> lst_pictures;
+    for ( auto pcl_pic : pclTag->pictureList() )
+        lst_pictures.emplace_back(pcl_pic);
+    TagLib::FLAC::Picture* pcl_selected_picture = selectFrontCoverFromPictureList( lst_pictures, TagLib::FLAC::Picture::FrontCover );
+    
+    if ( pcl_selected_picture )
+        setCoverFromFile( pcl_selected_picture->data() );
+}
+
+void MetadataWidget::parseFile( TagLib::Ogg::Vorbis::File& rclFile )
+{
+    parseXiphComment( rclFile.tag() );
+}
+
+void MetadataWidget::parseFile( TagLib::Ogg::Opus::File& rclFile )
+{
+    parseXiphComment( rclFile.tag() );
+}
+
+void MetadataWidget::parseFile( TagLib::MP4::File& rclFile )
+{
+    TagLib::MP4::Tag* pcl_tag = rclFile.tag();
+    if (!pcl_tag)
+        throw std::runtime_error( "file doesn't have a tag" );
+    parseGenericTagInformation( pcl_tag );
+    m_pclUI->otherTagsList->addItems( parseFreeTagInformation( pcl_tag->properties() ) );
+    m_pclUI->tagTypesLabel->setText( "MP4" );
+    
+    if ( !pcl_tag->contains("covr") )
+        return;
+    // MP4 cover art has no picture type, so take the first one
+    TagLib::MP4::CoverArtList lst_covers = pcl_tag->item("covr").toCoverArtList();
+    if ( lst_covers.size() > 1 )
+        emit error( QString("file contains %1 pictures - taking the first one").arg(lst_covers.size()) );
+    if ( !lst_covers.isEmpty() )
+        setCoverFromFile( lst_covers.front().data() );
+}
+
+void MetadataWidget::parseFile( TagLib::ASF::File& rclFile )
+{
+    TagLib::ASF::Tag* pcl_tag = rclFile.tag();
+    if (!pcl_tag)
+        throw std::runtime_error( "file doesn't have a tag" );
+    parseGenericTagInformation( pcl_tag );
+    m_pclUI->otherTagsList->addItems( parseFreeTagInformation( pcl_tag->properties() ) );
+    m_pclUI->tagTypesLabel->setText( "ASF" );
+    
+    // pictures are stored as values in the attributes, so keep them alive while selecting
+    std::vector<TagLib::ASF::Picture> vec_pictures;
+    for ( const TagLib::ASF::Attribute& rcl_attribute : pcl_tag->attribute("WM/Picture") )
+        vec_pictures.push_back( rcl_attribute.toPicture() );
+    std::list<TagLib::ASF::Picture*> lst_pictures;
+    for ( TagLib::ASF::Picture& rcl_picture : vec_pictures )
+        lst_pictures.push_back( &rcl_picture );
+    TagLib::ASF::Picture* pcl_selected_picture = selectFrontCoverFromPictureList( lst_pictures, TagLib::ASF::Picture::FrontCover );
+    
+    if ( pcl_selected_picture )
+        setCoverFromFile( pcl_selected_picture->picture() );
+}
+
+void MetadataWidget::setCoverFromFile( const TagLib::ByteVector& rclData )
+{
+    m_clCover = CoverImage( QByteArray( rclData.data(), static_cast<int>( rclData.size() ) ) );
+    m_bCoverChanged = false;
+    showCover();
+}
+
+// the cover is written as it was read or downloaded, without encoding it again
+static TagLib::ByteVector getCoverData(const CoverImage& rclCover)
+{
+    return TagLib::ByteVector( rclCover.data().constData(), static_cast<unsigned int>( rclCover.data().size() ) );
+}
+
+static TagLib::MP4::CoverArt::Format getMP4CoverFormat(const CoverImage& rclCover)
+{
+    if ( rclCover.mimeType() == "image/jpeg" )
+        return TagLib::MP4::CoverArt::JPEG;
+    if ( rclCover.mimeType() == "image/png" )
+        return TagLib::MP4::CoverArt::PNG;
+    return TagLib::MP4::CoverArt::Unknown;
+}
+
+// replaces the front cover of a FLAC file or a XiphComment, which both store FLAC pictures
+template<class PictureContainer>
+static void replaceFLACFrontCover( PictureContainer& rclContainer, const CoverImage& rclCover )
+{
+    //first clear all existing images of type "FrontCover"
+    for ( TagLib::FLAC::Picture* pcl_picture : rclContainer.pictureList() )
+        if (pcl_picture->type() == TagLib::FLAC::Picture::FrontCover )
+            rclContainer.removePicture( pcl_picture, true );
+    
+    // create new image, if any
+    if ( !rclCover.isNull() )
+    {                               
+        std::unique_ptr<TagLib::FLAC::Picture> pcl_picture = std::make_unique<TagLib::FLAC::Picture>();
+        pcl_picture->setType( TagLib::FLAC::Picture::FrontCover );
+        pcl_picture->setMimeType( Q2T(rclCover.mimeType()) );
+        QSize cl_size = rclCover.size();
+        pcl_picture->setWidth( cl_size.width() );
+        pcl_picture->setHeight( cl_size.height() );
+        pcl_picture->setData( getCoverData(rclCover) );
+        
+        rclContainer.addPicture( pcl_picture.release() );
+    }
 }
 
 bool MetadataWidget::applyTags( TagLib::FLAC::File& rclFile )
@@ -279,26 +374,8 @@ bool MetadataWidget::applyTags( TagLib::FLAC::File& rclFile )
         emit error( QString( "failed to apply the following tag(s): %1" ).arg( T2Q(map_failed.toString()) ) );
     
     // set cover image
-    if ( m_pclFullResCover )
-    {
-        //first clear all existing images of type "FrontCover"
-        for ( TagLib::FLAC::Picture* pcl_picture : rclFile.pictureList() )
-            if (pcl_picture->type() == TagLib::FLAC::Picture::FrontCover )
-                rclFile.removePicture( pcl_picture, true );
-        
-        // create new image, if any
-        if ( !m_pclFullResCover->isNull() )
-        {                               
-            std::unique_ptr<TagLib::FLAC::Picture> pcl_picture = std::make_unique<TagLib::FLAC::Picture>();
-            pcl_picture->setType( TagLib::FLAC::Picture::FrontCover );
-            pcl_picture->setMimeType( "image/jpeg" );
-            pcl_picture->setWidth( m_pclFullResCover->width() );
-            pcl_picture->setHeight( m_pclFullResCover->height() );
-            pcl_picture->setData( getJPEGData(*m_pclFullResCover) );
-            
-            rclFile.addPicture( pcl_picture.release() );
-        }
-    }
+    if ( m_bCoverChanged )
+        replaceFLACFrontCover( rclFile, m_clCover.toEmbeddable() );
     
     // finally: save the file
     return rclFile.save();
@@ -321,8 +398,8 @@ bool MetadataWidget::applyTags( TagLib::MPEG::File& rclFile )
     if ( !map_failed.isEmpty() )
         emit error( QString( "failed to apply the following tag(s): %1" ).arg( T2Q(map_failed.toString()) ) );
     
-    // set cover image
-    if ( m_pclFullResCover )
+    // set cover image. Stripping all tags removed the cover from the file as well
+    if ( m_bCoverChanged || m_pclUI->clearOtherTagsCheck->isChecked() )
     {
         //first clear all existing images of type "FrontCover"
         bool b_found_front_cover_in_last_run;
@@ -341,12 +418,13 @@ bool MetadataWidget::applyTags( TagLib::MPEG::File& rclFile )
         } while ( b_found_front_cover_in_last_run );
         
         // create new image, if any
-        if ( !m_pclFullResCover->isNull() )
+        CoverImage cl_cover = m_clCover.toEmbeddable();
+        if ( !cl_cover.isNull() )
         {                                   
             std::unique_ptr<TagLib::ID3v2::AttachedPictureFrame> pcl_picture = std::make_unique<TagLib::ID3v2::AttachedPictureFrame>();
             pcl_picture->setType( TagLib::ID3v2::AttachedPictureFrame::FrontCover );
-            pcl_picture->setMimeType( "image/jpeg" );
-            pcl_picture->setPicture( getJPEGData(*m_pclFullResCover) );
+            pcl_picture->setMimeType( Q2T(cl_cover.mimeType()) );
+            pcl_picture->setPicture( getCoverData(cl_cover) );
             
             rclFile.ID3v2Tag()->addFrame( pcl_picture.release() );
         }
@@ -356,6 +434,82 @@ bool MetadataWidget::applyTags( TagLib::MPEG::File& rclFile )
     return rclFile.save( TagLib::MPEG::File::ID3v2, true );
 }
 
+// the formats below have a single tag type: clearing the other tags is done by the property map
+void MetadataWidget::applyXiphComment( TagLib::Ogg::XiphComment* pclTag )
+{
+    TagLib::PropertyMap map_failed = pclTag->setProperties( setMetadataInPropertyMap( pclTag->properties() ) );
+    if ( !map_failed.isEmpty() )
+        emit error( QString( "failed to apply the following tag(s): %1" ).arg( T2Q(map_failed.toString()) ) );
+    
+    if ( m_bCoverChanged )
+        replaceFLACFrontCover( *pclTag, m_clCover.toEmbeddable() );
+}
+
+bool MetadataWidget::applyTags( TagLib::Ogg::Vorbis::File& rclFile )
+{
+    applyXiphComment( rclFile.tag() );
+    return rclFile.save();
+}
+
+bool MetadataWidget::applyTags( TagLib::Ogg::Opus::File& rclFile )
+{
+    applyXiphComment( rclFile.tag() );
+    return rclFile.save();
+}
+
+bool MetadataWidget::applyTags( TagLib::MP4::File& rclFile )
+{
+    TagLib::MP4::Tag* pcl_tag = rclFile.tag();
+    TagLib::PropertyMap map_failed = pcl_tag->setProperties( setMetadataInPropertyMap( pcl_tag->properties() ) );
+    if ( !map_failed.isEmpty() )
+        emit error( QString( "failed to apply the following tag(s): %1" ).arg( T2Q(map_failed.toString()) ) );
+    
+    // set cover image. MP4 cover art has no picture type, so all of it is replaced
+    if ( m_bCoverChanged )
+    {
+        pcl_tag->removeItem( "covr" );
+        CoverImage cl_cover = m_clCover.toEmbeddable();
+        if ( !cl_cover.isNull() )
+        {
+            TagLib::MP4::CoverArtList lst_covers;
+            lst_covers.append( TagLib::MP4::CoverArt( getMP4CoverFormat(cl_cover), getCoverData(cl_cover) ) );
+            pcl_tag->setItem( "covr", lst_covers );
+        }
+    }
+    return rclFile.save();
+}
+
+bool MetadataWidget::applyTags( TagLib::ASF::File& rclFile )
+{
+    TagLib::ASF::Tag* pcl_tag = rclFile.tag();
+    TagLib::PropertyMap map_failed = pcl_tag->setProperties( setMetadataInPropertyMap( pcl_tag->properties() ) );
+    if ( !map_failed.isEmpty() )
+        emit error( QString( "failed to apply the following tag(s): %1" ).arg( T2Q(map_failed.toString()) ) );
+    
+    // set cover image, keeping all pictures not of type "FrontCover"
+    if ( m_bCoverChanged )
+    {
+        TagLib::ASF::AttributeList lst_pictures;
+        for ( const TagLib::ASF::Attribute& rcl_attribute : pcl_tag->attribute("WM/Picture") )
+            if ( rcl_attribute.toPicture().type() != TagLib::ASF::Picture::FrontCover )
+                lst_pictures.append( rcl_attribute );
+        CoverImage cl_cover = m_clCover.toEmbeddable();
+        if ( !cl_cover.isNull() )
+        {
+            TagLib::ASF::Picture cl_picture;
+            cl_picture.setType( TagLib::ASF::Picture::FrontCover );
+            cl_picture.setMimeType( Q2T(cl_cover.mimeType()) );
+            cl_picture.setPicture( getCoverData(cl_cover) );
+            lst_pictures.append( TagLib::ASF::Attribute( cl_picture ) );
+        }
+        if ( lst_pictures.isEmpty() )
+            pcl_tag->removeItem( "WM/Picture" );
+        else
+            pcl_tag->setAttribute( "WM/Picture", lst_pictures );
+    }
+    return rclFile.save();
+}
+
 template<class FileClass>
 bool MetadataWidget::tryOpenAndParse( const QString& strFilename )
 {
@@ -375,13 +529,31 @@ bool MetadataWidget::tryOpenAndSave( const QString& strFilename )
     if ( cl_file.isValid() )
     {
         bool b_save_succeeded = applyTags(cl_file);
+        // the form shows what was written already. Only update the free tags from the file in memory,
+        // there is no need to open it again or to decode the cover
+        auto lst_blockers = blockAllFormSignals();
         m_pclUI->otherTagsList->clear();
-        parseFile(cl_file); // read the data to update interface
+        m_pclUI->otherTagsList->addItems( parseFreeTagInformation( cl_file.properties() ) );
         return b_save_succeeded;
     }
     return false;
 }
 
+const std::map<AudioFileFormat,MetadataWidget::FormatHandler> MetadataWidget::s_mapFormatHandlers = {
+    { AudioFileFormat::FLAC,      { &MetadataWidget::tryOpenAndParse<TagLib::FLAC::File>,        &MetadataWidget::tryOpenAndSave<TagLib::FLAC::File>,        "XiphComment" } },
+    { AudioFileFormat::MPEG,      { &MetadataWidget::tryOpenAndParse<TagLib::MPEG::File>,        &MetadataWidget::tryOpenAndSave<TagLib::MPEG::File>,        "ID3v2" } },
+    { AudioFileFormat::OggVorbis, { &MetadataWidget::tryOpenAndParse<TagLib::Ogg::Vorbis::File>, &MetadataWidget::tryOpenAndSave<TagLib::Ogg::Vorbis::File>, "XiphComment" } },
+    { AudioFileFormat::OggOpus,   { &MetadataWidget::tryOpenAndParse<TagLib::Ogg::Opus::File>,   &MetadataWidget::tryOpenAndSave<TagLib::Ogg::Opus::File>,   "XiphComment" } },
+    { AudioFileFormat::MP4,       { &MetadataWidget::tryOpenAndParse<TagLib::MP4::File>,         &MetadataWidget::tryOpenAndSave<TagLib::MP4::File>,         "MP4" } },
+    { AudioFileFormat::ASF,       { &MetadataWidget::tryOpenAndParse<TagLib::ASF::File>,         &MetadataWidget::tryOpenAndSave<TagLib::ASF::File>,         "ASF" } }
+};
+
+const MetadataWidget::FormatHandler* MetadataWidget::findFormatHandler( const QString& strFilename )
+{
+    auto it_handler = s_mapFormatHandlers.find( sniffAudioFileFormat( strFilename ) );
+    return ( it_handler != s_mapFormatHandlers.end() ) ? &it_handler->second : nullptr;
+}
+
 void MetadataWidget::loadFromFile(const QString& strFilename)
 {
     m_bIsModified = false;
@@ -390,9 +562,11 @@ void MetadataWidget::loadFromFile(const QString& strFilename)
     try
     {
         // figure out the type of file
-        if ( !tryOpenAndParse<TagLib::FLAC::File>(strFilename) )
-        if ( !tryOpenAndParse<TagLib::MPEG::File>(strFilename) )
-            throw std::runtime_error( "failed to open or unknown file format" );
+        const FormatHandler* pcl_handler = findFormatHandler( strFilename );
+        if ( !pcl_handler )
+            throw std::runtime_error( "unknown file format" );
+        if ( !(this->*pcl_handler->funOpenAndParse)( strFilename ) )
+            throw std::runtime_error( "failed to open file" );
         
         emit trackArtistChanged( m_pclUI->trackArtistEdit->text() );
         emit albumArtistChanged( m_pclUI->albumArtistEdit->text() );
@@ -416,7 +590,7 @@ static QStringList checkClosestArtists( const QString& strCheckArtist, const QSt
     {
         StringDistance cl_dist( strCheckArtist, StringDistance::CaseInsensitive );
         for ( const QString& strArtist : lstClosestArtists )
-            if ( cl_dist.Levenshtein( strArtist ) <= 3 )
+            if ( cl_dist.LevenshteinBounded( strArtist, 3 ) <= 3 )
                 lst_close_matches << strArtist;
     }
     return lst_close_matches;
@@ -470,9 +644,13 @@ bool MetadataWidget::saveToFile(const QString &strFilename)
     try
     {
         // figure out the type of file
-        if ( !tryOpenAndSave<TagLib::FLAC::File>(strFilename) )
-        if ( !tryOpenAndSave<TagLib::MPEG::File>(strFilename) )
-            throw std::runtime_error( "failed to open or unknown file format" );
+        const FormatHandler* pcl_handler = findFormatHandler( strFilename );
+        if ( !pcl_handler )
+            throw std::runtime_error( "unknown file format" );
+        if ( !(this->*pcl_handler->funOpenAndSave)( strFilename ) )
+            throw std::runtime_error( "failed to open or save file" );
+        m_pclUI->tagTypesLabel->setText( pcl_handler->pcSavedTagType );
+        m_bCoverChanged = false;
         m_bIsModified = false;
     }
     catch ( const std::exception& rclExc )
@@ -495,12 +673,14 @@ void MetadataWidget::clear()
     m_pclUI->cdEdit->clear();
     m_pclUI->totalTracksSpin->clear();
     m_pclUI->otherTagsList->clear();
+    m_clCoverPreview.setFuture( QFuture<QImage>() );
     m_pclUI->coverLabel->clear();
     m_pclUI->coverInfoLabel->clear();
     setGenre("");
     m_pclUI->clearCoverButton->setEnabled(false);
     m_pclUI->clearOtherTagsCheck->setEnabled(false);
-    m_pclFullResCover = nullptr;
+    m_clCover = CoverImage();
+    m_bCoverChanged = false;
     m_bIsModified = false;
 }
 
@@ -524,23 +704,35 @@ void MetadataWidget::setGenre( const QString& strGenre )
 
 void MetadataWidget::showCover()
 {
-    if ( m_pclFullResCover && !m_pclFullResCover->isNull() )
+    if ( !m_clCover.isNull() )
     {
-        m_pclUI->coverLabel->setPixmap( m_pclFullResCover->scaled(m_pclUI->coverLabel->maximumSize(),Qt::KeepAspectRatio, Qt::SmoothTransformation) );
-        m_pclUI->coverInfoLabel->setText( QString("%1x%2").arg(m_pclFullResCover->size().width()).arg(m_pclFullResCover->size().height()) );
+        // the size is read from the image header, the preview follows once decoded
+        m_pclUI->coverLabel->clear();
+        m_clCoverPreview.setFuture( m_clCover.decodePreview( m_pclUI->coverLabel->maximumSize() ) );
+        QSize cl_size = m_clCover.size();
+        m_pclUI->coverInfoLabel->setText( QString("%1x%2").arg(cl_size.width()).arg(cl_size.height()) );
         m_pclUI->clearCoverButton->setEnabled( true );
     }
     else
     {
+        m_clCoverPreview.setFuture( QFuture<QImage>() ); // drop a preview still being decoded
         m_pclUI->coverLabel->clear();
         m_pclUI->coverInfoLabel->clear();
         m_pclUI->clearCoverButton->setDisabled( true );
     }
 }
 
-void MetadataWidget::setCover(const QPixmap & rclPixmap)
+void MetadataWidget::showCoverPreview()
 {
-    m_pclFullResCover = std::make_unique<QPixmap>(rclPixmap);
+    // a finished signal of a preview replaced meanwhile may still arrive
+    if ( m_clCoverPreview.isFinished() && !m_clCoverPreview.isCanceled() )
+        m_pclUI->coverLabel->setPixmap( QPixmap::fromImage( m_clCoverPreview.result() ) );
+}
+
+void MetadataWidget::setCover(const CoverImage & rclCover)
+{
+    m_clCover = rclCover;
+    m_bCoverChanged = true;
     showCover();
     emit metadataModified();
 }
@@ -583,7 +775,7 @@ void MetadataWidget::clearOtherTags()
 
 void MetadataWidget::clearCover()
 {
-    setCover(QPixmap());
+    setCover(CoverImage());
 }
 
 void MetadataWidget::loadCover()
@@ -591,9 +783,13 @@ void MetadataWidget::loadCover()
     QString str_cover_file = QFileDialog::getOpenFileName( this, "Load cover from file" );
     if ( str_cover_file.isNull() )
         return;
-    QPixmap cl_pixmap;
-    cl_pixmap.load( str_cover_file );
-    setCover( cl_pixmap );
+    CoverImage cl_cover = CoverImage::fromFile( str_cover_file );
+    if ( cl_cover.isNull() )
+    {
+        emit error( QString("failed to load cover from %1: unknown image format").arg(str_cover_file) );
+        return;
+    }
+    setCover( cl_cover );
 }
 
 void MetadataWidget::setSingleTrack()
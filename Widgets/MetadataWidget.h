@@ -2,9 +2,13 @@
 #define METADATAWIDGET_H
 
 #include <QWidget>
+#include <QFutureWatcher>
 #include <memory>
 #include <QStringList>
 #include <QUrl>
+#include <map>
+#include <Tools/AudioFileFormat.h>
+#include <Tools/CoverImage.h>
 
 namespace Ui {
 class MetadataWidget;
@@ -15,6 +19,10 @@ class Tag;
 class PropertyMap;
 namespace FLAC { class File; }
 namespace MPEG { class File; }
+namespace MP4 { class File; }
+namespace ASF { class File; }
+namespace Ogg { class XiphComment; namespace Vorbis { class File; } namespace Opus { class File; } }
+class ByteVector;
 }
 
 class MetadataWidget : public QWidget
@@ -38,7 +46,7 @@ public slots:
     void setTrackArtist( const QString& );
     void setAlbumArtist( const QString& );
     void setGenre( const QString& );
-    void setCover( const QPixmap& );
+    void setCover( const CoverImage& );
     void setYear( int );
     void setAlbum( const QString& );
     void setTrackTitle( const QString& );
@@ -67,6 +75,7 @@ protected slots:
     void loadCover();
     void setSingleTrack();
     void googleCover();
+    void showCoverPreview();
     
 protected:
     void showCover();
@@ -82,12 +91,31 @@ protected:
     void parseGenericTagInformation( TagLib::Tag* pclTag );
     void parseFile( TagLib::FLAC::File& rclFile );
     void parseFile( TagLib::MPEG::File& rclFile );
+    void parseFile( TagLib::Ogg::Vorbis::File& rclFile );
+    void parseFile( TagLib::Ogg::Opus::File& rclFile );
+    void parseFile( TagLib::MP4::File& rclFile );
+    void parseFile( TagLib::ASF::File& rclFile );
+    void parseXiphComment( TagLib::Ogg::XiphComment* pclTag );
+    void setCoverFromFile( const TagLib::ByteVector& rclData );
     bool applyTags( TagLib::FLAC::File& rclFile );
     bool applyTags( TagLib::MPEG::File& rclFile );
+    bool applyTags( TagLib::Ogg::Vorbis::File& rclFile );
+    bool applyTags( TagLib::Ogg::Opus::File& rclFile );
+    bool applyTags( TagLib::MP4::File& rclFile );
+    bool applyTags( TagLib::ASF::File& rclFile );
+    void applyXiphComment( TagLib::Ogg::XiphComment* pclTag );
     template<class FileClass>
     bool tryOpenAndParse( const QString& strFilename );
     template<class FileClass>
     bool tryOpenAndSave( const QString& strFilename );
+    // the taglib file class to open a file of the sniffed format with
+    struct FormatHandler
+    {
+        bool (MetadataWidget::*funOpenAndParse)( const QString& );
+        bool (MetadataWidget::*funOpenAndSave)( const QString& );
+        const char* pcSavedTagType; // saving strips all other tag types
+    };
+    static const FormatHandler* findFormatHandler( const QString& strFilename );
     template<class SetterFun>
     bool setFreeTag( const QString& strTagQuery, const QString& strTag, const QStringList& lstEntries, SetterFun funSetTag );
 
@@ -95,8 +123,11 @@ protected:
     PictureType* selectFrontCoverFromPictureList( const std::list<PictureType*>& lstPictures, EnumType FrontCoverValue );
 private:
     static const QStringList s_lstStandardTags, s_lstExtendedTags; // the taglib "standard" tags and the list of also used extended tags
+    static const std::map<AudioFileFormat,FormatHandler> s_mapFormatHandlers;
     
-    std::unique_ptr<class QPixmap> m_pclFullResCover; // store the full resolution cover here
+    CoverImage m_clCover; // encoded, as read from the file or as set
+    bool m_bCoverChanged{false}; // only a changed cover is written to the file
+    QFutureWatcher<QImage> m_clCoverPreview; // decoded in the background
     std::unique_ptr<Ui::MetadataWidget> m_pclUI;
     QString m_strFilename;
     QStringList m_lstClosestArtists;
@@ -1,9 +1,10 @@
 #include "OnlineSourcesWidget.h"
-#include <omp.h>
 #include <QNetworkAccessManager>
 #include <QUrl>
 #include <QMessageBox>
 #include <QCheckBox>
+#include <QPixmap>
+#include <QtConcurrent>
 #include <future>
 #include <Tools/CoverDownloader.h>
 #include <OnlineParsers/OnlineInfoSources.h>
@@ -40,6 +41,7 @@ OnlineSourcesWidget::OnlineSourcesWidget(QWidget *pclParent)
     connect( m_pclUI->trackList, SIGNAL(itemChanged(QListWidgetItem*)), this, SLOT(setTrackArtistForTrack(QListWidgetItem*)) );
     connect( m_pclCoverDownloader.get(), SIGNAL(imageReady()), this, SLOT(setCoverImageFromDownloader()), Qt::QueuedConnection );
     connect( m_pclCoverDownloader.get(), SIGNAL(error(QString)), this, SLOT(coverDownloadError(QString)), Qt::QueuedConnection );
+    connect( &m_clCoverPreview, &QFutureWatcher<QImage>::finished, this, &OnlineSourcesWidget::showCoverPreview );
     connect( m_pclUI->checkButton, SIGNAL(clicked()), this, SLOT(check()));
     m_pclUI->checkButton->setEnabled(false);
 }
@@ -173,11 +175,21 @@ void OnlineSourcesWidget::coverDownloadError(QString strError)
 
 void OnlineSourcesWidget::setCoverImageFromDownloader()
 {
-    m_pclUI->coverLabel->setPixmap( m_pclCoverDownloader->getImage().scaled(m_pclUI->coverLabel->maximumSize(),Qt::KeepAspectRatio, Qt::SmoothTransformation) );
-    m_pclUI->coverInfoLabel->setText( QString("%1x%2").arg(m_pclCoverDownloader->getImage().size().width()).arg(m_pclCoverDownloader->getImage().size().height()) );
+    const CoverImage& rcl_cover = m_pclCoverDownloader->getImage();
+    m_pclUI->coverLabel->clear();
+    m_clCoverPreview.setFuture( rcl_cover.decodePreview( m_pclUI->coverLabel->maximumSize() ) );
+    QSize cl_size = rcl_cover.size();
+    m_pclUI->coverInfoLabel->setText( QString("%1x%2").arg(cl_size.width()).arg(cl_size.height()) );
     m_pclUI->applyCoverButton->setEnabled( true );
 }
 
+void OnlineSourcesWidget::showCoverPreview()
+{
+    // skip the result of a download replaced while decoding
+    if ( m_clCoverPreview.isFinished() && !m_clCoverPreview.isCanceled() )
+        m_pclUI->coverLabel->setPixmap( QPixmap::fromImage( m_clCoverPreview.result() ) );
+}
+
 void OnlineSourcesWidget::applyTrackArtist()
 {
     emit setTrackArtist( m_pclUI->trackArtistEdit->text() );
@@ -386,29 +398,34 @@ void OnlineSourcesWidget::fillAlbumInfos(std::shared_ptr<OnlineAlbumInfoSource>
 static std::pair<int,int> getClosestDistanceEntry( const QString& strNeedle, const QStringList& lstHaystack )
 {
     StringDistance cl_query(strNeedle, StringDistance::CaseInsensitive);
-    std::vector<std::pair<int,int>> vec_closest_distances(omp_get_max_threads(), {std::numeric_limits<int>::max(),-1} );
-    #pragma omp parallel
+    std::pair<int,int> cl_closest_distance{std::numeric_limits<int>::max(),-1};
+    for ( int j = 0; j < lstHaystack.size() && cl_closest_distance.first > 0; ++j )
     {
-        std::pair<int,int>& cl_closest_distance = vec_closest_distances.at(omp_get_thread_num());
-        #pragma omp for
-        for ( int j = 0; j < lstHaystack.size(); ++j )
-        {
-            int i_edit_distance = cl_query.Levenshtein( lstHaystack.at(j) );
-            if ( i_edit_distance < cl_closest_distance.first )
-                cl_closest_distance = {i_edit_distance,j};
-        }
+        // only distances below the current best are of interest
+        int i_edit_distance = cl_query.LevenshteinBounded( lstHaystack.at(j), cl_closest_distance.first-1 );
+        if ( i_edit_distance < cl_closest_distance.first )
+            cl_closest_distance = {i_edit_distance,j};
     }
-    // join parallel results
-    return *std::min_element( vec_closest_distances.begin(), vec_closest_distances.end() );
+    return cl_closest_distance;
 }
 
 void OnlineSourcesWidget::spellCorrectGenres()
 {
+    // find the closest known genres in parallel on plain strings, the list items are only touched afterwards
+    struct GenreCorrection { QString strGenre; int iClosestDistance; int iBestIndex; };
+    std::vector<GenreCorrection> vec_corrections;
+    vec_corrections.reserve( static_cast<size_t>(m_pclUI->genreList->count()) );
+    for ( int i = 0; i < m_pclUI->genreList->count(); ++i )
+        vec_corrections.push_back( { m_pclUI->genreList->item(i)->text(), -1, -1 } );
+    const QStringList lst_known_genres = m_lstGenres;
+    QtConcurrent::blockingMap( vec_corrections, [&lst_known_genres]( GenreCorrection& rcl_correction ) {
+        std::tie(rcl_correction.iClosestDistance,rcl_correction.iBestIndex) = getClosestDistanceEntry( rcl_correction.strGenre, lst_known_genres );
+    } );
+    
     for ( int i = 0; i < m_pclUI->genreList->count(); ++i )
     {
         QListWidgetItem* pcl_item = m_pclUI->genreList->item(i);
-        int i_best_index, i_closest_distance;
-        std::tie(i_closest_distance,i_best_index) = getClosestDistanceEntry(pcl_item->text(),m_lstGenres);
+        int i_best_index = vec_corrections[i].iBestIndex, i_closest_distance = vec_corrections[i].iClosestDistance;
         if ( i_closest_distance == 0 ) // just go ahead and replace item's text with the one in the genre, it only differs in capitalization
             pcl_item->setText( m_lstGenres.at(i_best_index) );
         else if ( i_closest_distance > 0 )
@@ -433,6 +450,7 @@ void OnlineSourcesWidget::clearFields()
     clearAndDisable( m_pclUI->yearEdit,        m_pclUI->applyYearButton );
     clearAndDisable( m_pclUI->albumList,       m_pclUI->applyAlbumButton );
     clearAndDisable( m_pclUI->trackList,       m_pclUI->applyTrackButton );
+    m_clCoverPreview.setFuture( QFuture<QImage>() );
     m_pclUI->coverLabel->clear();
     m_pclUI->coverInfoLabel->clear();
     m_pclCoverDownloader->clear();
@@ -450,7 +468,7 @@ int OnlineSourcesWidget::highlightMatchingTitles()
         QListWidgetItem* pcl_item = m_pclUI->trackList->item(i);
         pcl_item->setFont(cl_font);
         QString str_track_title = pcl_item->data( TrackTitle ).toString();
-        if ( OnlineAlbumInfoSource::matchTrackTitlesConsideringBrackets( str_track_title, m_strTrackTitle ) < 3 )
+        if ( OnlineAlbumInfoSource::matchTrackTitlesConsideringBrackets( str_track_title, m_strTrackTitle, 2 ) < 3 )
         {
             int i_length_difference = ( m_iTrackLength > 0 ) ? std::abs(pcl_item->data( TrackLength ).toInt() - m_iTrackLength) : 0;
             if ( i_length_difference < 10 )
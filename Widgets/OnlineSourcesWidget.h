@@ -2,8 +2,10 @@
 #define ONLINESOURCESWIDGET_H
 
 #include <QWidget>
+#include <QFutureWatcher>
 #include <memory>
 #include <QUrl>
+#include <Tools/CoverImage.h>
 
 namespace Ui {
     class OnlineSourcesWidget;
@@ -37,7 +39,7 @@ signals:
     void setTrackArtist( const QString& );
     void setAlbumArtist( const QString& );
     void setGenre( const QString& );
-    void setCover( const QPixmap& );
+    void setCover( const CoverImage& );
     void setYear( int );
     void setAlbum( const QString& );
     void setDiscNumber( const QString& );
@@ -50,6 +52,7 @@ signals:
 protected slots:
     void coverDownloadError(QString);
     void setCoverImageFromDownloader();
+    void showCoverPreview();
     void setTrackArtistForTrack(class QListWidgetItem* pclItem);
     
     void addParsingResults(QStringList lstNewPages);
@@ -82,6 +85,7 @@ private:
     std::unique_ptr<Ui::OnlineSourcesWidget>              m_pclUI;
     std::unique_ptr<class QNetworkAccessManager>          m_pclNetworkAccess;
     std::unique_ptr<class CoverDownloader>                m_pclCoverDownloader;
+    QFutureWatcher<QImage>                                m_clCoverPreview;
     std::map<QString,std::shared_ptr<OnlineSourceParser>> m_mapParsers;
     std::map<QString,bool>                                m_mapParserEnabled;
     QString m_strArtist, m_strAlbum, m_strTrackTitle;
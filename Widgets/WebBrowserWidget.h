@@ -4,6 +4,7 @@
 #include <QWidget>
 #include <memory>
 #include <QUrl>
+#include <Tools/CoverImage.h>
 
 namespace Ui {
 class WebBrowserWidget;
@@ -21,7 +22,7 @@ public slots:
     void showURL( QUrl );
     
 signals:
-    void setCover( const QPixmap& );
+    void setCover( const CoverImage& );
     void parseURL( const QUrl& );
     
 protected slots: